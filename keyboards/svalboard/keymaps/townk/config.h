@@ -23,8 +23,26 @@
 // it the override doesn't work)
 #define VIAL_UNLOCK_COUNTER_MAX 12
 
+// High-resolution scrolling (POINTING_DEVICE_HIRES_SCROLL_ENABLE) stays off.
+// Svalboard's keyboard-level pointing code turns the scroll ball into whole
+// h/v ticks before pointing_device_task_combined_user() runs, so the
+// fractional stage in townk_pointing.c never sees its x/y; with high
+// resolution on, each of those ticks would be 1/120 of a notch.
+
+// Flight recorder of MB_*, modifier, SM_TD and layer decisions, read with
+// `tools/townk_hid.py trace` (see townk_trace.h). 2 KiB of RAM.
+#define TOWNK_TRACE_ENABLE
+
+// Press-to-report latency histograms for the layer-taps and MB_* keys, read
+// with `tools/townk_hid.py latency` (see townk_latency.h)
+#define TOWNK_LATENCY_ENABLE
+
 // sm_td
 #define SMTD_GLOBAL_SEQUENCE_TERM 100
 #define SMTD_GLOBAL_RELEASE_TERM 15
 
+// Room in EEPROM for the userspace settings that do not fit the 32-bit user
+// word: the tap terms learned per SM_TD key (see townk_eeconfig.h)
+#define EECONFIG_USER_DATA_SIZE 64
+
 #endif  // QMK_USERSPACE_TOWNK_SVALBOARD_CONFIG_H
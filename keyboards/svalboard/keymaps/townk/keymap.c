@@ -21,15 +21,16 @@
 
 #include QMK_KEYBOARD_H
 #include "quantum_keycodes.h"
+#include "townk_eeconfig.h"
 #include "townk_layers.h"
 #include "townk_keycodes.h"
 #include "townk_mouse.h"
 #include "townk_overrides.h"
+#include "townk_record.h"
+#include "townk_smtd.h"
 
 #include "sm_td.h"
 
-extern void mouse_mode(bool on);
-
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
  * DISCLAIMER                                                                *
  * ----------                                                                *
@@ -613,7 +614,7 @@ const uint16_t PROGMEM keymaps[DYNAMIC_KEYMAP_LAYER_COUNT][MATRIX_ROWS][MATRIX_C
      *                                                      ┊
      *                                    LT (Left Thumbs)  ┊  RT (Right Thumbs)
      *                                   ╭─────╭────╮─────╮ ┊ ╭─────╭────╮─────╮
-     *                                   │⌫|⌦|➊││3󰓾││ ⇥|➌ │ ┊ │ ⇤|➍ ││5󰓾││ ␣|➋ │
+     *                                   │  ⛛  ││3󰓾││  ⛛  │ ┊ │  ⛛  ││5󰓾││  ⛛  │
      *                                   ╰─────│╰──╯│─────╯ ┊ ╰─────│╰──╯│─────╯
      *                                     │ ⌥ │    │─────╮ ┊ ╭─────│    │ ⎋ │
      *                                     ╰───│ ⇧  │  ➎  │ ┊ │  ➏  │ ⏎  │───╯
@@ -632,24 +633,13 @@ const uint16_t PROGMEM keymaps[DYNAMIC_KEYMAP_LAYER_COUNT][MATRIX_ROWS][MATRIX_C
         /*L4*/ _______,  _______,  _______,  _______,    _______,  MB_CTL,
 
         /*     Down      Pad       Up        Nail        Knuckle   Double Down   */
-        /* The SM_TD keys here (CKC_SPC, CKC_BKTAB, and CKC_BSPC/CKC_TAB below)
-         * MUST be spelled out, never left transparent — they are load-bearing,
-         * not redundant copies of _BASE.
-         *
-         * smtd_current_keycode() reads keymap_key_to_keycode(get_highest_layer(
-         * layer_state), key): the highest active layer ONLY, with no
-         * transparency resolution. Whenever mouse mode is on, that layer is
-         * this one — so a _______ here hands SM_TD KC_TRANSPARENT instead of
-         * the real keycode, and it can no longer match the key to its own
-         * state. Symptoms: the first press is swallowed, and the layer-tap
-         * hold needs a deliberate pause before it engages.
-         *
-         * Consequence, accepted: while the left thumb pad holds _NAV open with
-         * mouse mode on, _MBO outranks _NAV and this Pad is Space rather than
-         * _NAV's Tab. Transparency is the only thing that would defer to _NAV,
-         * and it is unusable here. */
-        /*RT*/ _______,  CKC_SPC,  KC_ESC,   CKC_BKTAB,  _______,  SV_SNIPER_5,
-        /*LT*/ KC_LSFT,  CKC_BSPC, ML_CMD,   CKC_TAB,    _______,  SV_SNIPER_3
+        /* The SM_TD thumb keys (Space, Back-tab, Backspace, Tab) are
+         * transparent: sm_td reads them through the keycode cache
+         * (townk_keycache.h), which resolves _______ the way QMK does. So
+         * while the left thumb pad holds _NAV open with mouse mode on, this
+         * Pad is _NAV's Tab, not Space. */
+        /*RT*/ _______,  _______,  KC_ESC,   _______,    _______,  SV_SNIPER_5,
+        /*LT*/ KC_LSFT,  _______,  ML_CMD,   _______,    _______,  SV_SNIPER_3
         )
 };
 
@@ -671,6 +661,8 @@ const uint16_t PROGMEM keymaps[DYNAMIC_KEYMAP_LAYER_COUNT][MATRIX_ROWS][MATRIX_C
  *       svalboard.c
  *
  * @see keyboard_post_init_kb() in svalboard.c for EEPROM loading.
+ * @see townk_eeconfig_init() in townk_eeconfig.c for this userspace's own
+ *      EEPROM settings.
  * @see setup_rgb_light_layer() in townk_layers.c for initialization of the RGB
  *      layer system.
  */
@@ -759,10 +751,21 @@ void keyboard_post_init_user(void) {
      */
     global_saved_values.mh_timer_index = MOUSE_LAYER_TIMEOUT_NONE;
 
+    townk_eeconfig_init();
     setup_rgb_light_layer();
     setup_dynamic_keymap();
 }
 
+/**
+ * @brief User-level housekeeping hook, run once per main loop iteration
+ *
+ * Commits settings the userspace learned at runtime (the MB_* drag
+ * threshold) to EEPROM, rate limited by townk_eeconfig_task().
+ */
+void housekeeping_task_user(void) {
+    townk_eeconfig_task();
+}
+
 /**
  * @brief User-level key event processing hook
  *
@@ -771,14 +774,18 @@ void keyboard_post_init_user(void) {
  * intercepting and potentially handling keys before they reach the standard
  * QMK processing pipeline.
  *
- * The function currently delegates all key processing to the special mouse
- * keys handler, which implements dual-function modifier/mouse button behavior
- * for certain keys (MB_SFT, MB_ALT, MB_GUI, MB_CTL).
+ * The function delegates all key processing to the userspace pipeline,
+ * process_record_townk(), so the host fuzz target and benchmark run the
+ * stages in the same order the board does.
  *
  * **Processing Flow:**
- * 1. Check if the key is a special mouse button key.
- * 2. If handled by special mouse keys, stop further processing.
- * 3. Otherwise, allow standard QMK processing to continue.
+ * 1. On a game layer, resolve opposite keys (process_socd()) and hand the
+ *    rest straight to QMK (game_mode_fast_path()).
+ * 2. Stamp the press for the latency histograms and the typing streak.
+ * 3. Let sm_td consume the key, unless Repeat Key is replaying it.
+ * 4. Leave mouse mode on Escape.
+ * 5. Check if the key is a special mouse button key; if handled, stop.
+ * 6. Otherwise, allow standard QMK processing to continue.
  *
  * @param keycode The keycode that was pressed or released.
  * @param record Pointer to the key event record containing:
@@ -796,30 +803,9 @@ void keyboard_post_init_user(void) {
  *       pressed and released. Modules in this userspace can add their own
  *       behavior that is controlled by the QMK firmware automatically.
  *
+ * @see process_record_townk() in townk_record.c for the stages and their order.
  * @see process_special_mouse_keys() in townk_mouse.c for special key handling.
  */
 bool process_record_user(uint16_t keycode, keyrecord_t *record) {
-    /* sm_td runs here, manually, instead of as a community module — the module
-     * hook offers no way to shield Repeat Key from it. Since 0.5.6 sm_td
-     * consumes every record and re-resolves it by matrix POSITION; Repeat
-     * Key's replays carry the last keycode but QK_REP's own position, so
-     * sm_td turned every replay back into QK_REP, which Repeat Key's
-     * recursion guard then swallowed — repeat produced nothing at all.
-     * get_repeat_key_count() is nonzero exactly while a replayed record is
-     * in flight; letting those records pass sm_td untouched makes them
-     * register natively, as they did before 0.5.6.
-     *
-     * Order matters: sm_td must run before the handlers below so that real
-     * presses are consumed here (as the module used to) and the ESC hook and
-     * mouse-keys engine keep seeing only sm_td's emulated replays. */
-    if (get_repeat_key_count() == 0 && !process_smtd(keycode, record)) {
-        return false;
-    }
-    if (keycode == KC_ESC) {
-        mouse_mode(false);
-    }
-    if (!process_special_mouse_keys(keycode, record)) {
-        return false;
-    }
-    return true;
+    return process_record_townk(keycode, record);
 }
@@ -0,0 +1,107 @@
+#!/usr/bin/env python3
+"""Run the host throughput benchmark for the userspace hot path.
+
+    python3 tests/run_bench.py            # measure, compare to the baseline
+    python3 tests/run_bench.py --save     # measure, and make that the baseline
+
+Compiles tests/townk_bench.c -- the real townk_mouse.c, townk_mods.c,
+townk_smtd.c and townk_layers.c behind the same stubs the test suite uses --
+with optimisation on, replays a fixed, seeded stream of millions of key, SM_TD,
+pointing, layer and modifier-claim events, and reports the cost per event of
+each entry point.
+
+The baseline is a JSON file of ns/event per entry point. Nanoseconds only
+compare on the machine and compiler that produced them, so it lives next to
+this script but is not tracked: save one before starting a change, then rerun
+after. Any entry point slower than its baseline by more than the tolerance
+fails the run, exiting non-zero so it can gate a commit.
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+
+import townk_build
+
+TESTS = os.path.dirname(os.path.abspath(__file__))
+REPO = os.path.abspath(os.path.join(TESTS, ".."))
+BASELINE = os.path.join(TESTS, "bench_baseline.json")
+
+
+def build() -> str:
+    """Compile the benchmark and return the path of the executable."""
+    src = os.path.join(TESTS, "townk_bench.c")
+    exe = os.path.join(TESTS, "townk_bench")
+
+    # The fixture's flags (see townk_build.py), plus optimisation: an
+    # unoptimised benchmark measures the compiler, not the code.
+    try:
+        townk_build.build(exe, src, "-O2")
+    except RuntimeError as e:
+        sys.exit(str(e))
+
+    return exe
+
+
+def measure(exe: str, events: int) -> dict[str, float]:
+    """Run the benchmark once and return ns/event per entry point."""
+    out = subprocess.run([exe, str(events)], check=True, stdout=subprocess.PIPE)
+    results = json.loads(out.stdout)
+    return {name: float(r["ns_per_event"]) for name, r in results.items()}
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("--save", action="store_true",
+                        help="write this run as the new baseline")
+    parser.add_argument("--events", type=int, default=2_000_000,
+                        help="events per entry point (default: 2000000)")
+    parser.add_argument("--tolerance", type=float, default=0.20,
+                        help="allowed slowdown as a fraction (default: 0.20)")
+    parser.add_argument("--slack-ns", type=float, default=2.0,
+                        help="absolute slack, so tiny costs do not fail on "
+                             "timer noise (default: 2.0)")
+    args = parser.parse_args()
+
+    results = measure(build(), args.events)
+
+    baseline: dict[str, float] = {}
+    if os.path.exists(BASELINE):
+        with open(BASELINE) as f:
+            baseline = {k: float(v) for k, v in json.load(f).items()}
+
+    failed = False
+    print(f"{'entry point':<30} {'ns/event':>10} {'baseline':>10} {'change':>8}")
+    for name, ns in results.items():
+        base = baseline.get(name)
+        if base is None:
+            print(f"{name:<30} {ns:>10.2f} {'-':>10} {'-':>8}")
+            continue
+
+        change = (ns - base) / base if base > 0 else 0.0
+        limit = base * (1 + args.tolerance) + args.slack_ns
+        verdict = "  SLOWER" if ns > limit else ""
+        failed = failed or ns > limit
+        print(f"{name:<30} {ns:>10.2f} {base:>10.2f} {change:>+8.1%}{verdict}")
+
+    if args.save:
+        with open(BASELINE, "w") as f:
+            json.dump(results, f, indent=2, sort_keys=True)
+            f.write("\n")
+        print(f"\nbaseline saved to {os.path.relpath(BASELINE, REPO)}")
+        return 0
+
+    if not baseline:
+        print("\nno baseline yet; rerun with --save to record one")
+    elif failed:
+        print(f"\nhot path regressed beyond {args.tolerance:.0%} "
+              f"(+{args.slack_ns} ns) of the baseline", file=sys.stderr)
+        return 1
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
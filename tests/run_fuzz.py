@@ -0,0 +1,91 @@
+#!/usr/bin/env python3
+"""Fuzz the userspace input pipeline against its stuck-state invariants.
+
+    python3 tests/run_fuzz.py                 # fuzz for 60 s
+    python3 tests/run_fuzz.py --time 600      # fuzz for ten minutes
+    python3 tests/run_fuzz.py crash-1234...   # replay a saved input
+
+Compiles tests/townk_fuzz.c -- the real townk_mouse.c, townk_mods.c,
+townk_smtd.c and townk_layers.c behind the same stubs the test suite uses --
+as a libFuzzer target with AddressSanitizer and UBSan, and runs it. Every
+input is a sequence of key, SM_TD, trackball, layer and timing events; after
+each one the target checks that nothing is left stuck once every key is up,
+and that auto_mouse survives the game layers.
+
+The corpus grows in tests/fuzz_corpus/ and is not tracked. A failing input
+is saved as tests/crash-<hash>; pass it back to this script to replay it.
+Without a clang that ships libFuzzer, the target is built with the
+sanitizers alone and fed seeded random inputs instead: slower to find
+anything, but the same invariants.
+"""
+
+import argparse
+import os
+import subprocess
+import sys
+
+import townk_build
+
+TESTS = os.path.dirname(os.path.abspath(__file__))
+CORPUS = os.path.join(TESTS, "fuzz_corpus")
+
+
+def build(standalone: bool) -> str | None:
+    """Compile the fuzz target; None if libFuzzer is not available."""
+    src = os.path.join(TESTS, "townk_fuzz.c")
+    exe = os.path.join(TESTS, "townk_fuzz_standalone" if standalone else "townk_fuzz")
+
+    # The fixture's flags (see townk_build.py). -O1 keeps the sanitizer
+    # reports readable.
+    sanitizers = "address,undefined" if standalone else "fuzzer,address,undefined"
+    options = ["-g", "-O1", "-fsanitize=" + sanitizers, "-fno-sanitize-recover=undefined"]
+    if standalone:
+        options.append("-DTOWNK_FUZZ_STANDALONE")
+
+    try:
+        townk_build.build(exe, src, *options)
+    except RuntimeError as e:
+        if not standalone:
+            return None
+        sys.exit(str(e))
+
+    return exe
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("inputs", nargs="*",
+                        help="saved inputs to replay instead of fuzzing")
+    parser.add_argument("--time", type=int, default=60,
+                        help="seconds to fuzz for (default: 60)")
+    parser.add_argument("--runs", type=int, default=2_000_000,
+                        help="random inputs to try without libFuzzer "
+                             "(default: 2000000)")
+    parser.add_argument("--standalone", action="store_true",
+                        help="skip libFuzzer even if clang has it")
+    args = parser.parse_args()
+
+    exe = None if args.standalone else build(standalone=False)
+    if exe is None:
+        if not args.standalone:
+            print("clang has no libFuzzer; falling back to random inputs",
+                  file=sys.stderr)
+        exe = build(standalone=True)
+        cmd = [exe] + args.inputs if args.inputs else [exe, "-runs", str(args.runs)]
+        return subprocess.run(cmd, cwd=TESTS).returncode
+
+    if args.inputs:
+        return subprocess.run([exe] + args.inputs).returncode
+
+    os.makedirs(CORPUS, exist_ok=True)
+    cmd = [
+        exe, CORPUS,
+        f"-max_total_time={args.time}",
+        "-artifact_prefix=" + TESTS + os.sep,
+        "-print_final_stats=1",
+    ]
+    return subprocess.run(cmd).returncode
+
+
+if __name__ == "__main__":
+    sys.exit(main())
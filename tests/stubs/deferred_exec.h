@@ -0,0 +1,16 @@
+/* Host-test stand-in for QMK's quantum/deferred_exec.h, with QMK's types.
+ * tests/townk_mouse_layout.c runs the tasks against the shim's virtual
+ * clock. Never compiled into firmware. */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef uint8_t deferred_token;
+#define INVALID_DEFERRED_TOKEN 0
+
+/* Return 0 to stop, or the delay in ms until the next run. */
+typedef uint32_t (*deferred_exec_callback)(uint32_t trigger_time, void *cb_arg);
+
+deferred_token defer_exec(uint32_t delay_ms, deferred_exec_callback callback, void *cb_arg);
+bool           cancel_deferred_exec(deferred_token token);
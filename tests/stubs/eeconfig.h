@@ -0,0 +1,11 @@
+/* Host-test stand-in for QMK's quantum/eeconfig.h: just the 32-bit user word
+ * and the user datablock, which the fixture backs with variables and write
+ * counters. Never compiled into firmware. */
+#pragma once
+
+#include <stdint.h>
+
+uint32_t eeconfig_read_user(void);
+void     eeconfig_update_user(uint32_t val);
+uint32_t eeconfig_read_user_datablock(void *data, uint32_t offset, uint32_t length);
+uint32_t eeconfig_update_user_datablock(const void *data, uint32_t offset, uint32_t length);
@@ -13,7 +13,8 @@
 #endif
 
 enum qmk_keycodes {
-    KC_NO   = 0x0000,
+    KC_NO          = 0x0000,
+    KC_TRANSPARENT = 0x0001,
 
     KC_A = 0x0004, KC_B, KC_C, KC_D, KC_E, KC_F, KC_G, KC_H, KC_I,
     KC_J, KC_K, KC_L, KC_M, KC_N, KC_O, KC_P, KC_Q, KC_R,
@@ -0,0 +1,8 @@
+/* Host-test stand-in for QMK's quantum/keymap_common.h: the keymap lookup
+ * townk_keycache.c reads. The fixture defines it over a keymap the tests
+ * fill in. Never compiled into firmware. */
+#pragma once
+
+#include <stdint.h>
+
+uint16_t keymap_key_to_keycode(uint8_t layer, keypos_t key);
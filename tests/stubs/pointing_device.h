@@ -0,0 +1,8 @@
+/* Host-test stand-in for QMK's quantum/pointing_device/pointing_device.h.
+ *
+ * townk_pointing.h includes it for report_mouse_t. Under test that type, and
+ * the pointing hooks, are defined by the fixture (tests/townk_mouse_layout.c)
+ * before any userspace source is included -- so this header only has to exist
+ * and stay empty. Never compiled into firmware.
+ */
+#pragma once
@@ -0,0 +1,12 @@
+/* Host-test stand-in for QMK's quantum/progmem.h. Never in firmware.
+ * On the RP2040 (as on the host) flash is ordinary addressable memory, so
+ * PROGMEM is empty and the readers are plain reads -- exactly what QMK's
+ * non-AVR progmem.h does. */
+#pragma once
+
+#include <string.h>
+
+#define PROGMEM
+#define pgm_read_byte(address) (*(const uint8_t *)(address))
+#define pgm_read_word(address) (*(const uint16_t *)(address))
+#define memcpy_P(dest, src, n) memcpy((dest), (src), (n))
@@ -0,0 +1,8 @@
+/* Host-test stand-in for QMK's quantum/repeat_key.h: the replay counter
+ * townk_record.c checks before handing a key to sm_td. The fixture defines
+ * it as always 0 -- the host never replays. Never compiled into firmware. */
+#pragma once
+
+#include <stdint.h>
+
+int8_t get_repeat_key_count(void);
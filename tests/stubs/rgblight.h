@@ -2,10 +2,10 @@
  *
  * townk_layers.h includes it for rgblight_segment_t, which the layer enum
  * declaration needs in scope, and townk_layers.c uses the layer-table
- * macros and rgblight_set_layer_state(). Nothing under test reads the RGB
- * state, so the segment type is real enough to initialize and everything
- * else is the thinnest declaration that links. Never compiled into
- * firmware.
+ * macros and rgblight_set_layer_state(). The segment type is real enough
+ * to initialize and everything else is the thinnest declaration that links;
+ * tests/townk_mouse_layout.c records what each segment shows. Never compiled
+ * into firmware.
  */
 #pragma once
 
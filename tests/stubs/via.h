@@ -0,0 +1,19 @@
+/* Host-test stand-in for QMK's quantum/via.h: the command and channel IDs of
+ * the custom-value commands, with QMK's values, which is all townk_hid.c
+ * uses. Never compiled into firmware. */
+#pragma once
+
+#include <stdint.h>
+
+enum via_command_id {
+    id_custom_set_value = 0x07,
+    id_custom_get_value = 0x08,
+    id_custom_save      = 0x09,
+    id_unhandled        = 0xFF,
+};
+
+enum via_channel_id {
+    id_custom_channel = 0,
+};
+
+void via_custom_value_command_user(uint8_t *data, uint8_t length);
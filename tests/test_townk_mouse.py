@@ -18,11 +18,12 @@ build, no flashing.
 
 import ctypes
 import os
-import subprocess
 import sys
 import unittest
 from typing import NamedTuple
 
+import townk_build
+
 REPO = os.path.abspath(os.path.join(os.path.dirname(__file__), ".."))
 SUBMODULE = os.path.join(REPO, "modules", "stasmarkin")
 
@@ -39,7 +40,6 @@ MOD_LCTL = 1 << 0
 MOD_LSFT = 1 << 1
 MOD_LALT = 1 << 2
 MOD_LGUI = 1 << 3
-MOD_MASK_SHIFT = (1 << 1) | (1 << 5)  # MOD_BIT(KC_LSFT) | MOD_BIT(KC_RSFT)
 
 
 class Event(NamedTuple):
@@ -56,24 +56,7 @@ def _build() -> ctypes.CDLL:
     ext = ".dylib" if sys.platform == "darwin" else ".so"
     lib_path = os.path.join(REPO, "tests", "libtownk_mouse" + ext)
 
-    cmd = [
-        "clang", "-shared", "-o", lib_path, "-fPIC", src,
-        "-I" + SUBMODULE,
-        "-I" + os.path.join(SUBMODULE, "sm_td"),  # townk_smtd.c includes "sm_td.h"
-        "-I" + os.path.join(REPO, "tests", "stubs"),
-        "-DSMTD_UNIT_TEST",
-        "-std=c11",
-        # -Werror on purpose: a warning in this firmware is a defect, and the
-        # host build is the cheapest place to catch one.
-        "-Wall", "-Wextra", "-Werror",
-        "-Wno-sign-compare", "-Wno-missing-braces", "-Wno-unused-parameter",
-    ]
-
-    result = subprocess.run(cmd, stderr=subprocess.PIPE)
-    if result.returncode != 0:
-        raise RuntimeError(
-            "failed to compile the test fixture:\n" + result.stderr.decode()
-        )
+    townk_build.build(lib_path, src, "-shared", "-fPIC")
 
     lib = ctypes.CDLL(lib_path)
 
@@ -82,9 +65,39 @@ def _build() -> ctypes.CDLL:
     lib.T_smtd_tap.argtypes = [ctypes.c_uint16, ctypes.c_uint8]
     lib.T_smtd_hold.argtypes = [ctypes.c_uint16, ctypes.c_uint8]
     lib.T_smtd_release.argtypes = [ctypes.c_uint16, ctypes.c_uint8]
-    # x/y are 16-bit (MOUSE_EXTENDED_REPORT, as on the Svalboard); h/v are not.
+    lib.T_matrix_press.argtypes = [ctypes.c_uint16]
+    lib.T_replay_press.argtypes = [ctypes.c_uint16]
+    lib.T_smtd_resolution.argtypes = [ctypes.c_uint16, ctypes.c_uint8]
+    lib.get_smtd_timeout.argtypes = [ctypes.c_uint16, ctypes.c_int]
+    lib.get_smtd_timeout.restype = ctypes.c_uint32
+    # x/y are 16-bit (MOUSE_EXTENDED_REPORT, as on the Svalboard), and so are
+    # h/v (WHEEL_EXTENDED_REPORT, which high-resolution scroll turns on).
     lib.T_pointing.argtypes = [ctypes.c_int16, ctypes.c_int16,
-                               ctypes.c_int8, ctypes.c_int8]
+                               ctypes.c_int16, ctypes.c_int16]
+    lib.T_pointing_combined.argtypes = [ctypes.c_int16, ctypes.c_int16,
+                                        ctypes.c_int16, ctypes.c_int16,
+                                        ctypes.c_int16, ctypes.c_int16,
+                                        ctypes.c_int16, ctypes.c_int16]
+    lib.T_set_left_scroll.argtypes = [ctypes.c_bool]
+    lib.T_pointing_combined_report.argtypes = [ctypes.c_int16, ctypes.c_int16,
+                                               ctypes.c_int16, ctypes.c_int16,
+                                               ctypes.c_int16, ctypes.c_int16,
+                                               ctypes.c_void_p, ctypes.c_void_p,
+                                               ctypes.c_void_p, ctypes.c_void_p]
+    lib.T_pointing_report.argtypes = [ctypes.c_int16, ctypes.c_int16,
+                                      ctypes.c_int16, ctypes.c_int16,
+                                      ctypes.c_void_p, ctypes.c_void_p,
+                                      ctypes.c_void_p, ctypes.c_void_p]
+    lib.mb_motion_get.argtypes = [ctypes.c_int, ctypes.c_int]
+    lib.mb_motion_get.restype = ctypes.c_uint16
+    lib.mb_motion_set.argtypes = [ctypes.c_int, ctypes.c_int, ctypes.c_uint16]
+    lib.mb_motion_set.restype = ctypes.c_bool
+    lib.T_eeprom_user.restype = ctypes.c_uint32
+    lib.T_power_up_with_eeprom_user.argtypes = [ctypes.c_uint32]
+    lib.via_custom_value_command_user.argtypes = [ctypes.c_void_p, ctypes.c_uint8]
+    lib.T_set_right_dpi.argtypes = [ctypes.c_uint8]
+    lib.T_accel_gain.argtypes = [ctypes.c_uint8, ctypes.c_uint32]
+    lib.T_accel_gain.restype = ctypes.c_uint16
     lib.T_set_external_mods.argtypes = [ctypes.c_uint8]
     lib.T_reset.argtypes = []
     lib.T_hold_backspace.argtypes = [ctypes.c_bool]
@@ -114,6 +127,19 @@ def _build() -> ctypes.CDLL:
     lib.T_auto_mouse.restype = ctypes.c_bool
     lib.T_set_auto_mouse.argtypes = [ctypes.c_bool]
     lib.T_mouse_mode_saw_auto_mouse.restype = ctypes.c_bool
+    lib.T_game_key.argtypes = [ctypes.c_uint8, ctypes.c_bool]
+    lib.T_game_key.restype = ctypes.c_bool
+    lib.is_caps_word_on.restype = ctypes.c_bool
+    lib.T_rgb_segment.argtypes = [ctypes.c_uint8]
+    lib.T_rgb_segment.restype = ctypes.c_bool
+    lib.T_rgb_writes.restype = ctypes.c_uint32
+    lib.T_keymap_set.argtypes = [ctypes.c_uint8, ctypes.c_uint8, ctypes.c_uint16]
+    lib.T_keymap_reads.restype = ctypes.c_uint32
+    lib.T_keycache_keycode.argtypes = [ctypes.c_uint8]
+    lib.T_keycache_keycode.restype = ctypes.c_uint16
+    lib.T_keycache_layer_keycode.argtypes = [ctypes.c_uint8, ctypes.c_uint8]
+    lib.T_keycache_layer_keycode.restype = ctypes.c_uint16
+    lib.T_default_layer_set.argtypes = [ctypes.c_uint8]
     # TEST_get_record_history deliberately has no argtypes: ctypes already
     # passes an array and a byref() correctly, and declaring them would mean
     # ctypes.POINTER(), which is deprecated.
@@ -131,25 +157,46 @@ LIB = _build()
 
 MB_GUI: int = int(LIB.T_kc_mb_gui())
 MB_SFT: int = int(LIB.T_kc_mb_sft())
-MB_ALT: int = int(LIB.T_kc_mb_alt())
 CKC_SPC: int = int(LIB.T_kc_ckc_spc())
 CKC_BSPC: int = int(LIB.T_kc_ckc_bspc())
 KC_DEL: int = int(LIB.T_kc_del())
-KC_BSPC: int = int(LIB.T_kc_bspc())
-MOD_RSFT = 1 << 5  # MOD_BIT(KC_RSFT); R1 double-south is a plain KC_RIGHT_SHIFT
 KC_BTN1: int = int(LIB.T_kc_btn1())
 KC_BTN2: int = int(LIB.T_kc_btn2())
 KC_BTN3: int = int(LIB.T_kc_btn3())
+KC_BTN5: int = int(LIB.T_kc_btn5())
 KC_PLAIN: int = int(LIB.T_kc_plain())
 
-MOUSE_BUTTONS = (KC_BTN1, KC_BTN2, KC_BTN3)
+MOUSE_BUTTONS = (KC_BTN1, KC_BTN2, KC_BTN3, KC_BTN5)
 LAYER_NAV: int = int(LIB.T_layer_nav())
 LAYER_MBO: int = int(LIB.T_layer_mbo())
 LAYER_GAM1: int = int(LIB.T_layer_gam1())
 LAYER_BASE: int = int(LIB.T_layer_base())
 
 
+def recorded_history() -> list[Event]:
+    """Every event the engine emitted since the last reset."""
+    records = (CHistory * MAX_HISTORY)()
+    count = ctypes.c_uint8()
+    LIB.TEST_get_record_history(records, ctypes.byref(count))
+    return [
+        Event(
+            keycode=int(records[i].keycode),
+            pressed=bool(records[i].pressed),
+            mods=int(records[i].mods),
+        )
+        for i in range(count.value)
+    ]
+
+
 class TownkMouseTest(unittest.TestCase):
+    """What the MB_* engine does to the reports the host receives.
+
+    The engine's gestures -- which role a key resolves to, and the events and
+    modifiers that follow -- are event scripts, and live in
+    tests/scenarios/*.scn, run natively by test_townk_scenarios.py. What is
+    left here reads the pointing report back, which a script cannot.
+    """
+
     def setUp(self) -> None:
         LIB.TEST_reset()  # sm_td state + recorded history
         LIB.T_reset()     # mb_states, mouse-mode counters, mods
@@ -164,20 +211,7 @@ class TownkMouseTest(unittest.TestCase):
 
     def history(self) -> list[Event]:
         """Every event the engine emitted since the last reset."""
-        records = (CHistory * MAX_HISTORY)()
-        count = ctypes.c_uint8()
-        LIB.TEST_get_record_history(records, ctypes.byref(count))
-        return [
-            Event(
-                keycode=int(records[i].keycode),
-                pressed=bool(records[i].pressed),
-                mods=int(records[i].mods),
-            )
-            for i in range(count.value)
-        ]
-
-    def mods(self) -> int:
-        return int(LIB.get_mods())
+        return recorded_history()
 
     def assertNoMouseButton(self, msg: str) -> None:
         for event in self.history():
@@ -185,624 +219,1009 @@ class TownkMouseTest(unittest.TestCase):
                 event.keycode, MOUSE_BUTTONS, f"{msg}: unexpected {event}"
             )
 
-    # -- the role each key resolves to ------------------------------------
+    # -- motion withheld from the host while a key is undecided -----------
+
+    def test_drag_starts_where_the_motion_began(self) -> None:
+        """The counts that earned the drag arrive after the button-down.
 
-    def test_tap_alone_sends_a_mouse_button(self) -> None:
-        """Pressed and released with nothing else: a mouse click."""
+        Sub-threshold motion under an undecided key is withheld from the
+        host; when the drag is confirmed, the button goes down first and the
+        withheld counts follow, so the drag begins at the original position.
+        (DPI 200, where slow motion has a gain of exactly 1.0.)
+        """
+        LIB.T_set_right_dpi(MOUSE_DPI_200)
         LIB.T_key(MB_GUI, True)
+
+        self.assertEqual(pointing_report(3, 0).x, 0, "withheld: not a drag yet")
+        self.assertEqual(pointing_report(3, 0).x, 0, "still withheld")
+        self.assertNoMouseButton("6 counts is not a drag")
+
+        out = pointing_report(3, 0)  # 9 counts: a drag
+        self.assertEqual(self.history(), [Event(KC_BTN3, pressed=True, mods=0)],
+                         "the button is down before the replay is sent")
+        self.assertGreaterEqual(out.x, 9, "all nine counts, from where it began")
+
+        self.assertEqual(pointing_report(3, 0).x, 3, "then motion flows as usual")
         LIB.T_key(MB_GUI, False)
 
-        self.assertEqual(
-            self.history(),
-            [
-                Event(KC_BTN3, pressed=True, mods=0),
-                Event(KC_BTN3, pressed=False, mods=0),
-            ],
-        )
+    def test_withheld_motion_follows_a_click(self) -> None:
+        """Motion held back for a key that became a click is not lost."""
+        LIB.T_set_right_dpi(MOUSE_DPI_200)
+        LIB.T_key(MB_GUI, True)
+        self.assertEqual(pointing_report(3, 0).x, 0)
+        LIB.T_key(MB_GUI, False)
 
-    def test_press_alone_commits_to_nothing(self) -> None:
-        """The key is a BUTTON first: pressing it must claim no modifier.
+        self.assertEqual([e.keycode for e in self.history()], [KC_BTN3, KC_BTN3],
+                         "the click lands where the key went down")
+        self.assertEqual(pointing_report(0, 0).x, 3, "then the pointer catches up")
 
-        The modifier is the exceptional role and has to be earned by something
-        happening afterwards. Registering it up-front is what forced the old
-        design to prove a negative at release time -- "nothing contradicted
-        me" -- which it could only do by observing every other keypress, and
-        it could not observe the ones SM_TD consumed.
-        """
+    def test_quiet_gap_releases_withheld_motion(self) -> None:
+        """A slow drift under a held key never freezes the pointer."""
+        LIB.T_set_right_dpi(MOUSE_DPI_200)
         LIB.T_key(MB_GUI, True)
+        self.assertEqual(pointing_report(3, 0).x, 0)
 
-        self.assertEqual(self.mods(), 0, "no modifier may be claimed on press")
-        self.assertEqual(self.history(), [], "and nothing may be emitted yet")
+        LIB.TEST_advance_time(100)  # > MB_MOVE_RESET_MS: that was not a drag
+        self.assertEqual(pointing_report(1, 0).x, 3,
+                         "the old blip moves the pointer, the new one waits")
+        self.assertNoMouseButton("and nothing added up to a drag")
 
         LIB.T_key(MB_GUI, False)
 
-    def test_ordinary_key_makes_it_a_modifier(self) -> None:
-        """Another key pressed while held: a modifier, and NO click."""
+    def test_slow_travel_is_withheld_for_one_threshold_only(self) -> None:
+        """A drag too slow to convert lags the hand, it does not freeze."""
+        LIB.T_set_right_dpi(MOUSE_DPI_200)
         LIB.T_key(MB_GUI, True)
 
-        LIB.T_key(KC_PLAIN, True)
-        self.assertEqual(
-            self.mods(), MOD_LGUI,
-            "Cmd must be held by the time the other key is emitted",
-        )
+        out = []
+        for _ in range(6):  # 2 counts every 20 ms: 100 counts/s, too slow
+            out.append(pointing_report(2, 0).x)
+            LIB.TEST_advance_time(20)
+        self.assertEqual(out[:3], [0, 0, 0], "held back up to the threshold")
+        self.assertGreaterEqual(out[3], 8, "then all of it at once")
+        self.assertEqual(out[4:], [2, 2], "and the rest flows as it comes")
+        self.assertNoMouseButton("slow travel is not a drag")
 
-        LIB.T_key(KC_PLAIN, False)
         LIB.T_key(MB_GUI, False)
 
-        self.assertNoMouseButton("a key used as a modifier must not also click")
 
-    def test_smtd_key_makes_it_a_modifier(self) -> None:
-        """Regression test for 3b82f67 -- the phantom middle click.
+class Report(NamedTuple):
+    """What the host receives for one pointing report."""
 
-        An SM_TD key (CKC_SPC) reaches on_smtd_action() and never
-        process_record_user(), so before the fix the held MB_* key never
-        learned it had been used as a modifier and fired a bare mouse-button
-        tap on release. That stray click was a real click to the OS: it pasted
-        in any app bound to middle-click paste, and opened context menus over
-        the Dock.
-        """
-        LIB.T_key(MB_GUI, True)
+    x: int
+    y: int
+    h: int
+    v: int
 
-        LIB.T_smtd_touch(CKC_SPC)  # Cmd+Space -- never reaches process_record_user
-        self.assertEqual(
-            self.mods(), MOD_LGUI, "Cmd must be held for the Space that follows"
-        )
 
-        LIB.T_key(MB_GUI, False)
+def pointing_report(x: int, y: int, h: int = 0, v: int = 0) -> Report:
+    """Run one report through pointing_device_task_kb() and return it."""
+    out_x, out_y = ctypes.c_int16(), ctypes.c_int16()
+    out_h, out_v = ctypes.c_int16(), ctypes.c_int16()
+    LIB.T_pointing_report(x, y, h, v, ctypes.byref(out_x), ctypes.byref(out_y),
+                          ctypes.byref(out_h), ctypes.byref(out_v))
+    return Report(out_x.value, out_y.value, out_h.value, out_v.value)
 
-        self.assertNoMouseButton("Cmd+Space must not emit a phantom click")
-        self.assertEqual(self.history(), [], "no events at all should be emitted")
 
-    def test_pointer_movement_converts_to_a_held_button(self) -> None:
-        """Trackball motion while held: becomes a held button, for dragging."""
-        LIB.T_key(MB_GUI, True)
-        LIB.T_pointing(5, 5, 0, 0)
+MOUSE_DPI_200 = 0
+MOUSE_DPI_1200 = 3
+ACCEL_ONE = 256
 
-        self.assertEqual(self.mods(), 0, "the modifier must be given up")
-        self.assertEqual(self.history(), [Event(KC_BTN3, pressed=True, mods=0)])
 
-        LIB.T_key(MB_GUI, False)
-        self.assertEqual(self.history()[-1], Event(KC_BTN3, pressed=False, mods=0))
+class TownkPointerAccelTest(unittest.TestCase):
+    """The pointer acceleration stage in townk_pointing.c."""
 
-    def test_fast_flick_in_one_extended_report_converts(self) -> None:
-        """A single 256-count report is a deliberate drag, not silence.
+    def setUp(self) -> None:
+        LIB.TEST_reset()
+        LIB.T_reset()
 
-        The Svalboard defines MOUSE_EXTENDED_REPORT, so a report's x/y are
-        int16_t and a fast flick (or a delayed task tick accumulating PMW3389
-        counts) can arrive as one large report. Narrowing it to int8_t on the
-        way into the motion test folds 256 to 0 -- a real drag reads as no
-        motion at all, and the accumulated distance of sub-multiples is
-        miscounted (200 becomes -56).
+    def test_slow_motion_is_slowed_but_never_lost(self) -> None:
+        """A stream of one-count reports keeps its fraction between reports.
+
+        At a gain below 1.0 each report alone rounds to nothing; carrying the
+        remainder is what turns a slow, precise roll into slow, precise
+        pointer motion instead of no motion at all.
         """
-        LIB.T_key(MB_GUI, True)
-        LIB.T_pointing(256, 0, 0, 0)
+        gain = int(LIB.T_accel_gain(MOUSE_DPI_1200, 1))
+        self.assertLess(gain, ACCEL_ONE, "slow motion must be decelerated")
+
+        total = sum(pointing_report(1, 0).x for _ in range(100))
+        self.assertEqual(total, 100 * gain // ACCEL_ONE, "no count may be lost")
+
+    def test_fast_motion_is_accelerated(self) -> None:
+        """A flick travels further than its raw counts."""
+        out = pointing_report(40, 0)
+        self.assertGreater(out.x, 40)
+        self.assertEqual(out.y, 0, "an axis that did not move stays still")
 
-        self.assertEqual(
-            self.history(), [Event(KC_BTN3, pressed=True, mods=0)],
-            "a 256-count report is far past the threshold and must convert",
+    def test_both_directions_scale_the_same(self) -> None:
+        """Left and right must feel identical."""
+        right = sum(pointing_report(3, 0).x for _ in range(20))
+        LIB.T_reset()
+        left = sum(pointing_report(-3, 0).x for _ in range(20))
+        self.assertEqual(left, -right)
+
+    def test_reversal_drops_the_stale_fraction(self) -> None:
+        """A half-count owed to the right must not push a leftward move."""
+        pointing_report(1, 0)  # leaves a fraction owed to the right
+        out = pointing_report(-1, 0)
+        self.assertLessEqual(out.x, 0)
+
+    def test_curve_follows_the_dpi_index(self) -> None:
+        """Each DPI setting has its own row; low DPI needs less slowing."""
+        self.assertGreater(
+            int(LIB.T_accel_gain(MOUSE_DPI_200, 1)),
+            int(LIB.T_accel_gain(MOUSE_DPI_1200, 1)),
         )
 
-        LIB.T_key(MB_GUI, False)
+    def test_scroll_passes_through(self) -> None:
+        """Acceleration is for the pointer; the wheel is untouched."""
+        self.assertEqual(pointing_report(0, 0, 1, -1), Report(0, 0, 1, -1))
 
-    def test_resting_jitter_does_not_convert(self) -> None:
-        """A one-count blip is a resting hand, not a drag.
 
-        The hand resting on the ball emits sparse tiny reports. Before the
-        motion threshold, each one converted a held key to its button on the
-        spot: holding Cmd while touching the ball produced a middle click.
-        The key must stay undecided, so releasing it is still a plain click.
-        """
-        LIB.T_key(MB_GUI, True)
-        LIB.T_pointing(1, 0, 0, 0)
+def scroll_report(lx: int, ly: int, rx: int = 0, ry: int = 0,
+                  lh: int = 0, lv: int = 0) -> Report:
+    """Run one scan of both balls through the hooks and return the merge."""
+    out_x, out_y = ctypes.c_int16(), ctypes.c_int16()
+    out_h, out_v = ctypes.c_int16(), ctypes.c_int16()
+    LIB.T_pointing_combined_report(lx, ly, lh, lv, rx, ry,
+                                   ctypes.byref(out_x), ctypes.byref(out_y),
+                                   ctypes.byref(out_h), ctypes.byref(out_v))
+    return Report(out_x.value, out_y.value, out_h.value, out_v.value)
 
-        self.assertNoMouseButton("a jitter blip must not press a button")
-        self.assertEqual(self.mods(), 0, "nor claim the modifier")
 
-        LIB.T_key(MB_GUI, False)
-        self.assertEqual(
-            self.history(),
-            [
-                Event(KC_BTN3, pressed=True, mods=0),
-                Event(KC_BTN3, pressed=False, mods=0),
-            ],
-            "released with nothing earned, the key is still a click",
-        )
+# The fixture's POINTING_DEVICE_HIRES_SCROLL_MULTIPLIER, and townk_pointing.c's
+# defaults for the rest.
+SCROLL_UNITS_PER_TICK = 120
+SCROLL_COUNTS_PER_TICK = 16
+SCROLL_MIN_UNITS = SCROLL_UNITS_PER_TICK // 8
+SCROLL_COALESCE_MS = 16
 
-    def test_sparse_jitter_never_accumulates(self) -> None:
-        """Blips separated by quiet gaps reset the accumulator.
 
-        Four two-count blips total 8 -- enough to cross the threshold if they
-        merely added up. They must not: a quiet gap longer than
-        MB_MOVE_RESET_MS forgets the distance, so resting on the ball for a
-        long time is no closer to a drag than touching it once.
-        """
-        LIB.T_key(MB_GUI, True)
-        for _ in range(4):
-            LIB.T_pointing(2, 0, 0, 0)
-            LIB.TEST_advance_time(100)  # > MB_MOVE_RESET_MS: goes quiet
+class TownkScrollTest(unittest.TestCase):
+    """The high-resolution scroll stage in townk_pointing.c.
 
-        self.assertNoMouseButton("sparse jitter must never become a drag")
+    The left ball is the scroll ball (left_scroll, this keymap's default);
+    its x/y become h/v in 1/120ths of a notch.
+    """
 
-        LIB.T_key(MB_GUI, False)
+    def setUp(self) -> None:
+        LIB.TEST_reset()
+        LIB.T_reset()
 
-    def test_slow_dense_motion_still_converts(self) -> None:
-        """A slow but continuous drag crosses the threshold and converts.
+    def test_wheel_ticks_from_the_keyboard_pass_through(self) -> None:
+        """On the Svalboard the scroll ball arrives as h/v already."""
+        self.assertEqual(scroll_report(0, 0, lh=-1, lv=2), Report(0, 0, -1, 2))
 
-        Per-report distance depends on CPI and polling rate, so a deliberate
-        precision drag may only produce a few counts per report. What makes
-        it deliberate is density: back-to-back reports with no quiet gap.
-        """
-        LIB.T_key(MB_GUI, True)
-        LIB.T_pointing(3, 0, 0, 0)
-        LIB.T_pointing(3, 0, 0, 0)
-        self.assertNoMouseButton("6 counts is still below the threshold")
+    def test_travel_becomes_high_resolution_wheel_motion(self) -> None:
+        """A notch worth of travel is a notch worth of wheel units."""
+        out = scroll_report(0, -SCROLL_COUNTS_PER_TICK)
+        self.assertEqual(out, Report(0, 0, 0, SCROLL_UNITS_PER_TICK),
+                         "ball up scrolls up, and moves no pointer")
 
-        LIB.T_pointing(3, 0, 0, 0)  # 9 counts: deliberate
-        self.assertEqual(self.history(), [Event(KC_BTN3, pressed=True, mods=0)])
+        out = scroll_report(SCROLL_COUNTS_PER_TICK, 0)
+        self.assertEqual(out.h, SCROLL_UNITS_PER_TICK, "ball right scrolls right")
 
-        LIB.T_key(MB_GUI, False)
-        self.assertEqual(self.history()[-1], Event(KC_BTN3, pressed=False, mods=0))
+    def test_small_contributions_are_coalesced(self) -> None:
+        """One count is half a report's worth; two make one report."""
+        first = scroll_report(0, -1)
+        self.assertEqual(first.v, 0, "too small to be worth a report alone")
 
-    def test_scroll_with_motion_noise_is_a_scroll(self) -> None:
-        """Sub-threshold x/y riding on a scroll report resolves as scroll.
+        second = scroll_report(0, -1)
+        self.assertEqual(second.v, 2 * SCROLL_UNITS_PER_TICK // SCROLL_COUNTS_PER_TICK,
+                         "sent together with the next one")
 
-        Motion only outranks scroll once it is deliberate. A wiggle of the
-        resting hand during Cmd+scroll must keep the zoom, not turn it into
-        a middle-button drag.
-        """
-        LIB.T_key(MB_GUI, True)
-        LIB.T_pointing(1, 0, 3, 3)
+    def test_held_back_scroll_is_flushed_on_time(self) -> None:
+        """A lone small amount goes out once it has waited long enough."""
+        scroll_report(0, -1)
+        LIB.TEST_advance_time(SCROLL_COALESCE_MS - 1)
+        self.assertEqual(scroll_report(0, 0).v, 0, "still waiting for company")
 
-        self.assertEqual(self.mods(), MOD_LGUI, "the scroll claims the modifier")
-        self.assertNoMouseButton("the wiggle must not press a button")
+        LIB.TEST_advance_time(1)
+        self.assertEqual(scroll_report(0, 0).v,
+                         SCROLL_UNITS_PER_TICK // SCROLL_COUNTS_PER_TICK,
+                         "an idle scan delivers it")
 
-        LIB.T_key(MB_GUI, False)
-        self.assertNoMouseButton("releasing after the scroll must not click")
+    def test_slow_scrolling_loses_no_motion(self) -> None:
+        """However the travel is sliced, the host gets all of it."""
+        total = 0
+        for _ in range(100):
+            total += scroll_report(0, -1).v
+            LIB.TEST_advance_time(3)
+        LIB.TEST_advance_time(SCROLL_COALESCE_MS)
+        total += scroll_report(0, 0).v
 
-    def test_external_modifier_makes_it_a_button(self) -> None:
-        """Pressed while another modifier is already down: a mouse button."""
-        LIB.T_set_external_mods(MOD_LSFT)
+        self.assertEqual(total, 100 * SCROLL_UNITS_PER_TICK // SCROLL_COUNTS_PER_TICK)
 
-        LIB.T_key(MB_GUI, True)
-        self.assertEqual(
-            self.history(), [Event(KC_BTN3, pressed=True, mods=MOD_LSFT)]
-        )
+    def test_reports_carry_at_least_the_minimum(self) -> None:
+        """Coalescing means no report dribbles out a single unit."""
+        reports = [scroll_report(0, -1).v for _ in range(50)]
+        self.assertTrue(all(v == 0 or v >= SCROLL_MIN_UNITS for v in reports),
+                        reports)
 
-        LIB.T_key(MB_GUI, False)
-        LIB.T_set_external_mods(0)  # release the stand-in for the real Shift key
+    def test_pointer_ball_is_not_scrolled(self) -> None:
+        """The right ball keeps moving the pointer alongside a scroll."""
+        out = scroll_report(0, -SCROLL_COUNTS_PER_TICK, 10, 0)
+        self.assertEqual(out.v, SCROLL_UNITS_PER_TICK)
+        self.assertNotEqual(out.x, 0)
 
-    def test_hold_alone_then_release_still_clicks(self) -> None:
-        """Duration alone decides nothing: a slow, deliberate click still clicks.
 
-        There is no tapping term here on purpose. Only a competing signal --
-        motion, scroll, another key -- can take the button role away, so a
-        held-then-released key with nothing else happening is a click no
-        matter how long it was held.
-        """
-        LIB.T_key(MB_GUI, True)
-        LIB.T_key(MB_GUI, False)
+MB_MOTION_THRESHOLD = 0
+MOTION_THRESHOLD_DEFAULT = 8
+EECONFIG_SAVE_INTERVAL_MS = 600_000
 
-        self.assertEqual(
-            self.history(),
-            [
-                Event(KC_BTN3, pressed=True, mods=0),
-                Event(KC_BTN3, pressed=False, mods=0),
-            ],
-        )
 
-    def test_scroll_resolves_to_a_modifier(self) -> None:
-        """Scrolling while held: a modifier, so Cmd+scroll stays zoom.
+JITTER_GAP_MS = 20  # a resting hand leaks the odd count, not a stream
 
-        Deliberately the opposite of pointer motion. Treating scroll as
-        movement would turn every Cmd+scroll-to-zoom into a middle-button
-        drag; leaving it unresolved would fire a stray click on release, which
-        is the same defect class as the phantom click on Cmd+Space.
-        """
-        LIB.T_key(MB_GUI, True)
-        LIB.T_pointing(0, 0, 3, 3)
 
-        self.assertEqual(self.mods(), MOD_LGUI, "scroll must claim the modifier")
-        self.assertEqual(self.history(), [], "and must not press a button")
+def jitter_burst(*xs: int, gap_ms: int = JITTER_GAP_MS) -> None:
+    """One burst of resting jitter on the pointer ball, then a quiet gap."""
+    for i, x in enumerate(xs):
+        if i:
+            LIB.TEST_advance_time(gap_ms)
+        LIB.T_pointing(x, 0, 0, 0)
+    LIB.TEST_advance_time(100)  # > MB_MOVE_RESET_MS: the burst is over
 
-        LIB.T_key(MB_GUI, False)
-        self.assertNoMouseButton("releasing after a scroll must not click")
 
-    def test_two_modifiers_then_click(self) -> None:
-        """Cmd+Option+click: two keys held as modifiers, a third clicks."""
-        LIB.T_key(MB_GUI, True)
-        LIB.T_key(MB_ALT, True)   # resolves MB_GUI -> Cmd
-        LIB.T_key(MB_SFT, True)   # resolves MB_ALT -> Option
-        self.assertEqual(
-            self.mods(), MOD_LGUI | MOD_LALT, "both modifiers must be held"
-        )
+def right_threshold() -> int:
+    return int(LIB.mb_motion_get(1, MB_MOTION_THRESHOLD))
 
-        LIB.T_key(MB_SFT, False)
-        self.assertEqual(
-            self.history(),
-            [
-                Event(KC_BTN1, pressed=True, mods=MOD_LGUI | MOD_LALT),
-                Event(KC_BTN1, pressed=False, mods=MOD_LGUI | MOD_LALT),
-            ],
-            "the click must carry both modifiers",
-        )
 
-        LIB.T_key(MB_ALT, False)
-        LIB.T_key(MB_GUI, False)
+class TownkCalibrationTest(unittest.TestCase):
+    """Online calibration of the drag threshold (townk_mouse.c) and its
+    persistence (townk_eeconfig.c)."""
+
+    def setUp(self) -> None:
+        LIB.TEST_reset()
+        LIB.T_reset()
+
+    def learn(self, *xs: int, bursts: int = 40) -> None:
+        for _ in range(bursts):
+            jitter_burst(*xs)
+        LIB.T_pointing(0, 0, 0, 0)
+
+    def test_a_still_hand_gets_a_quicker_drag(self) -> None:
+        """Jitter that never exceeds 2 counts earns a threshold of 3."""
+        self.learn(1, -1)
+        LIB.T_pointing(1, 0, 0, 0)  # closes the last burst
+        LIB.TEST_advance_time(100)
+        self.assertEqual(right_threshold(), 3)
 
-    def test_two_modifiers_then_drag(self) -> None:
-        """Cmd+Option+drag: the same, with motion instead of a tap."""
         LIB.T_key(MB_GUI, True)
-        LIB.T_key(MB_ALT, True)
-        LIB.T_key(MB_SFT, True)
+        LIB.T_pointing(2, 0, 0, 0)
+        LIB.T_pointing(2, 0, 0, 0)  # 4 counts: under the default, over the learned
+        self.assertEqual(recorded_history(), [Event(KC_BTN3, pressed=True, mods=0)])
+        LIB.T_key(MB_GUI, False)
 
-        LIB.T_pointing(5, 5, 0, 0)
-        self.assertEqual(
-            self.mods(), MOD_LGUI | MOD_LALT,
-            "motion must not strip the modifiers off the other keys",
-        )
-        self.assertEqual(
-            self.history(),
-            [Event(KC_BTN1, pressed=True, mods=MOD_LGUI | MOD_LALT)],
-        )
+    def test_a_restless_hand_gets_a_higher_threshold(self) -> None:
+        """Jitter reaching 9 counts pushes the threshold above it."""
+        self.learn(2, -2, 2, -2, 1)
+        LIB.T_pointing(1, 0, 0, 0)
+        self.assertEqual(right_threshold(), 10)
 
-        LIB.T_key(MB_SFT, False)
-        LIB.T_key(MB_ALT, False)
+        LIB.TEST_advance_time(100)
+        LIB.T_key(MB_GUI, True)
+        for _ in range(3):
+            LIB.T_pointing(3, 0, 0, 0)  # 9 counts: a drag by default, not here
+        self.assertNotIn(KC_BTN3, [e.keycode for e in recorded_history()])
         LIB.T_key(MB_GUI, False)
 
-    # -- the shift-inverted Backspace / Delete thumb pad -------------------
+    def test_motion_under_a_held_key_teaches_nothing(self) -> None:
+        LIB.T_key(MB_GUI, True)
+        self.learn(2, -2, 2, -2, 1)
+        LIB.T_key(MB_GUI, False)
+        self.assertEqual(right_threshold(), MOTION_THRESHOLD_DEFAULT)
 
-    def test_plain_tap_sends_backspace(self) -> None:
-        """No shift: the pad is Backspace."""
-        LIB.T_smtd_touch(CKC_BSPC)
-        LIB.T_smtd_tap(CKC_BSPC, 0)
+    def test_a_stream_of_small_motion_teaches_nothing(self) -> None:
+        """A nudge reports every couple of ms: small, but not resting."""
+        for _ in range(40):
+            jitter_burst(2, 2, 2, 2, 2, 2, 2, 2, gap_ms=2)
+        LIB.T_pointing(1, 0, 0, 0)
+        self.assertEqual(right_threshold(), MOTION_THRESHOLD_DEFAULT)
 
-        self.assertEqual(
-            [e.keycode for e in self.history()], [KC_BSPC, KC_BSPC]
-        )
+    def test_motion_ending_in_a_click_teaches_nothing(self) -> None:
+        """The hand was aiming, not resting, if a click closes the burst."""
+        for _ in range(40):
+            LIB.T_pointing(2, 0, 0, 0)
+            LIB.TEST_advance_time(JITTER_GAP_MS)
+            LIB.T_pointing(-2, 0, 0, 0)
+            LIB.T_key(MB_GUI, True)
+            LIB.T_key(MB_GUI, False)
+            LIB.TEST_advance_time(100)
+        LIB.T_pointing(1, 0, 0, 0)
+        self.assertEqual(right_threshold(), MOTION_THRESHOLD_DEFAULT)
 
-    def test_shift_tap_sends_forward_delete(self) -> None:
-        """Shift+tap is forward Delete, and the Shift must NOT reach it.
+    def test_each_dpi_learns_on_its_own(self) -> None:
+        self.learn(1, -1)
+        LIB.T_pointing(1, 0, 0, 0)
+        self.assertEqual(right_threshold(), 3)
 
-        The user's Shift is R1 double-south, a plain KC_RIGHT_SHIFT. The
-        inversion has to strip it before tapping KC_DEL, or the host receives
-        Shift+Delete instead of Delete -- which most apps ignore, looking
-        exactly like "forward delete does nothing".
-        """
-        LIB.T_set_external_mods(MOD_RSFT)
+        LIB.T_set_right_dpi(MOUSE_DPI_200)
+        LIB.T_pointing(1, 0, 0, 0)
+        self.assertEqual(right_threshold(), MOTION_THRESHOLD_DEFAULT,
+                         "nothing learned at 200 DPI yet")
 
-        LIB.T_smtd_touch(CKC_BSPC)
-        LIB.T_smtd_tap(CKC_BSPC, 0)
+    def test_learned_threshold_survives_a_power_cycle(self) -> None:
+        self.learn(1, -1)
+        LIB.T_pointing(1, 0, 0, 0)
+        LIB.townk_eeconfig_task()
+        self.assertEqual(LIB.T_eeprom_user_writes(), 0, "not yet: rate limited")
 
-        emitted = [e for e in self.history() if e.keycode in (KC_DEL, KC_BSPC)]
-        self.assertTrue(emitted, "something must be emitted")
-        self.assertEqual(
-            emitted[0].keycode, KC_DEL, "Shift+tap must send forward Delete"
-        )
-        self.assertEqual(
-            emitted[0].mods & MOD_MASK_SHIFT, 0,
-            f"Delete must go out WITHOUT shift, got {emitted[0]}",
-        )
+        LIB.TEST_advance_time(EECONFIG_SAVE_INTERVAL_MS)
+        LIB.townk_eeconfig_task()
+        LIB.townk_eeconfig_task()
+        self.assertEqual(LIB.T_eeprom_user_writes(), 1, "one write, when due")
 
-        LIB.T_set_external_mods(0)
+        LIB.T_power_up_with_eeprom_user(LIB.T_eeprom_user())
+        LIB.T_pointing(1, 0, 0, 0)
+        self.assertEqual(right_threshold(), 3)
 
-    def test_oneshot_shift_tap_sends_delete_and_consumes_the_oneshot(self) -> None:
-        """Smart Shift tap then pad tap: Delete, with the one-shot spent.
+    def test_erased_eeprom_is_formatted(self) -> None:
+        LIB.T_power_up_with_eeprom_user(0xFFFFFFFF)
+        self.assertEqual(LIB.T_eeprom_user(), 2 << 30, "version 2, nothing learned")
+        LIB.T_pointing(1, 0, 0, 0)
+        self.assertEqual(right_threshold(), MOTION_THRESHOLD_DEFAULT)
 
-        The one-shot shift set by a Smart Shift tap counts as shift for the
-        inversion (mods reads get_mods() | get_oneshot_mods()), so the pad
-        must send forward Delete. But the one-shot is PENDING, not held:
-        unregister_mods() cannot consume it, and re-registering it as a real
-        modifier afterwards would leave a Shift no key release ever clears.
-        The inversion has to spend the one-shot itself -- the Delete IS the
-        "next key" the one-shot was armed for.
-        """
-        LIB.set_oneshot_mods(MOD_LSFT)  # a Smart Shift tap
+    def test_a_hand_set_threshold_wins(self) -> None:
+        LIB.mb_motion_set(1, MB_MOTION_THRESHOLD, 12)
+        self.learn(1, -1)
+        self.assertEqual(right_threshold(), 12)
 
-        LIB.T_smtd_touch(CKC_BSPC)
-        LIB.T_smtd_tap(CKC_BSPC, 0)
 
-        emitted = [e for e in self.history() if e.keycode in (KC_DEL, KC_BSPC)]
-        self.assertTrue(emitted, "something must be emitted")
-        self.assertEqual(
-            emitted[0].keycode, KC_DEL, "one-shot shift must invert the pad too"
-        )
-        self.assertEqual(
-            int(LIB.get_oneshot_mods()), 0,
-            "the one-shot must be consumed by the inverted tap",
-        )
-        self.assertEqual(
-            self.mods() & MOD_MASK_SHIFT, 0,
-            "a one-shot must not become a real shift: nothing would release it",
-        )
+ID_CUSTOM_SET_VALUE = 0x07
+ID_CUSTOM_GET_VALUE = 0x08
+ID_UNHANDLED = 0xFF
+TOWNK_HID_CHANNEL = 0x54
+TOWNK_HID_MOTION_THRESHOLD = 0x01
+TOWNK_HID_MOTION_COHERENCE = 0x05
+TOWNK_HID_TRACE_READ = 0x10
+TOWNK_HID_TRACE_INFO = 0x11
+TOWNK_HID_LATENCY_HISTOGRAM = 0x20
+TOWNK_HID_SMTD_STREAK = 0x30
+TOWNK_HID_RGB_LAYERS = 0x40
+POINTER_LEFT = 0
+POINTER_RIGHT = 1
 
-    def test_ctrl_shift_tap_sends_ctrl_delete(self) -> None:
-        """Ctrl+Shift+Backspace is how you reach Ctrl+Delete.
 
-        The inversion consumes ONLY shift -- unregister_mods(MOD_MASK_SHIFT) --
-        so every other modifier you are holding rides along to the KC_DEL.
-        That makes Ctrl+Delete (and Alt+Delete, Cmd+Delete) reachable by adding
-        the modifier to the Shift+Backspace gesture, with no extra firmware
-        support needed.
-        """
-        LIB.T_set_external_mods(MOD_LCTL | MOD_RSFT)
+def hid(command: int, value_id: int, device: int, value: int = 0,
+        channel: int = TOWNK_HID_CHANNEL) -> bytes:
+    """Send one 32-byte custom-value packet and return the reply."""
+    buf = (ctypes.c_uint8 * 32)(command, channel, value_id, device,
+                                value >> 8, value & 0xFF)
+    LIB.via_custom_value_command_user(buf, 32)
+    return bytes(buf)
 
-        LIB.T_smtd_touch(CKC_BSPC)
-        LIB.T_smtd_tap(CKC_BSPC, 0)
 
-        deletes = [e for e in self.history() if e.keycode == KC_DEL]
-        self.assertTrue(deletes, "a Delete must be emitted")
-        self.assertEqual(
-            deletes[0].mods & MOD_MASK_SHIFT, 0, "shift is consumed by the inversion"
-        )
-        self.assertEqual(
-            deletes[0].mods & MOD_LCTL, MOD_LCTL,
-            f"but Ctrl must survive onto the Delete, got {deletes[0]}",
-        )
+class TownkHidTest(unittest.TestCase):
+    """Runtime tuning of the motion classifier over raw HID (townk_hid.c)."""
 
-        LIB.T_set_external_mods(0)
+    def setUp(self) -> None:
+        LIB.TEST_reset()
+        LIB.T_reset()
 
-    def test_holding_the_pad_keeps_the_mouse_layer(self) -> None:
-        """Holding the pad must not take the mouse layer away.
+    def test_get_returns_the_build_default(self) -> None:
+        reply = hid(ID_CUSTOM_GET_VALUE, TOWNK_HID_MOTION_THRESHOLD, POINTER_RIGHT)
+        self.assertEqual(reply[0], ID_CUSTOM_GET_VALUE)
+        self.assertEqual(reply[4] << 8 | reply[5], 8, "MB_MOVE_THRESHOLD")
 
-        It used to. `mouse_mode(false)` turned _MBO off, and LAYER_PUSH is
-        `layer_move()`, which REPLACES the layer state rather than adding to
-        it -- either alone left no MB_* key on any active layer while the pad
-        was held. So the pad could not contribute Option to a click, because
-        no click was reachable to contribute to. The feature was unreachable
-        by construction, and no test at the engine seam could see it: the
-        engine is driven directly here, bypassing keymap and layer lookup.
-        """
-        LIB.T_mouse_layer(True)  # trackball activity raised _MBO
-        self.assertTrue(LIB.T_layer_is(LAYER_MBO))
+    def test_set_takes_effect_without_a_reflash(self) -> None:
+        """With coherence off, the wobble the default rejects is a drag."""
+        reply = hid(ID_CUSTOM_SET_VALUE, TOWNK_HID_MOTION_COHERENCE, POINTER_RIGHT, 0)
+        self.assertEqual(reply[0], ID_CUSTOM_SET_VALUE, "accepted")
 
-        LIB.T_smtd_touch(CKC_BSPC)
-        LIB.T_smtd_hold(CKC_BSPC, 0)
+        reply = hid(ID_CUSTOM_GET_VALUE, TOWNK_HID_MOTION_COHERENCE, POINTER_RIGHT)
+        self.assertEqual(reply[4] << 8 | reply[5], 0, "and reads back")
 
-        self.assertTrue(LIB.T_layer_is(LAYER_NAV), "the pad must raise _NAV")
-        self.assertTrue(
-            LIB.T_layer_is(LAYER_MBO),
-            "and the mouse layer must survive, or there is nothing to click",
-        )
+        LIB.T_key(MB_GUI, True)
+        for x in (3, -3, 3, -3):
+            LIB.T_pointing(x, 0, 0, 0)
+        self.assertEqual(recorded_history(), [Event(KC_BTN3, pressed=True, mods=0)])
+        LIB.T_key(MB_GUI, False)
 
-        LIB.T_smtd_release(CKC_BSPC, 0)
-        self.assertFalse(LIB.T_layer_is(LAYER_NAV), "_NAV goes away on release")
+    def test_each_ball_is_tuned_on_its_own(self) -> None:
+        hid(ID_CUSTOM_SET_VALUE, TOWNK_HID_MOTION_THRESHOLD, POINTER_LEFT, 20)
+        reply = hid(ID_CUSTOM_GET_VALUE, TOWNK_HID_MOTION_THRESHOLD, POINTER_RIGHT)
+        self.assertEqual(reply[4] << 8 | reply[5], 8, "the right ball is untouched")
+
+    def test_nonsense_is_unhandled(self) -> None:
+        """Foreign channels, unknown IDs and bad values are refused."""
+        for reply in (
+            hid(ID_CUSTOM_GET_VALUE, TOWNK_HID_MOTION_THRESHOLD, POINTER_RIGHT, channel=0),
+            hid(ID_CUSTOM_GET_VALUE, 0x7F, POINTER_RIGHT),
+            hid(ID_CUSTOM_GET_VALUE, TOWNK_HID_MOTION_THRESHOLD, 2),
+            hid(ID_CUSTOM_SET_VALUE, TOWNK_HID_MOTION_COHERENCE, POINTER_RIGHT, 300),
+        ):
+            self.assertEqual(reply[0], ID_UNHANDLED, reply.hex())
+
+
+# townk_trace.h record types and MB_* roles
+TRACE_MB_PRESS, TRACE_MB_RESOLVE, TRACE_MB_RELEASE = 1, 2, 3
+TRACE_MODS_ACQUIRE, TRACE_MODS_RELEASE = 4, 5
+TRACE_SMTD_ACTION, TRACE_LAYER = 6, 7
+ROLE_UNDECIDED, ROLE_CLICK, ROLE_MODIFIER, ROLE_DRAG = 0, 1, 2, 3
+SMTD_ACTION_TOUCH = 0
+
+
+class Record(NamedTuple):
+    time: int
+    type: int
+    a: int
+    b: int
+
+
+def trace_info() -> tuple[int, int]:
+    """The flight recorder's next sequence number and capacity."""
+    reply = hid(ID_CUSTOM_GET_VALUE, TOWNK_HID_TRACE_INFO, 0)
+    return reply[3] << 8 | reply[4], reply[5] << 8 | reply[6]
+
+
+def trace_read(seq: int) -> list[Record]:
+    """One TOWNK_HID_TRACE_READ packet's worth of records from seq on."""
+    # The sequence number sits where the ball byte and value's high byte go.
+    reply = hid(ID_CUSTOM_GET_VALUE, TOWNK_HID_TRACE_READ, seq >> 8, (seq & 0xFF) << 8)
+    records = []
+    for i in range(reply[5]):
+        r = reply[6 + 8 * i:14 + 8 * i]
+        records.append(Record(int.from_bytes(r[0:4], "big"), r[4], r[5],
+                              r[6] << 8 | r[7]))
+    return records
+
+
+def trace_dump() -> list[Record]:
+    """Every record the ring still holds, oldest first, as the host tool reads it."""
+    head, size = trace_info()
+    seq = max(0, head - size)
+    records: list[Record] = []
+    while seq < head:
+        chunk = trace_read(seq)
+        if not chunk:
+            break
+        records += chunk
+        seq += len(chunk)
+    return records
+
+
+class TownkTraceTest(unittest.TestCase):
+    """The flight recorder (townk_trace.h), read back over raw HID."""
 
-        LIB.T_mouse_layer(False)
+    def setUp(self) -> None:
+        LIB.TEST_reset()
+        LIB.T_reset()
 
-    def test_holding_the_pad_gives_nav_not_delete(self) -> None:
-        """A press long enough to resolve as HOLD is the layer, not a Delete.
+    def of_type(self, *types: int) -> list[tuple[int, int, int]]:
+        return [(r.type, r.a, r.b) for r in trace_dump() if r.type in types]
 
-        Documents the trap rather than a defect: SM_TD picks TAP or HOLD by
-        timing, and the hold branch is `mouse_mode(false); LAYER_PUSH(_NAV)`.
-        So a *deliberate*, slightly slow Shift+Backspace -- a two-handed
-        gesture, so easily slower than a reflexive Backspace -- silently
-        becomes "activate the navigation layer" and emits nothing at all.
-        """
-        LIB.T_set_external_mods(MOD_RSFT)
+    def test_a_drag_records_press_resolve_and_release(self) -> None:
+        gui = MB_GUI - MB_SFT  # its MB_KEYS index
+        LIB.T_key(MB_GUI, True)
+        for _ in range(4):
+            LIB.T_pointing(3, 0, 0, 0)
+        LIB.T_key(MB_GUI, False)
 
-        LIB.T_smtd_touch(CKC_BSPC)
-        LIB.T_smtd_hold(CKC_BSPC, 0)
+        mb = (TRACE_MB_PRESS, TRACE_MB_RESOLVE, TRACE_MB_RELEASE)
+        self.assertEqual(self.of_type(*mb), [
+            (TRACE_MB_PRESS, gui, ROLE_UNDECIDED),
+            (TRACE_MB_RESOLVE, ROLE_DRAG, 1 << gui),
+            (TRACE_MB_RELEASE, gui, ROLE_DRAG),
+        ])
 
-        self.assertNotIn(
-            KC_DEL, [e.keycode for e in self.history()],
-            "the hold branch emits no Delete -- it raises the layer instead",
-        )
+    def test_cmd_space_records_why_the_key_became_cmd(self) -> None:
+        """The SM_TD touch comes first: it is what resolved the key."""
+        gui = MB_GUI - MB_SFT
+        LIB.T_key(MB_GUI, True)
+        LIB.T_smtd_touch(CKC_SPC)
+        LIB.T_key(MB_GUI, False)
 
-        LIB.T_smtd_release(CKC_BSPC, 0)
-        LIB.T_set_external_mods(0)
+        self.assertEqual(self.of_type(TRACE_SMTD_ACTION, TRACE_MB_RESOLVE,
+                                      TRACE_MODS_ACQUIRE, TRACE_MODS_RELEASE), [
+            (TRACE_SMTD_ACTION, SMTD_ACTION_TOUCH, CKC_SPC),
+            (TRACE_MB_RESOLVE, ROLE_MODIFIER, 1 << gui),
+            (TRACE_MODS_ACQUIRE, MOD_LGUI, MOD_LGUI),
+            (TRACE_MODS_RELEASE, MOD_LGUI, 0),
+        ])
 
-    def test_shift_is_restored_after_the_delete(self) -> None:
-        """The user is still holding Shift; it must come back afterwards."""
-        LIB.T_set_external_mods(MOD_RSFT)
+    def test_layer_changes_are_recorded(self) -> None:
+        LIB.T_hold_backspace(True)
+        LIB.T_hold_backspace(False)
 
-        LIB.T_smtd_touch(CKC_BSPC)
-        LIB.T_smtd_tap(CKC_BSPC, 0)
+        self.assertEqual(self.of_type(TRACE_LAYER), [
+            (TRACE_LAYER, LAYER_NAV, 1 << LAYER_BASE | 1 << LAYER_NAV),
+            (TRACE_LAYER, LAYER_BASE, 1 << LAYER_BASE),
+        ])
 
-        self.assertEqual(
-            self.mods() & MOD_MASK_SHIFT, MOD_RSFT,
-            "shift must be re-registered after the inverted tap",
-        )
+    def test_the_ring_keeps_the_newest_records(self) -> None:
+        _, size = trace_info()
+        for _ in range(size + 10):
+            LIB.T_mods_acquire(MOD_LSFT)
+        head, _ = trace_info()
 
-        LIB.T_set_external_mods(0)
+        self.assertEqual(head, size + 10)
+        self.assertEqual(len(trace_dump()), size, "the oldest ten are gone")
+        self.assertEqual(trace_read(head - size - 1), [], "overwritten")
+        self.assertEqual(trace_read(head), [], "not written yet")
+        for _ in range(size + 10):
+            LIB.T_mods_release(MOD_LSFT)
 
-    # -- modifiers contributed to a click by a held key -------------------
+    def test_a_set_on_info_clears_the_ring(self) -> None:
+        LIB.T_mods_acquire(MOD_LSFT)
+        LIB.T_mods_release(MOD_LSFT)
+        reply = hid(ID_CUSTOM_SET_VALUE, TOWNK_HID_TRACE_INFO, 0)
 
-    def test_held_backspace_contributes_alt_to_a_click(self) -> None:
-        """Hold the left thumb pad, click: the click carries Option."""
-        LIB.T_hold_backspace(True)
+        self.assertEqual(reply[0], ID_CUSTOM_SET_VALUE)
+        self.assertEqual(trace_info()[0], 0)
+        self.assertEqual(trace_dump(), [])
 
-        LIB.T_key(MB_SFT, True)
-        LIB.T_key(MB_SFT, False)
+    def test_reads_are_refused_as_sets(self) -> None:
+        reply = hid(ID_CUSTOM_SET_VALUE, TOWNK_HID_TRACE_READ, 0)
+        self.assertEqual(reply[0], ID_UNHANDLED)
 
-        self.assertEqual(
-            self.history(),
-            [
-                Event(KC_BTN1, pressed=True, mods=MOD_LALT),
-                Event(KC_BTN1, pressed=False, mods=MOD_LALT),
-            ],
-            "the click must carry Option contributed by the held key",
-        )
 
-        LIB.T_hold_backspace(False)
+# townk_latency.h
+LATENCY_SMTD_TAP, LATENCY_SMTD_HOLD, LATENCY_MB_CLICK, LATENCY_MB_DRAG = range(4)
+LATENCY_BUCKETS = 12
 
-    def test_contributed_modifier_does_not_outlive_the_click(self) -> None:
-        """Option is scoped to the click, not to how long the key is held.
 
-        If it stayed on for as long as the pad was down it would leak into
-        _NAV, silently turning every navigation keypress into Option+key --
-        Option+arrow being word-jump rather than character-move.
-        """
-        LIB.T_hold_backspace(True)
+def latency_histogram(cls: int) -> list[int]:
+    """One class's bucket counts, read over raw HID."""
+    reply = hid(ID_CUSTOM_GET_VALUE, TOWNK_HID_LATENCY_HISTOGRAM, cls)
+    return [reply[4 + 2 * b] << 8 | reply[5 + 2 * b] for b in range(LATENCY_BUCKETS)]
 
-        LIB.T_key(MB_SFT, True)
-        LIB.T_key(MB_SFT, False)
-        self.assertEqual(
-            self.mods(), 0, "Option must be gone once the click is over"
-        )
 
-        LIB.T_hold_backspace(False)
+def only_bucket(bucket: int) -> list[int]:
+    return [1 if b == bucket else 0 for b in range(LATENCY_BUCKETS)]
 
-    def test_contributed_modifier_refcounts_against_a_held_key(self) -> None:
-        """The case reference counting exists for.
 
-        MB_ALT is acting as Option while the thumb pad also contributes
-        Option to a click. When the click ends, Option must stay held --
-        MB_ALT still wants it. A bare unregister_mods() here would drop the
-        modifier out from under a key the user is still holding.
-        """
-        LIB.T_key(MB_ALT, True)
-        LIB.T_key(KC_PLAIN, True)   # resolves MB_ALT to its modifier role
-        LIB.T_key(KC_PLAIN, False)
-        self.assertEqual(self.mods(), MOD_LALT, "MB_ALT holds Option")
+class TownkLatencyTest(unittest.TestCase):
+    """Press-to-report latency histograms (townk_latency.c), over raw HID.
 
-        LIB.T_hold_backspace(True)
-        LIB.T_key(MB_SFT, True)
-        LIB.T_key(MB_SFT, False)    # a click that also contributes Option
+    Bucket n holds 2^(n-1) .. 2^n - 1 ms.
+    """
 
-        self.assertEqual(
-            self.mods(), MOD_LALT,
-            "Option must survive the click -- MB_ALT is still holding it",
-        )
+    def setUp(self) -> None:
+        LIB.TEST_reset()
+        LIB.T_reset()
 
-        LIB.T_hold_backspace(False)
-        LIB.T_key(MB_ALT, False)
-        self.assertEqual(self.mods(), 0, "and released once MB_ALT lets go")
+    def test_a_layer_tap_is_measured_from_the_matrix_press(self) -> None:
+        LIB.T_matrix_press(CKC_SPC)
+        LIB.T_smtd_touch(CKC_SPC)
+        LIB.TEST_advance_time(120)
+        LIB.T_smtd_tap(CKC_SPC, 0)
 
-    def test_drag_carries_the_contributed_modifier(self) -> None:
-        """Option+drag: the modifier is live for the whole gesture."""
-        LIB.T_hold_backspace(True)
+        self.assertEqual(latency_histogram(LATENCY_SMTD_TAP), only_bucket(7))
+        self.assertEqual(latency_histogram(LATENCY_SMTD_HOLD), only_bucket(-1))
 
-        LIB.T_key(MB_SFT, True)
-        LIB.T_pointing(5, 5, 0, 0)
-        self.assertEqual(
-            self.history(), [Event(KC_BTN1, pressed=True, mods=MOD_LALT)]
-        )
+    def test_sm_td_replay_keeps_the_matrix_time(self) -> None:
+        LIB.T_matrix_press(CKC_SPC)
+        LIB.TEST_advance_time(100)
+        LIB.T_replay_press(CKC_SPC)
+        LIB.TEST_advance_time(20)
+        LIB.T_smtd_tap(CKC_SPC, 0)
 
-        LIB.T_key(MB_SFT, False)
-        self.assertEqual(
-            self.history()[-1], Event(KC_BTN1, pressed=False, mods=MOD_LALT),
-            "the drop must still carry Option",
-        )
-        self.assertEqual(self.mods(), 0, "and Option is released after it")
+        self.assertEqual(latency_histogram(LATENCY_SMTD_TAP), only_bucket(7))
 
-        LIB.T_hold_backspace(False)
+    def test_a_press_is_counted_once(self) -> None:
+        """The layer switching on is the output; the release is not another."""
+        LIB.T_matrix_press(CKC_BSPC)
+        LIB.T_smtd_touch(CKC_BSPC)
+        LIB.TEST_advance_time(200)
+        LIB.T_smtd_hold(CKC_BSPC, 0)
+        LIB.T_smtd_release(CKC_BSPC, 0)
+        LIB.T_smtd_tap(CKC_BSPC, 0)  # no press behind it: not counted
 
-    # -- reference-counted modifier ownership -----------------------------
+        self.assertEqual(latency_histogram(LATENCY_SMTD_HOLD), only_bucket(8))
+        self.assertEqual(latency_histogram(LATENCY_SMTD_TAP), only_bucket(-1))
 
-    def test_two_claims_need_two_releases(self) -> None:
-        """A modifier stays held until the LAST owner gives it up.
+    def test_an_mb_click_is_measured_to_its_release(self) -> None:
+        LIB.T_key(MB_GUI, True)
+        LIB.TEST_advance_time(40)
+        LIB.T_key(MB_GUI, False)
 
-        Once a held key can contribute a modifier to a click, two things can
-        want the same bit at once -- MB_ALT acting as Alt while CKC_BSPC also
-        contributes Alt. Whoever finishes first must not switch it off under
-        the other, which a bare unregister_mods() would do silently.
-        """
-        LIB.T_mods_acquire(MOD_LALT)
-        self.assertEqual(self.mods(), MOD_LALT)
+        self.assertEqual(latency_histogram(LATENCY_MB_CLICK), only_bucket(6))
 
-        LIB.T_mods_acquire(MOD_LALT)
-        self.assertEqual(int(LIB.T_mods_claims(MOD_LALT)), 2)
+    def test_an_mb_drag_is_measured_to_its_button_down(self) -> None:
+        LIB.T_key(MB_GUI, True)
+        for _ in range(4):
+            LIB.TEST_advance_time(5)
+            LIB.T_pointing(3, 0, 0, 0)
+        LIB.T_key(MB_GUI, False)
 
-        LIB.T_mods_release(MOD_LALT)
-        self.assertEqual(
-            self.mods(), MOD_LALT, "still wanted by the second owner"
-        )
+        self.assertEqual(latency_histogram(LATENCY_MB_DRAG), only_bucket(4))
+        self.assertEqual(latency_histogram(LATENCY_MB_CLICK), only_bucket(-1))
 
-        LIB.T_mods_release(MOD_LALT)
-        self.assertEqual(self.mods(), 0, "last owner gone, modifier released")
+    def test_a_set_clears_every_histogram(self) -> None:
+        LIB.T_key(MB_GUI, True)
+        LIB.T_key(MB_GUI, False)
+        reply = hid(ID_CUSTOM_SET_VALUE, TOWNK_HID_LATENCY_HISTOGRAM, 0)
 
-    def test_claims_are_tracked_per_modifier(self) -> None:
-        """Claims on one modifier must not affect another."""
-        LIB.T_mods_acquire(MOD_LALT | MOD_LGUI)
-        LIB.T_mods_acquire(MOD_LALT)
+        self.assertEqual(reply[0], ID_CUSTOM_SET_VALUE)
+        self.assertEqual(latency_histogram(LATENCY_MB_CLICK), only_bucket(-1))
 
-        LIB.T_mods_release(MOD_LALT)
-        self.assertEqual(
-            self.mods(), MOD_LALT | MOD_LGUI, "Cmd untouched, Alt still claimed"
-        )
+    def test_an_unknown_class_is_unhandled(self) -> None:
+        reply = hid(ID_CUSTOM_GET_VALUE, TOWNK_HID_LATENCY_HISTOGRAM, 4)
+        self.assertEqual(reply[0], ID_UNHANDLED)
 
-        LIB.T_mods_release(MOD_LALT | MOD_LGUI)
-        self.assertEqual(self.mods(), 0)
 
-    def test_releasing_an_unclaimed_modifier_is_ignored(self) -> None:
-        """A stray release must not steal a modifier somebody else holds."""
-        LIB.T_mods_acquire(MOD_LGUI)
+KC_SPC: int = int(LIB.T_kc_spc())
+CKC_SMSFT: int = int(LIB.T_kc_ckc_smsft())
+LAYER_NUM: int = int(LIB.T_layer_num())
+SMTD_ACTION_TAP, SMTD_ACTION_HOLD = 1, 2
+SMTD_RESOLUTION_UNCERTAIN, SMTD_RESOLUTION_UNHANDLED, SMTD_RESOLUTION_DETERMINED = range(3)
 
-        LIB.T_mods_release(MOD_LALT)  # never claimed
-        self.assertEqual(self.mods(), MOD_LGUI, "Cmd must survive")
 
-        LIB.T_mods_release(MOD_LGUI)
-        self.assertEqual(self.mods(), 0)
+class TownkSmtdTableTest(unittest.TestCase):
+    """The smtd_keys[] table and its shared handlers in townk_smtd.c.
 
-    # -- a gesture already in flight --------------------------------------
+    Backspace/Delete, Smart Shift's one-shot and the MB_* interplay are pinned
+    by TownkMouseTest; these cover the plain layer-tap and the dispatch.
+    """
 
-    def test_key_pressed_during_a_drag_becomes_a_modifier(self) -> None:
-        """Finder copy-on-drop: hold Option mid-drag to copy instead of move.
+    def setUp(self) -> None:
+        LIB.TEST_reset()
+        LIB.T_reset()
 
-        A drag is already in flight, so a key pressed during it is qualifying
-        that drag, not starting a click of its own -- and it has to be live
-        immediately, because no further keypress is coming to earn it. The
-        drop itself is the next event.
+    def tearDown(self) -> None:
+        LIB.layer_move(LAYER_BASE)
 
-        This is the mirror of the external-modifier rule: a modifier held at
-        press time makes the key a button, and a button held at press time
-        makes it a modifier.
-        """
-        LIB.T_key(MB_SFT, True)
-        LIB.T_pointing(5, 5, 0, 0)  # motion -> BTN1 held: the drag
-        self.assertEqual(self.history(), [Event(KC_BTN1, pressed=True, mods=0)])
+    def test_a_layer_tap_sends_its_key_on_tap(self) -> None:
+        LIB.T_smtd_tap(CKC_SPC, 0)
+        self.assertEqual(recorded_history(), [
+            Event(KC_SPC, pressed=True, mods=0),
+            Event(KC_SPC, pressed=False, mods=0),
+        ])
+
+    def test_a_layer_tap_moves_to_its_layer_while_held(self) -> None:
+        LIB.T_smtd_hold(CKC_SPC, 0)
+        self.assertTrue(LIB.T_layer_is(LAYER_NUM))
+        LIB.T_smtd_release(CKC_SPC, 0)
+        self.assertFalse(LIB.T_layer_is(LAYER_NUM))
+        self.assertEqual(recorded_history(), [], "a layer hold sends nothing")
+
+    def test_tap_then_hold_holds_the_key(self) -> None:
+        LIB.T_smtd_hold(CKC_SPC, 1)
+        self.assertFalse(LIB.T_layer_is(LAYER_NUM))
+        LIB.T_smtd_release(CKC_SPC, 1)
+        self.assertEqual(recorded_history(), [
+            Event(KC_SPC, pressed=True, mods=0),
+            Event(KC_SPC, pressed=False, mods=0),
+        ])
+
+    def test_smart_shift_is_shift_while_held(self) -> None:
+        LIB.T_smtd_hold(CKC_SMSFT, 0)
+        self.assertEqual(LIB.get_mods(), MOD_LSFT)
+        LIB.T_smtd_release(CKC_SMSFT, 0)
+        self.assertEqual(LIB.get_mods(), 0)
+
+    def test_resolutions_match_smtd_dance(self) -> None:
+        self.assertEqual(LIB.T_smtd_resolution(CKC_SPC, SMTD_ACTION_TOUCH),
+                         SMTD_RESOLUTION_UNCERTAIN)
+        self.assertEqual(LIB.T_smtd_resolution(CKC_SPC, SMTD_ACTION_TAP),
+                         SMTD_RESOLUTION_DETERMINED)
+
+    def test_keys_outside_the_table_are_unhandled(self) -> None:
+        """MB_* keys follow the SM_TD keys in the keycode range."""
+        for keycode in (MB_SFT, KC_SPC):
+            self.assertEqual(LIB.T_smtd_resolution(keycode, SMTD_ACTION_TAP),
+                             SMTD_RESOLUTION_UNHANDLED)
+
+
+SMTD_TIMEOUT_TAP, SMTD_TIMEOUT_SEQUENCE = 0, 1
+SMTD_GLOBAL_TAP_TERM = 200
+SMTD_ADAPTIVE_MIN_TERM, SMTD_ADAPTIVE_MAX_TERM = 120, 300
+SMTD_ADAPTIVE_MIN_SAMPLES = 16
+
+
+def tap_term(keycode: int) -> int:
+    return int(LIB.get_smtd_timeout(keycode, SMTD_TIMEOUT_TAP))
+
+
+def smtd_tap(keycode: int, duration: int) -> None:
+    """One tap of an SM_TD key, released after duration ms."""
+    LIB.T_smtd_touch(keycode)
+    LIB.TEST_advance_time(duration)
+    LIB.T_smtd_tap(keycode, 0)
+    LIB.TEST_advance_time(300)  # the next press is a new sequence
+
+
+def smtd_hold(keycode: int, duration: int, used: int | None = None) -> None:
+    """One hold of an SM_TD key, released after duration ms.
+
+    Another key is pressed under it after used ms (by default at the tap
+    term); None for a hold nothing was pressed under.
+    """
+    term = tap_term(keycode)
+    LIB.T_smtd_touch(keycode)
+    if used is not None and used < term:
+        LIB.TEST_advance_time(used)
+        LIB.T_matrix_press(KC_PLAIN)
+        LIB.TEST_advance_time(term - used)
+        LIB.T_smtd_hold(keycode, 0)
+    else:
+        LIB.TEST_advance_time(term)
+        LIB.T_smtd_hold(keycode, 0)
+        if used is not None:
+            LIB.TEST_advance_time(used - term)
+            LIB.T_matrix_press(KC_PLAIN)
+    LIB.TEST_advance_time(duration - max(term, used or 0))
+    LIB.T_smtd_release(keycode, 0)
+    LIB.TEST_advance_time(300)
+
+
+class TownkAdaptiveTermTest(unittest.TestCase):
+    """Per-key tap terms learned from each key's own taps (townk_smtd.c)."""
 
-        LIB.T_key(MB_ALT, True)
-        self.assertEqual(
-            self.mods(), MOD_LALT, "Option must be live while the button is down"
-        )
-        self.assertNotIn(
-            KC_BTN2, [e.keycode for e in self.history()],
-            "Option must not also press its own mouse button mid-drag",
-        )
+    def setUp(self) -> None:
+        LIB.TEST_reset()
+        LIB.T_reset()
 
-        # Drop while Option is still held -- that is what makes it a copy.
-        LIB.T_key(MB_SFT, False)
-        self.assertEqual(
-            self.history()[-1], Event(KC_BTN1, pressed=False, mods=MOD_LALT),
-            "the drop must carry Option, or Finder moves instead of copying",
-        )
+    def tearDown(self) -> None:
+        LIB.layer_move(LAYER_BASE)
 
-        LIB.T_key(MB_ALT, False)
+    def test_the_global_term_until_enough_taps(self) -> None:
+        for _ in range(SMTD_ADAPTIVE_MIN_SAMPLES - 1):
+            smtd_tap(CKC_BSPC, 60)
+        self.assertEqual(tap_term(CKC_BSPC), SMTD_GLOBAL_TAP_TERM)
+
+    def test_quick_taps_shorten_that_key_only(self) -> None:
+        for _ in range(SMTD_ADAPTIVE_MIN_SAMPLES):
+            smtd_tap(CKC_BSPC, 60)
+        self.assertEqual(tap_term(CKC_BSPC), SMTD_ADAPTIVE_MIN_TERM, "at the floor")
+        self.assertEqual(tap_term(CKC_SPC), SMTD_GLOBAL_TAP_TERM, "untouched")
+
+    def test_the_term_clears_a_leisurely_tapper(self) -> None:
+        durations = [150, 190, 170, 210] * 8
+        for d in durations:
+            smtd_tap(CKC_SPC, d)
+        term = tap_term(CKC_SPC)
+        self.assertGreater(term, max(durations), "every tap stays a tap")
+        self.assertLessEqual(term, SMTD_ADAPTIVE_MAX_TERM)
+
+    def test_short_holds_pull_the_term_back(self) -> None:
+        """Where taps and holds overlap, the term splits the difference."""
+        for d in [150, 190, 170, 210] * 8:
+            smtd_tap(CKC_SPC, d)
+        taps_only = tap_term(CKC_SPC)
+
+        for _ in range(16):
+            smtd_hold(CKC_SPC, 400, used=200)
+        self.assertLess(tap_term(CKC_SPC), taps_only)
+
+    def test_a_hold_counts_to_its_first_use(self) -> None:
+        """Not to its release, which always comes after the term."""
+        for d in [150, 190, 170, 210] * 8:
+            smtd_tap(CKC_SPC, d)
+        taps_only = tap_term(CKC_SPC)
+
+        for _ in range(16):
+            smtd_hold(CKC_SPC, 1000, used=taps_only - 40)
+        self.assertLess(tap_term(CKC_SPC), taps_only - 20,
+                        "holds put to use under the term pull it down")
+
+    def test_a_hold_nothing_was_pressed_under_teaches_nothing(self) -> None:
+        for d in [150, 190, 170, 210] * 8:
+            smtd_tap(CKC_SPC, d)
+        taps_only = tap_term(CKC_SPC)
+
+        for _ in range(16):
+            smtd_hold(CKC_SPC, 230)
+        self.assertEqual(tap_term(CKC_SPC), taps_only)
+
+    def test_other_timeouts_stay_global(self) -> None:
+        for _ in range(SMTD_ADAPTIVE_MIN_SAMPLES):
+            smtd_tap(CKC_BSPC, 60)
+        self.assertEqual(LIB.get_smtd_timeout(CKC_BSPC, SMTD_TIMEOUT_SEQUENCE),
+                         LIB.get_smtd_timeout(MB_SFT, SMTD_TIMEOUT_SEQUENCE))
+
+    def test_a_learned_term_survives_a_power_cycle(self) -> None:
+        for _ in range(SMTD_ADAPTIVE_MIN_SAMPLES):
+            smtd_tap(CKC_BSPC, 60)
+        LIB.TEST_advance_time(EECONFIG_SAVE_INTERVAL_MS)
+        LIB.townk_eeconfig_task()
+        self.assertEqual(LIB.T_eeprom_user_data_writes(), 1)
+        self.assertEqual(LIB.T_eeprom_user_writes(), 0, "the word did not change")
+
+        LIB.T_power_up_with_eeprom_user(LIB.T_eeprom_user())
+        self.assertEqual(tap_term(CKC_BSPC), SMTD_ADAPTIVE_MIN_TERM)
+
+
+SMTD_STREAK_INTERVAL_MS = 150
+SMTD_STREAK_IDLE_MS = 300
+
+
+def type_letters(count: int, gap: int = 80) -> None:
+    """Presses of a plain key, gap ms apart, as process_record_user sees them."""
+    for _ in range(count):
+        LIB.T_matrix_press(KC_PLAIN)
+        LIB.TEST_advance_time(gap)
+
+
+def streak_stats() -> tuple[int, int]:
+    """The fast-path counters over raw HID: (fast, slow)."""
+    reply = hid(ID_CUSTOM_GET_VALUE, TOWNK_HID_SMTD_STREAK, 0)
+    return (int.from_bytes(reply[3:7], "big"), int.from_bytes(reply[7:11], "big"))
+
+
+class TownkStreakTest(unittest.TestCase):
+    """The typing-streak fast path for layer-taps (townk_smtd.c)."""
 
-    def test_key_pressed_during_a_held_click_becomes_a_modifier(self) -> None:
-        """Same rule when the button is held by external mods rather than motion."""
-        LIB.T_set_external_mods(MOD_LSFT)
-        LIB.T_key(MB_GUI, True)  # external mods -> immediately a button
-        LIB.T_set_external_mods(0)
+    def setUp(self) -> None:
+        LIB.TEST_reset()
+        LIB.T_reset()
+        LIB.TEST_advance_time(SMTD_STREAK_IDLE_MS)  # no streak carried in
 
-        LIB.T_key(MB_ALT, True)
-        self.assertEqual(self.mods(), MOD_LALT, "Option qualifies the held button")
+    def tearDown(self) -> None:
+        LIB.layer_move(LAYER_BASE)
 
-        LIB.T_key(MB_ALT, False)
-        LIB.T_key(MB_GUI, False)
+    def test_mid_streak_a_layer_tap_is_tapped_on_touch(self) -> None:
+        type_letters(3)
+        LIB.T_matrix_press(CKC_SPC)
+        self.assertEqual(LIB.T_smtd_resolution(CKC_SPC, SMTD_ACTION_TOUCH),
+                         SMTD_RESOLUTION_DETERMINED)
+        self.assertEqual(recorded_history(), [
+            Event(KC_SPC, pressed=True, mods=0),
+            Event(KC_SPC, pressed=False, mods=0),
+        ])
+
+        # Whatever SM_TD still reports of that press is not sent again.
+        LIB.T_smtd_hold(CKC_SPC, 0)
+        LIB.T_smtd_release(CKC_SPC, 0)
+        self.assertFalse(LIB.T_layer_is(LAYER_NUM))
+        self.assertEqual(len(recorded_history()), 2)
+        self.assertEqual(streak_stats(), (1, 0))
+
+    def test_the_shifted_layer_tap_keeps_its_shift(self) -> None:
+        type_letters(3)
+        LIB.T_matrix_press(CKC_BSPC)
+        LIB.set_mods(MOD_LSFT)
+        LIB.T_smtd_touch(CKC_BSPC)
+        self.assertEqual([e.keycode for e in recorded_history()], [KC_DEL, KC_DEL])
+
+    def test_sm_td_replays_do_not_count_toward_the_streak(self) -> None:
+        # Each press arrives twice: from the matrix, then as sm_td's replay.
+        LIB.T_matrix_press(KC_PLAIN)
+        LIB.T_replay_press(KC_PLAIN)
+        LIB.TEST_advance_time(80)
+        LIB.T_matrix_press(CKC_SPC)
+        self.assertEqual(LIB.T_smtd_resolution(CKC_SPC, SMTD_ACTION_TOUCH),
+                         SMTD_RESOLUTION_UNCERTAIN)
+
+    def test_too_few_quick_presses_are_not_a_streak(self) -> None:
+        type_letters(1)
+        LIB.T_matrix_press(CKC_SPC)
+        self.assertEqual(LIB.T_smtd_resolution(CKC_SPC, SMTD_ACTION_TOUCH),
+                         SMTD_RESOLUTION_UNCERTAIN)
+
+    def test_a_pause_before_the_key_lets_it_be_held(self) -> None:
+        """Reaching for a layer after a word is a hold, streak or not."""
+        type_letters(5)
+        LIB.TEST_advance_time(SMTD_STREAK_INTERVAL_MS)
+        LIB.T_matrix_press(CKC_SPC)
+        LIB.T_smtd_touch(CKC_SPC)
+        LIB.T_smtd_hold(CKC_SPC, 0)
+        self.assertTrue(LIB.T_layer_is(LAYER_NUM))
+        LIB.T_smtd_release(CKC_SPC, 0)
+        self.assertEqual(streak_stats(), (0, 1))
+
+    def test_a_short_pause_does_not_end_the_streak(self) -> None:
+        type_letters(3)
+        LIB.TEST_advance_time(SMTD_STREAK_INTERVAL_MS)
+        type_letters(1)
+        LIB.T_matrix_press(CKC_SPC)
+        self.assertEqual(LIB.T_smtd_resolution(CKC_SPC, SMTD_ACTION_TOUCH),
+                         SMTD_RESOLUTION_DETERMINED)
+
+    def test_an_idle_gap_ends_the_streak(self) -> None:
+        type_letters(5)
+        LIB.TEST_advance_time(SMTD_STREAK_IDLE_MS)
+        type_letters(1)
+        LIB.T_matrix_press(CKC_SPC)
+        self.assertEqual(LIB.T_smtd_resolution(CKC_SPC, SMTD_ACTION_TOUCH),
+                         SMTD_RESOLUTION_UNCERTAIN)
+
+    def test_smart_shift_is_left_alone(self) -> None:
+        type_letters(3)
+        LIB.T_matrix_press(CKC_SMSFT)
+        self.assertEqual(LIB.T_smtd_resolution(CKC_SMSFT, SMTD_ACTION_TOUCH),
+                         SMTD_RESOLUTION_UNCERTAIN)
+
+    def test_a_fast_tap_teaches_no_tap_term(self) -> None:
+        for _ in range(SMTD_ADAPTIVE_MIN_SAMPLES):
+            type_letters(3, gap=50)
+            LIB.T_matrix_press(CKC_BSPC)
+            LIB.T_smtd_touch(CKC_BSPC)
+            LIB.TEST_advance_time(50)
+            LIB.T_smtd_tap(CKC_BSPC, 0)
+        self.assertEqual(tap_term(CKC_BSPC), SMTD_GLOBAL_TAP_TERM)
+        self.assertEqual(streak_stats(), (SMTD_ADAPTIVE_MIN_SAMPLES, 0))
+
+    def test_a_set_clears_the_counters(self) -> None:
+        type_letters(3)
+        LIB.T_matrix_press(CKC_SPC)
+        LIB.T_smtd_touch(CKC_SPC)
+        reply = hid(ID_CUSTOM_SET_VALUE, TOWNK_HID_SMTD_STREAK, 0)
+        self.assertEqual(reply[0], ID_CUSTOM_SET_VALUE)
+        self.assertEqual(streak_stats(), (0, 0))
+
+
+CKC_TAB: int = int(LIB.T_kc_ckc_tab())
+LAYER_SYM: int = int(LIB.T_layer_sym())
+
+
+def layer_state() -> int:
+    return ctypes.c_uint32.in_dll(LIB, "layer_state").value
+
+
+def layer_changes() -> list[int]:
+    """The layer states layer_state_set_user() was handed, from the trace."""
+    return [r.b for r in trace_dump() if r.type == TRACE_LAYER]
+
+
+class TownkLayerStackTest(unittest.TestCase):
+    """The layer-tap hold stack in townk_smtd.c (CKC_SPC: _NUM, CKC_TAB: _SYM)."""
 
-    # -- multiple keys ----------------------------------------------------
+    def setUp(self) -> None:
+        LIB.TEST_reset()
+        LIB.T_reset()
 
-    def test_second_mb_key_makes_the_first_a_modifier(self) -> None:
-        """Hold MB_GUI, tap MB_SFT: Cmd held, and MB_SFT clicks -> Cmd+click."""
-        LIB.T_key(MB_GUI, True)
-        LIB.T_key(MB_SFT, True)
-        LIB.T_key(MB_SFT, False)
+    def tearDown(self) -> None:
+        LIB.layer_move(LAYER_BASE)
 
-        clicks = [e for e in self.history() if e.keycode == KC_BTN1]
-        self.assertTrue(clicks, "the second key should still produce its click")
-        self.assertTrue(
-            all(e.mods == MOD_LGUI for e in clicks),
-            f"the click should carry Cmd, got {clicks}",
-        )
+    def hold(self, keycode: int) -> None:
+        LIB.T_smtd_touch(keycode)
+        LIB.T_smtd_hold(keycode, 0)
+
+    def test_a_hold_moves_to_its_layer_and_back(self) -> None:
+        self.hold(CKC_SPC)
+        self.assertEqual(layer_state(), 1 << LAYER_NUM)
+        LIB.T_smtd_release(CKC_SPC, 0)
+        self.assertEqual(layer_state(), 1 << LAYER_BASE)
+        self.assertEqual(layer_changes(), [1 << LAYER_NUM, 1 << LAYER_BASE])
+
+    def test_an_inner_release_returns_to_the_outer_hold(self) -> None:
+        self.hold(CKC_SPC)
+        self.hold(CKC_TAB)
+        self.assertEqual(layer_state(), 1 << LAYER_SYM)
+        LIB.T_smtd_release(CKC_TAB, 0)
+        self.assertEqual(layer_state(), 1 << LAYER_NUM)
+        LIB.T_smtd_release(CKC_SPC, 0)
+        self.assertEqual(layer_state(), 1 << LAYER_BASE)
+
+    def test_an_outer_release_leaves_the_inner_hold_in_charge(self) -> None:
+        self.hold(CKC_SPC)
+        self.hold(CKC_TAB)
+        LIB.T_smtd_release(CKC_SPC, 0)
+        self.assertEqual(layer_state(), 1 << LAYER_SYM, "still held")
+        LIB.T_smtd_release(CKC_TAB, 0)
+        self.assertEqual(layer_state(), 1 << LAYER_BASE, "both undone")
+        self.assertEqual(layer_changes(),
+                         [1 << LAYER_NUM, 1 << LAYER_SYM, 1 << LAYER_BASE],
+                         "and nothing in between")
+
+    def test_a_layer_raised_during_the_hold_survives_it(self) -> None:
+        self.hold(CKC_SPC)
+        LIB.T_mouse_layer(True)
+        LIB.T_smtd_release(CKC_SPC, 0)
+        self.assertTrue(LIB.T_layer_is(LAYER_BASE))
+        self.assertTrue(LIB.T_layer_is(LAYER_MBO))
+        LIB.T_mouse_layer(False)
 
-        # MB_GUI resolved to a modifier, so its own release must stay silent.
-        LIB.T_key(MB_GUI, False)
-        self.assertNotIn(
-            KC_BTN3, [e.keycode for e in self.history()],
-            "MB_GUI acted as a modifier and must not also click",
-        )
+    def test_a_hold_of_the_current_layer_changes_nothing(self) -> None:
+        LIB.layer_move(LAYER_NUM)
+        LIB.townk_trace_clear()
+        self.hold(CKC_SPC)
+        LIB.T_smtd_release(CKC_SPC, 0)
+        self.assertEqual(layer_changes(), [])
+
+    def test_layer_13_is_an_ordinary_layer(self) -> None:
+        """The old single slot used 13 to mean "nothing saved"."""
+        LIB.layer_move(13)
+        self.hold(CKC_SPC)
+        LIB.T_smtd_release(CKC_SPC, 0)
+        self.assertEqual(layer_state(), 1 << 13)
+
+    def test_a_release_without_a_hold_changes_nothing(self) -> None:
+        LIB.T_smtd_release(CKC_SPC, 0)
+        self.assertEqual(layer_state(), 1 << LAYER_BASE)
+        self.assertEqual(layer_changes(), [])
 
 
 class TownkLayersTest(unittest.TestCase):
@@ -877,5 +1296,228 @@ class TownkLayersTest(unittest.TestCase):
         )
 
 
+class TownkGameModeTest(unittest.TestCase):
+    """Game layers skip the typing pipeline (game_mode_fast_path()).
+
+    On _GAM1/_GAM2 a key is its keycode: no SM_TD, no MB_* roles, no typing
+    streak, no Caps Word, no key overrides.
+    """
+
+    def setUp(self) -> None:
+        LIB.TEST_reset()
+        LIB.T_reset()
+
+    def tearDown(self) -> None:
+        LIB.layer_move(LAYER_BASE)
+
+    def test_keys_outside_game_mode_take_the_pipeline(self) -> None:
+        self.assertFalse(LIB.T_game_key(0, True))
+        self.assertFalse(LIB.T_game_key(0, False))
+
+    def test_keys_on_a_game_layer_skip_it(self) -> None:
+        LIB.layer_move(LAYER_GAM1)
+        self.assertTrue(LIB.T_game_key(0, True))
+        self.assertTrue(LIB.T_game_key(0, False))
+
+    def test_a_key_held_into_game_mode_is_released_by_the_pipeline(self) -> None:
+        """sm_td saw the press, so it must see the release."""
+        self.assertFalse(LIB.T_game_key(1, True))
+        LIB.layer_move(LAYER_GAM1)
+        self.assertFalse(LIB.T_game_key(1, False))
+
+    def test_a_key_held_out_of_game_mode_is_released_past_it(self) -> None:
+        """TO(_BASE) is pressed on the game layer and released off it."""
+        LIB.layer_move(LAYER_GAM1)
+        self.assertTrue(LIB.T_game_key(2, True))
+        LIB.layer_move(LAYER_BASE)
+        self.assertTrue(LIB.T_game_key(2, False))
+        self.assertFalse(LIB.T_game_key(2, True))
+        self.assertFalse(LIB.T_game_key(2, False))
+
+    def test_caps_word_is_off_in_game_mode(self) -> None:
+        LIB.caps_word_on()
+        LIB.layer_move(LAYER_GAM1)
+        self.assertFalse(LIB.is_caps_word_on())
+        LIB.layer_move(LAYER_BASE)
+        self.assertFalse(LIB.is_caps_word_on())
+
+
+RGBLIGHT_LAYERS = 16
+RGB_LAYER_FRAME_MS = 16
+
+
+def rgb_segments() -> int:
+    """What the RGB layer segments show, bit n for segment n."""
+    return sum(1 << i for i in range(RGBLIGHT_LAYERS) if LIB.T_rgb_segment(i))
+
+
+def rgb_stats() -> tuple[int, int]:
+    """The segment write counters over raw HID: (written, skipped)."""
+    reply = hid(ID_CUSTOM_GET_VALUE, TOWNK_HID_RGB_LAYERS, 0)
+    return (int.from_bytes(reply[3:7], "big"), int.from_bytes(reply[7:11], "big"))
+
+
+def wait(ms: int) -> None:
+    """Let ms pass, running deferred tasks as QMK's housekeeping would."""
+    for _ in range(ms):
+        LIB.TEST_advance_time(1)
+        LIB.T_deferred_tick()
+
+
+class TownkRgbLayerTest(unittest.TestCase):
+    """RGB layer indicators follow the layer state (townk_layers.c).
+
+    Only the segments whose layer changed are written, once per frame: a _NAV
+    hold, flipped many times a second by SM_TD, must not rewrite all sixteen
+    each time, and a burst of changes must not hold up key processing.
+    """
+
+    def setUp(self) -> None:
+        LIB.TEST_reset()
+        LIB.T_reset()
+
+    def tearDown(self) -> None:
+        LIB.layer_move(LAYER_BASE)
+        wait(RGB_LAYER_FRAME_MS)
+
+    def test_segments_show_every_active_layer(self) -> None:
+        LIB.T_hold_backspace(True)
+        LIB.T_mouse_layer(True)
+        wait(RGB_LAYER_FRAME_MS)
+        self.assertEqual(rgb_segments(), layer_state())
+        LIB.layer_move(LAYER_GAM1)
+        wait(RGB_LAYER_FRAME_MS)
+        self.assertEqual(rgb_segments(), 1 << LAYER_GAM1)
+        LIB.layer_move(LAYER_BASE)
+        wait(RGB_LAYER_FRAME_MS)
+        self.assertEqual(rgb_segments(), 1 << LAYER_BASE)
+
+    def test_a_layer_change_writes_only_its_own_segment(self) -> None:
+        before = LIB.T_rgb_writes()
+        LIB.T_hold_backspace(True)
+        wait(RGB_LAYER_FRAME_MS)
+        LIB.T_hold_backspace(False)
+        wait(RGB_LAYER_FRAME_MS)
+        self.assertEqual(LIB.T_rgb_writes() - before, 2)
+        self.assertEqual(rgb_stats(), (2, 2 * RGBLIGHT_LAYERS - 2))
+
+    def test_an_unchanged_state_writes_nothing(self) -> None:
+        before = LIB.T_rgb_writes()
+        LIB.layer_move(LAYER_BASE)
+        wait(RGB_LAYER_FRAME_MS)
+        self.assertEqual(LIB.T_rgb_writes(), before)
+        self.assertEqual(rgb_stats(), (0, RGBLIGHT_LAYERS))
+
+    def test_the_key_path_writes_no_leds(self) -> None:
+        before = LIB.T_rgb_writes()
+        LIB.T_hold_backspace(True)
+        self.assertEqual(LIB.T_rgb_writes(), before)
+        self.assertFalse(rgb_segments() & (1 << LAYER_NAV))
+
+    def test_a_burst_of_changes_draws_only_the_last(self) -> None:
+        before = LIB.T_rgb_writes()
+        LIB.T_hold_backspace(True)
+        LIB.T_mouse_layer(True)
+        LIB.T_hold_backspace(False)
+        wait(RGB_LAYER_FRAME_MS)
+        self.assertEqual(LIB.T_rgb_writes() - before, 1)
+        self.assertEqual(rgb_segments(), layer_state())
+
+    def test_changes_keep_coming_but_the_frame_is_drawn_on_time(self) -> None:
+        """A steady stream of changes must not push the frame back forever."""
+        for _ in range(RGB_LAYER_FRAME_MS // 4):
+            LIB.T_hold_backspace(True)
+            wait(2)
+            LIB.T_hold_backspace(False)
+            wait(2)
+        written, skipped = rgb_stats()
+        self.assertEqual(written + skipped, RGBLIGHT_LAYERS, "one frame drawn")
+
+    def test_a_set_clears_the_counters(self) -> None:
+        LIB.T_hold_backspace(True)
+        wait(RGB_LAYER_FRAME_MS)
+        reply = hid(ID_CUSTOM_SET_VALUE, TOWNK_HID_RGB_LAYERS, 0)
+        self.assertEqual(reply[0], ID_CUSTOM_SET_VALUE)
+        self.assertEqual(rgb_stats(), (0, 0))
+
+
+# QMK's values; the fixture's keymap holds plain numbers.
+KC_TRNS = 0x0001
+KC_A = 0x0004
+KC_B = 0x0005
+KC_C = 0x0006
+
+
+class TownkKeycacheTest(unittest.TestCase):
+    """Transparency-resolved keycodes per position (townk_keycache.c).
+
+    sm_td asks for a key on the highest active layer only; through the cache
+    a _______ there answers with what QMK's layer walk would find, for one
+    keymap read.
+    """
+
+    def setUp(self) -> None:
+        LIB.TEST_reset()
+        LIB.T_reset()
+        LIB.T_keymap_set(LAYER_BASE, 0, KC_A)
+        LIB.T_keymap_set(LAYER_NAV, 0, KC_B)
+        LIB.T_keymap_set(LAYER_MBO, 0, KC_TRNS)
+
+    def tearDown(self) -> None:
+        LIB.layer_move(LAYER_BASE)
+
+    def test_a_transparent_key_takes_the_next_active_layer(self) -> None:
+        """_MBO's _______ thumb defers to _NAV while the pad holds it."""
+        LIB.T_hold_backspace(True)
+        LIB.T_mouse_layer(True)
+        self.assertEqual(LIB.T_keycache_keycode(0), KC_B)
+        LIB.T_hold_backspace(False)
+        self.assertEqual(LIB.T_keycache_keycode(0), KC_A)
+
+    def test_only_the_highest_layer_is_resolved(self) -> None:
+        LIB.T_hold_backspace(True)
+        LIB.T_mouse_layer(True)
+        self.assertEqual(LIB.T_keycache_layer_keycode(LAYER_MBO, 0), KC_B)
+        self.assertEqual(LIB.T_keycache_layer_keycode(LAYER_BASE, 0), KC_A)
+
+    def test_default_layers_count(self) -> None:
+        LIB.T_keymap_set(LAYER_GAM1, 0, KC_C)
+        LIB.T_keymap_set(LAYER_GAM1, 1, KC_TRNS)
+        LIB.T_keymap_set(LAYER_BASE, 1, KC_A)
+        LIB.T_default_layer_set(LAYER_GAM1)
+        self.assertEqual(LIB.T_keycache_keycode(0), KC_C)
+        self.assertEqual(LIB.T_keycache_keycode(1), KC_A)
+        LIB.T_default_layer_set(LAYER_BASE)
+        self.assertEqual(LIB.T_keycache_keycode(0), KC_A)
+
+    def test_a_lookup_is_one_keymap_read(self) -> None:
+        LIB.T_hold_backspace(True)
+        LIB.T_mouse_layer(True)
+        before = LIB.T_keymap_reads()
+        LIB.T_keycache_keycode(0)
+        self.assertEqual(LIB.T_keymap_reads() - before, 1)
+
+    def test_a_change_below_the_source_resolves_nothing(self) -> None:
+        """An opaque _MBO hides _NAV flipping under it."""
+        for col in range(4):
+            LIB.T_keymap_set(LAYER_MBO, col, KC_C)
+        LIB.T_mouse_layer(True)
+        before = LIB.T_keymap_reads()
+        LIB.T_hold_backspace(True)
+        LIB.T_hold_backspace(False)
+        self.assertEqual(LIB.T_keymap_reads(), before)
+        LIB.T_mouse_layer(False)
+        self.assertGreater(LIB.T_keymap_reads(), before)
+        self.assertEqual(LIB.T_keycache_keycode(0), KC_A)
+
+    def test_a_key_remapped_transparent_is_resolved_again(self) -> None:
+        """A VIA/Vial edit needs no layer change to be seen."""
+        LIB.T_keymap_set(LAYER_MBO, 0, KC_C)
+        LIB.T_hold_backspace(True)
+        LIB.T_mouse_layer(True)
+        self.assertEqual(LIB.T_keycache_keycode(0), KC_C)
+        LIB.T_keymap_set(LAYER_MBO, 0, KC_TRNS)
+        self.assertEqual(LIB.T_keycache_keycode(0), KC_B)
+
 if __name__ == "__main__":
     _ = unittest.main(verbosity=2)
@@ -0,0 +1,52 @@
+"""Batched event scenarios for the userspace input pipeline.
+
+Every tests/scenarios/*.scn file is a list of scenarios -- event scripts and
+the events and state they must produce -- in the format documented at the top
+of tests/townk_scenarios.c. That native runner executes all of them in one
+process; this module only builds it, runs it once, and reports each scenario
+as a unittest subtest, so a failure names its file, line and reason.
+
+    python3 tests/run_tests.py
+"""
+
+import glob
+import os
+import subprocess
+import unittest
+
+import townk_build
+
+TESTS = os.path.dirname(os.path.abspath(__file__))
+SCENARIOS = sorted(glob.glob(os.path.join(TESTS, "scenarios", "*.scn")))
+
+
+def _run() -> list[tuple[str, bool, str]]:
+    """Run every scenario file; (name, passed, reason) per scenario."""
+    exe = os.path.join(TESTS, "townk_scenarios")
+    townk_build.build(exe, os.path.join(TESTS, "townk_scenarios.c"), "-O1")
+
+    files = [os.path.relpath(path, TESTS) for path in SCENARIOS]
+    out = subprocess.run([exe, *files], stdout=subprocess.PIPE,
+                         stderr=subprocess.PIPE, cwd=TESTS)
+    if out.returncode not in (0, 1):
+        raise RuntimeError("scenario runner failed:\n" + out.stderr.decode())
+
+    results: list[tuple[str, bool, str]] = []
+    for line in out.stdout.decode().splitlines():
+        if line.startswith(("ok ", "FAIL ")):
+            status, name = line.split(" ", 1)
+            results.append((name, status == "ok", ""))
+        elif line.startswith("    ") and results:
+            name, passed, reason = results[-1]
+            results[-1] = (name, passed, reason + line[4:] + "\n")
+    return results
+
+
+class TownkScenarioTest(unittest.TestCase):
+    def test_scenarios(self) -> None:
+        results = _run()
+        self.assertTrue(results, "no scenarios found in tests/scenarios/")
+        for name, passed, reason in results:
+            with self.subTest(name):
+                if not passed:
+                    self.fail(reason)
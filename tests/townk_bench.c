@@ -0,0 +1,620 @@
+/* Host-compiled throughput benchmark for the userspace hot path.
+ *
+ * Builds on tests/townk_mouse_layout.c -- the same stubs, the same REAL
+ * townk_mouse.c, townk_mods.c, townk_smtd.c and townk_layers.c -- and adds a
+ * main() that replays millions of synthetic events through the entry
+ * points that run on every keypress or pointing report:
+ *
+ *   process_special_mouse_keys()   every key event, via process_record_user()
+ *   on_smtd_action()               every SM_TD touch / tap / hold / release
+ *   pointing_device_task_kb()      every trackball report
+ *   layer_state_set_user()         every layer transition
+ *   mods_acquire() / mods_release() every modifier claim an MB_* key, a
+ *                                  click or Smart Shift makes
+ *
+ * and, for the game layers, the same key stream twice through
+ * process_record_townk(), the pipeline process_record_user() runs: once off
+ * the game layers, through every stage (game_keys_pipeline), once on _GAM1,
+ * through the game-mode switch and SOCD resolution that replace them
+ * (game_keys_fast_path). Both include sending the key: process_socd()
+ * registers the WASD keys itself, and every other key, on either path, is
+ * registered as QMK would once the hook returns true.
+ *
+ * sm_td itself is not compiled on the host. bench_process_smtd() stands in
+ * for process_smtd() with the work sm_td does for every record at the
+ * least: the keycode lookup through the keycode cache, a scan of its state
+ * pool by matrix position, and the replay of the record through the
+ * pipeline once it has let the key go. The real thing does more -- timers,
+ * on_smtd_action() -- so the pipeline figure is a floor.
+ *
+ * The event streams are generated from a fixed seed, so every run replays the
+ * identical "recording" and two runs are comparable. Each stream is made of
+ * whole gestures (every press has its release), replayed in chunks small
+ * enough that the shim's bounded event history never fills; the engine is
+ * reset between chunks, outside the timed region.
+ *
+ * Prints one JSON object on stdout, ns per event for each entry point. Built
+ * and compared against a saved baseline by tests/run_bench.py; not part of any
+ * firmware build.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "townk_mouse_layout.c"
+
+static bool bench_process_smtd(uint16_t keycode, keyrecord_t *record);
+
+/* The real pipeline, with sm_td's cost played by the stand-in below. */
+#define process_smtd(keycode, record) bench_process_smtd((keycode), (record))
+#include "../users/townk/townk_record.c"
+#undef process_smtd
+
+/** Events per entry point per pass; override with argv[1]. */
+#define BENCH_DEFAULT_EVENTS 2000000
+
+/** Passes per entry point. The fastest is reported: noise only ever adds. */
+#define BENCH_PASSES 5
+
+/** Events per timed chunk. Each chunk emits at most one record per event, so
+ * this stays under the shim's history bound with room to spare. */
+#define BENCH_CHUNK 64
+
+/* ------------------------------------------------------------------------ *
+ * Deterministic event source
+ * ------------------------------------------------------------------------ */
+
+static uint32_t bench_rng = 0x9E3779B9u;
+
+/* xorshift32: fast, seedable, and identical on every host. */
+static uint32_t bench_next(void) {
+    bench_rng ^= bench_rng << 13;
+    bench_rng ^= bench_rng >> 17;
+    bench_rng ^= bench_rng << 5;
+    return bench_rng;
+}
+
+static uint32_t bench_pick(uint32_t n) {
+    return bench_next() % n;
+}
+
+static const uint16_t bench_mb_keys[]   = {MB_SFT, MB_ALT, MB_GUI, MB_CTL};
+static const uint16_t bench_smtd_keys[] = {CKC_SPC, CKC_TAB, CKC_BKTAB, CKC_BSPC, CKC_SMSFT};
+
+#define BENCH_COUNT(array) (sizeof(array) / sizeof((array)[0]))
+
+/* ------------------------------------------------------------------------ *
+ * Event streams, one per entry point
+ * ------------------------------------------------------------------------ */
+
+typedef struct {
+    uint16_t    keycode;
+    keyrecord_t record;
+} bench_key_t;
+
+typedef struct {
+    uint16_t    keycode;
+    smtd_action action;
+    uint8_t     tap_count;
+} bench_smtd_t;
+
+typedef struct {
+    report_mouse_t report;
+} bench_pointing_t;
+
+typedef struct {
+    layer_state_t state;
+} bench_layer_t;
+
+typedef struct {
+    uint8_t mods;
+    bool    acquire;
+} bench_mods_t;
+
+/** A stream is cut into chunks at gesture boundaries; chunk_end[i] marks the
+ * last event of a chunk, after which the engine is reset untimed. */
+typedef struct {
+    size_t count;
+    bool  *chunk_end;
+} bench_stream_t;
+
+static void bench_push_key(bench_key_t *events, size_t *n, uint16_t keycode, bool pressed) {
+    events[*n].keycode = keycode;
+    events[*n].record  = (keyrecord_t){.event = MAKE_KEYEVENT(0, 0, pressed)};
+    (*n)++;
+}
+
+/* Every gesture the MB_* engine resolves, in the mix a mouse-heavy session
+ * produces: clicks, modifier use, multi-key chords, and plain typing passing
+ * straight through. */
+static void bench_fill_keys(bench_key_t *events, bench_stream_t *stream, size_t total) {
+    size_t n = 0, chunk_start = 0;
+
+    while (n + 4 <= total) {
+        uint16_t mb    = bench_mb_keys[bench_pick(BENCH_COUNT(bench_mb_keys))];
+        uint16_t other = bench_mb_keys[bench_pick(BENCH_COUNT(bench_mb_keys))];
+
+        switch (bench_pick(4)) {
+            case 0: /* tap alone: a click */
+                bench_push_key(events, &n, mb, true);
+                bench_push_key(events, &n, mb, false);
+                break;
+            case 1: /* hold + another key: a modifier */
+                bench_push_key(events, &n, mb, true);
+                bench_push_key(events, &n, KC_A, true);
+                bench_push_key(events, &n, KC_A, false);
+                bench_push_key(events, &n, mb, false);
+                break;
+            case 2: { /* ordinary typing, not ours */
+                uint16_t letter = (uint16_t)(KC_A + bench_pick(26));
+                bench_push_key(events, &n, letter, true);
+                bench_push_key(events, &n, letter, false);
+                break;
+            }
+            default: /* two MB_* keys: modifier + click */
+                if (other == mb) other = (mb == MB_SFT) ? MB_GUI : MB_SFT;
+                bench_push_key(events, &n, mb, true);
+                bench_push_key(events, &n, other, true);
+                bench_push_key(events, &n, other, false);
+                bench_push_key(events, &n, mb, false);
+                break;
+        }
+
+        if (n - chunk_start >= BENCH_CHUNK - 4) {
+            stream->chunk_end[n - 1] = true;
+            chunk_start              = n;
+        }
+    }
+
+    stream->chunk_end[n - 1] = true;
+    stream->count            = n;
+}
+
+/* Taps and holds across every SM_TD key, including tap-then-hold (a nonzero
+ * tap_count on the hold), which takes the other arm of SMTD_LIMIT. */
+static void bench_fill_smtd(bench_smtd_t *events, bench_stream_t *stream, size_t total) {
+    size_t n = 0, chunk_start = 0;
+
+    while (n + 3 <= total) {
+        uint16_t keycode   = bench_smtd_keys[bench_pick(BENCH_COUNT(bench_smtd_keys))];
+        uint8_t  tap_count = (uint8_t)(bench_pick(4) == 0);
+
+        events[n++] = (bench_smtd_t){keycode, SMTD_ACTION_TOUCH, tap_count};
+        if (bench_pick(3) == 0) {
+            events[n++] = (bench_smtd_t){keycode, SMTD_ACTION_HOLD, tap_count};
+            events[n++] = (bench_smtd_t){keycode, SMTD_ACTION_RELEASE, tap_count};
+        } else {
+            events[n++] = (bench_smtd_t){keycode, SMTD_ACTION_TAP, tap_count};
+        }
+
+        if (n - chunk_start >= BENCH_CHUNK - 3) {
+            stream->chunk_end[n - 1] = true;
+            chunk_start              = n;
+        }
+    }
+
+    stream->chunk_end[n - 1] = true;
+    stream->count            = n;
+}
+
+/* Mostly small deliberate motion, some resting jitter and idle reports, and
+ * the occasional scroll -- what a hand on two trackballs actually emits. */
+static void bench_fill_pointing(bench_pointing_t *events, bench_stream_t *stream, size_t total) {
+    for (size_t n = 0; n < total; n++) {
+        report_mouse_t report = {0};
+
+        switch (bench_pick(8)) {
+            case 0: /* idle */
+                break;
+            case 1: /* resting jitter */
+                report.x = (mouse_xy_report_t)(bench_pick(3) - 1);
+                break;
+            case 2: /* scroll */
+                report.v = (int8_t)(bench_pick(5) - 2);
+                report.h = (int8_t)(bench_pick(3) - 1);
+                break;
+            case 3: /* fast flick */
+                report.x = (mouse_xy_report_t)(bench_pick(512) - 256);
+                report.y = (mouse_xy_report_t)(bench_pick(512) - 256);
+                break;
+            default: /* ordinary motion */
+                report.x = (mouse_xy_report_t)(bench_pick(21) - 10);
+                report.y = (mouse_xy_report_t)(bench_pick(21) - 10);
+                break;
+        }
+
+        events[n].report    = report;
+        stream->chunk_end[n] = ((n + 1) % BENCH_CHUNK) == 0;
+    }
+
+    stream->chunk_end[total - 1] = true;
+    stream->count                = total;
+}
+
+/* A random walk over the layer states this keymap actually reaches: thumb
+ * holds over _BASE, the mouse layer, and trips in and out of a game layer. */
+static void bench_fill_layers(bench_layer_t *events, bench_stream_t *stream, size_t total) {
+    static const layer_state_t reachable[] = {
+        1u << _BASE,
+        (1u << _BASE) | (1u << _NUM),
+        (1u << _BASE) | (1u << _SYM),
+        (1u << _BASE) | (1u << _NAV),
+        (1u << _BASE) | (1u << _FUN),
+        (1u << _BASE) | (1u << _MBO),
+        (1u << _BASE) | (1u << _MBO) | (1u << _NAV),
+        1u << _GAM1,
+        1u << _GAM2,
+        1u << _QWT,
+    };
+
+    for (size_t n = 0; n < total; n++) {
+        events[n].state      = reachable[bench_pick(BENCH_COUNT(reachable))];
+        stream->chunk_end[n] = ((n + 1) % BENCH_CHUNK) == 0;
+    }
+
+    stream->chunk_end[total - 1] = true;
+    stream->count                = total;
+}
+
+/* WASD and Space, pressed and released in overlapping pairs the way a
+ * player moves and jumps, at the fixture's four matrix columns. */
+static void bench_fill_game(bench_key_t *events, bench_stream_t *stream, size_t total) {
+    static const uint16_t keys[] = {KC_W, KC_A, KC_S, KC_D};
+    size_t                n      = 0;
+
+    while (n + 4 <= total) {
+        uint8_t first  = (uint8_t)bench_pick(4);
+        uint8_t second = (uint8_t)((first + 1 + bench_pick(3)) % 4);
+
+        events[n++] = (bench_key_t){keys[first], {.event = MAKE_KEYEVENT(0, first, true)}};
+        events[n++] = (bench_key_t){keys[second], {.event = MAKE_KEYEVENT(0, second, true)}};
+        events[n++] = (bench_key_t){keys[first], {.event = MAKE_KEYEVENT(0, first, false)}};
+        events[n++] = (bench_key_t){keys[second], {.event = MAKE_KEYEVENT(0, second, false)}};
+        stream->chunk_end[n - 1] = (n % BENCH_CHUNK) == 0;
+    }
+
+    stream->chunk_end[n - 1] = true;
+    stream->count            = n;
+}
+
+/* Nested claims, at most four deep, each released in reverse: one modifier
+ * most of the time (an MB_* key resolving), sometimes two or three at once
+ * (a drag, a contributed click modifier, overlapping Shifts). */
+static void bench_fill_mods(bench_mods_t *events, bench_stream_t *stream, size_t total) {
+    static const uint8_t masks[] = {
+        MOD_BIT(KC_LSFT),
+        MOD_BIT(KC_LALT),
+        MOD_BIT(KC_LGUI),
+        MOD_BIT(KC_LCTL),
+        MOD_BIT(KC_LALT) | MOD_BIT(KC_LGUI),
+        MOD_BIT(KC_LSFT) | MOD_BIT(KC_LCTL),
+        MOD_BIT(KC_LSFT) | MOD_BIT(KC_LALT) | MOD_BIT(KC_LGUI),
+    };
+    uint8_t held[4];
+    size_t  depth = 0, n = 0, chunk_start = 0;
+
+    while (n + 1 + depth < total) {
+        if (depth < BENCH_COUNT(held) && (depth == 0 || bench_pick(2) == 0)) {
+            held[depth] = masks[bench_pick(BENCH_COUNT(masks))];
+            events[n++] = (bench_mods_t){held[depth++], true};
+        } else {
+            events[n++] = (bench_mods_t){held[--depth], false};
+        }
+
+        if (depth == 0 && n - chunk_start >= BENCH_CHUNK - 8) {
+            stream->chunk_end[n - 1] = true;
+            chunk_start              = n;
+        }
+    }
+
+    while (depth > 0) {
+        events[n++] = (bench_mods_t){held[--depth], false};
+    }
+
+    stream->chunk_end[n - 1] = true;
+    stream->count            = n;
+}
+
+/* ------------------------------------------------------------------------ *
+ * Timing
+ * ------------------------------------------------------------------------ */
+
+static uint64_t bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/** Untimed: between chunks, clear the recorded history and the engine. */
+static void bench_reset(void) {
+    TEST_reset();
+    T_reset();
+}
+
+/* Keeps the optimiser from discarding a result nobody reads. */
+static volatile int32_t bench_sink;
+
+static uint64_t bench_run_keys(const bench_key_t *events, const bench_stream_t *stream) {
+    uint64_t total = 0, start = bench_now_ns();
+
+    for (size_t i = 0; i < stream->count; i++) {
+        keyrecord_t record = events[i].record;
+        bench_sink += process_special_mouse_keys(events[i].keycode, &record);
+        if (stream->chunk_end[i]) {
+            total += bench_now_ns() - start;
+            bench_reset();
+            start = bench_now_ns();
+        }
+    }
+
+    return total;
+}
+
+static uint64_t bench_run_smtd(const bench_smtd_t *events, const bench_stream_t *stream) {
+    uint64_t total = 0, start = bench_now_ns();
+
+    for (size_t i = 0; i < stream->count; i++) {
+        bench_sink += on_smtd_action(events[i].keycode, events[i].action, events[i].tap_count);
+        if (stream->chunk_end[i]) {
+            total += bench_now_ns() - start;
+            bench_reset();
+            start = bench_now_ns();
+        }
+    }
+
+    return total;
+}
+
+static uint64_t bench_run_pointing(const bench_pointing_t *events, const bench_stream_t *stream) {
+    uint64_t total = 0, start;
+    size_t   chunk = 0;
+
+    /* Half the chunks run with an MB_* key held, so the conversion loop is
+     * exercised rather than skipped. Pressing it is setup, not measured. */
+    T_key(MB_GUI, true);
+    start = bench_now_ns();
+
+    for (size_t i = 0; i < stream->count; i++) {
+        bench_sink += pointing_device_task_kb(events[i].report).x;
+        if (stream->chunk_end[i]) {
+            total += bench_now_ns() - start;
+            bench_reset();
+            if (++chunk % 2 == 0) {
+                T_key(bench_mb_keys[chunk / 2 % BENCH_COUNT(bench_mb_keys)], true);
+            }
+            start = bench_now_ns();
+        }
+    }
+
+    return total;
+}
+
+static uint64_t bench_run_layers(const bench_layer_t *events, const bench_stream_t *stream) {
+    uint64_t total = 0, start = bench_now_ns();
+
+    for (size_t i = 0; i < stream->count; i++) {
+        bench_sink += (int32_t)layer_state_set_user(events[i].state);
+        if (stream->chunk_end[i]) {
+            total += bench_now_ns() - start;
+            bench_reset();
+            start = bench_now_ns();
+        }
+    }
+
+    return total;
+}
+
+static uint64_t bench_run_mods(const bench_mods_t *events, const bench_stream_t *stream) {
+    uint64_t total = 0, start = bench_now_ns();
+
+    for (size_t i = 0; i < stream->count; i++) {
+        if (events[i].acquire) {
+            mods_acquire(events[i].mods);
+        } else {
+            mods_release(events[i].mods);
+        }
+        if (stream->chunk_end[i]) {
+            bench_sink += get_mods();
+            total += bench_now_ns() - start;
+            bench_reset();
+            start = bench_now_ns();
+        }
+    }
+
+    return total;
+}
+
+/** Untimed: a reset lands on _BASE, so go back to the game layer. */
+static void bench_reset_game(void) {
+    bench_reset();
+    layer_move(_GAM1);
+}
+
+/** QMK's process_record(): the userspace pipeline, then sending the key. */
+static void bench_process_record(uint16_t keycode, keyrecord_t *record) {
+    if (process_record_townk(keycode, record)) {
+        if (record->event.pressed) {
+            register_code16(keycode);
+        } else {
+            unregister_code16(keycode);
+        }
+    }
+}
+
+/* sm_td's state pool, by matrix position: its SMTD_POOL_SIZE default. */
+#define BENCH_SMTD_POOL 10
+static keypos_t bench_smtd_pool[BENCH_SMTD_POOL];
+static bool     bench_smtd_used[BENCH_SMTD_POOL];
+
+/* What process_smtd() costs a key that is no SM_TD key, which is every game
+ * key: find its keycode and its state, then, with nothing to wait for,
+ * replay it through the pipeline at once. */
+static bool bench_process_smtd(uint16_t keycode, keyrecord_t *record) {
+    if (smtd_replaying()) {
+        return true;
+    }
+
+    keypos_t key = record->event.key;
+    bench_sink += keycache_layer_keycode(get_highest_layer(layer_state), key);
+
+    uint8_t slot = BENCH_SMTD_POOL, free = BENCH_SMTD_POOL;
+    for (uint8_t i = 0; i < BENCH_SMTD_POOL; i++) {
+        if (!bench_smtd_used[i]) {
+            free = free == BENCH_SMTD_POOL ? i : free;
+        } else if (bench_smtd_pool[i].row == key.row && bench_smtd_pool[i].col == key.col) {
+            slot = i;
+        }
+    }
+    if (record->event.pressed && slot == BENCH_SMTD_POOL && free != BENCH_SMTD_POOL) {
+        bench_smtd_pool[free] = key;
+        bench_smtd_used[free] = true;
+    } else if (!record->event.pressed && slot != BENCH_SMTD_POOL) {
+        bench_smtd_used[slot] = false;
+    }
+
+    smtd_replay_begin();
+    bench_process_record(keycode, record);
+    smtd_replay_end();
+    return false;
+}
+
+/* The game keys off the game layers: every stage process_record_user() runs. */
+static uint64_t bench_run_game_pipeline(const bench_key_t *events, const bench_stream_t *stream) {
+    uint64_t total = 0, start = bench_now_ns();
+
+    for (size_t i = 0; i < stream->count; i++) {
+        keyrecord_t record = events[i].record;
+        bench_process_record(events[i].keycode, &record);
+        if (stream->chunk_end[i]) {
+            total += bench_now_ns() - start;
+            bench_reset();
+            start = bench_now_ns();
+        }
+    }
+
+    return total;
+}
+
+/* The same keys on _GAM1: game mode and SOCD in place of the stages. */
+static uint64_t bench_run_game_fast_path(const bench_key_t *events, const bench_stream_t *stream) {
+    uint64_t total = 0, start = bench_now_ns();
+
+    for (size_t i = 0; i < stream->count; i++) {
+        keyrecord_t record = events[i].record;
+        bench_process_record(events[i].keycode, &record);
+        if (stream->chunk_end[i]) {
+            total += bench_now_ns() - start;
+            bench_reset_game();
+            start = bench_now_ns();
+        }
+    }
+
+    return total;
+}
+
+/** What one empty chunk costs: two clock reads. Subtracted from every chunk. */
+static double bench_chunk_overhead_ns(void) {
+    uint64_t best = UINT64_MAX;
+
+    for (int i = 0; i < 10000; i++) {
+        uint64_t start = bench_now_ns();
+        uint64_t end   = bench_now_ns();
+        if (end - start < best) best = end - start;
+    }
+
+    return (double)best;
+}
+
+static size_t bench_chunks(const bench_stream_t *stream) {
+    size_t chunks = 0;
+    for (size_t i = 0; i < stream->count; i++) {
+        chunks += stream->chunk_end[i];
+    }
+    return chunks;
+}
+
+static double bench_ns_per_event(uint64_t best_ns, const bench_stream_t *stream, double overhead_ns) {
+    double ns = (double)best_ns - overhead_ns * (double)bench_chunks(stream);
+    return (ns < 0 ? 0 : ns) / (double)stream->count;
+}
+
+#define BENCH_MIN(a, b) ((a) < (b) ? (a) : (b))
+
+int main(int argc, char **argv) {
+    size_t total = (argc > 1) ? (size_t)strtoul(argv[1], NULL, 10) : BENCH_DEFAULT_EVENTS;
+    if (total < BENCH_CHUNK) total = BENCH_CHUNK;
+
+    bench_key_t      *keys     = calloc(total, sizeof(*keys));
+    bench_smtd_t     *smtd     = calloc(total, sizeof(*smtd));
+    bench_pointing_t *pointing = calloc(total, sizeof(*pointing));
+    bench_layer_t    *layers   = calloc(total, sizeof(*layers));
+    bench_mods_t     *mods     = calloc(total, sizeof(*mods));
+    bench_key_t      *game     = calloc(total, sizeof(*game));
+    bench_stream_t    key_stream      = {.chunk_end = calloc(total, sizeof(bool))};
+    bench_stream_t    smtd_stream     = {.chunk_end = calloc(total, sizeof(bool))};
+    bench_stream_t    pointing_stream = {.chunk_end = calloc(total, sizeof(bool))};
+    bench_stream_t    layer_stream    = {.chunk_end = calloc(total, sizeof(bool))};
+    bench_stream_t    mods_stream     = {.chunk_end = calloc(total, sizeof(bool))};
+    bench_stream_t    game_stream     = {.chunk_end = calloc(total, sizeof(bool))};
+
+    if (!keys || !smtd || !pointing || !layers || !mods || !game || !key_stream.chunk_end || !smtd_stream.chunk_end || !pointing_stream.chunk_end || !layer_stream.chunk_end || !mods_stream.chunk_end || !game_stream.chunk_end) {
+        fprintf(stderr, "out of memory for %zu events\n", total);
+        return 1;
+    }
+
+    bench_fill_keys(keys, &key_stream, total);
+    bench_fill_smtd(smtd, &smtd_stream, total);
+    bench_fill_pointing(pointing, &pointing_stream, total);
+    bench_fill_layers(layers, &layer_stream, total);
+    bench_fill_mods(mods, &mods_stream, total);
+    bench_fill_game(game, &game_stream, total);
+
+    uint64_t best_keys = UINT64_MAX, best_smtd = UINT64_MAX, best_pointing = UINT64_MAX, best_layers = UINT64_MAX, best_mods = UINT64_MAX;
+    uint64_t best_game_pipeline = UINT64_MAX, best_game_fast = UINT64_MAX;
+
+    for (int pass = 0; pass < BENCH_PASSES; pass++) {
+        bench_reset();
+        best_keys = BENCH_MIN(best_keys, bench_run_keys(keys, &key_stream));
+        bench_reset();
+        best_smtd = BENCH_MIN(best_smtd, bench_run_smtd(smtd, &smtd_stream));
+        bench_reset();
+        best_pointing = BENCH_MIN(best_pointing, bench_run_pointing(pointing, &pointing_stream));
+        bench_reset();
+        best_layers = BENCH_MIN(best_layers, bench_run_layers(layers, &layer_stream));
+        bench_reset();
+        best_mods = BENCH_MIN(best_mods, bench_run_mods(mods, &mods_stream));
+        bench_reset();
+        best_game_pipeline = BENCH_MIN(best_game_pipeline, bench_run_game_pipeline(game, &game_stream));
+        bench_reset_game();
+        best_game_fast = BENCH_MIN(best_game_fast, bench_run_game_fast_path(game, &game_stream));
+    }
+    bench_reset();
+
+    double overhead = bench_chunk_overhead_ns();
+
+    printf("{\n");
+    printf("  \"process_special_mouse_keys\": {\"events\": %zu, \"ns_per_event\": %.3f},\n", key_stream.count, bench_ns_per_event(best_keys, &key_stream, overhead));
+    printf("  \"on_smtd_action\": {\"events\": %zu, \"ns_per_event\": %.3f},\n", smtd_stream.count, bench_ns_per_event(best_smtd, &smtd_stream, overhead));
+    printf("  \"pointing_device_task_kb\": {\"events\": %zu, \"ns_per_event\": %.3f},\n", pointing_stream.count, bench_ns_per_event(best_pointing, &pointing_stream, overhead));
+    printf("  \"layer_state_set_user\": {\"events\": %zu, \"ns_per_event\": %.3f},\n", layer_stream.count, bench_ns_per_event(best_layers, &layer_stream, overhead));
+    printf("  \"mods_acquire_release\": {\"events\": %zu, \"ns_per_event\": %.3f},\n", mods_stream.count, bench_ns_per_event(best_mods, &mods_stream, overhead));
+    printf("  \"game_keys_pipeline\": {\"events\": %zu, \"ns_per_event\": %.3f},\n", game_stream.count, bench_ns_per_event(best_game_pipeline, &game_stream, overhead));
+    printf("  \"game_keys_fast_path\": {\"events\": %zu, \"ns_per_event\": %.3f}\n", game_stream.count, bench_ns_per_event(best_game_fast, &game_stream, overhead));
+    printf("}\n");
+
+    free(keys);
+    free(smtd);
+    free(pointing);
+    free(layers);
+    free(mods);
+    free(game);
+    free(key_stream.chunk_end);
+    free(smtd_stream.chunk_end);
+    free(pointing_stream.chunk_end);
+    free(layer_stream.chunk_end);
+    free(mods_stream.chunk_end);
+    free(game_stream.chunk_end);
+
+    return 0;
+}
@@ -0,0 +1,60 @@
+"""Compile the host fixture, and what is built on it, only when stale.
+
+tests/townk_mouse_layout.c is the base of the test library, the scenario
+runner, the benchmark and the fuzz target; all of them compile the real
+userspace sources with the same include paths and warnings, kept here so they
+cannot drift apart. A build whose output is newer than every source it could
+depend on is skipped, so each test module that loads a fixture pays for the
+compiler once per change rather than once per run.
+"""
+
+import os
+import subprocess
+
+TESTS = os.path.dirname(os.path.abspath(__file__))
+REPO = os.path.abspath(os.path.join(TESTS, ".."))
+SUBMODULE = os.path.join(REPO, "modules", "stasmarkin")
+
+FLAGS = [
+    "-I" + TESTS,
+    "-I" + SUBMODULE,
+    "-I" + os.path.join(SUBMODULE, "sm_td"),  # townk_smtd.c includes "sm_td.h"
+    "-I" + os.path.join(TESTS, "stubs"),
+    "-DSMTD_UNIT_TEST",
+    "-std=c11", "-D_POSIX_C_SOURCE=199309L",
+    # -Werror on purpose: a warning in this firmware is a defect, and the
+    # host build is the cheapest place to catch one.
+    "-Wall", "-Wextra", "-Werror",
+    "-Wno-sign-compare", "-Wno-missing-braces", "-Wno-unused-parameter",
+]
+
+# Everything a fixture build can read: the userspace, the fixture and its
+# stubs, the SM_TD shim, and the scripts holding the compiler options.
+_SOURCE_DIRS = (os.path.join(REPO, "users", "townk"), TESTS, SUBMODULE)
+_SOURCE_EXTS = (".c", ".h", ".py")
+
+
+def _newest_source() -> float:
+    newest = 0.0
+    for top in _SOURCE_DIRS:
+        for root, dirs, files in os.walk(top):
+            dirs[:] = [d for d in dirs
+                       if not d.startswith((".", "__")) and d != "fuzz_corpus"]
+            for name in files:
+                if name.endswith(_SOURCE_EXTS):
+                    newest = max(newest, os.path.getmtime(os.path.join(root, name)))
+    return newest
+
+
+def build(output: str, source: str, *options: str) -> None:
+    """Compile source into output with FLAGS, unless output is up to date."""
+    if os.path.exists(output) and os.path.getmtime(output) >= _newest_source():
+        return
+
+    cmd = ["clang", *options, "-o", output, source, *FLAGS]
+    result = subprocess.run(cmd, stderr=subprocess.PIPE)
+    if result.returncode != 0:
+        raise RuntimeError(
+            f"failed to compile {os.path.relpath(source, REPO)}:\n"
+            + result.stderr.decode()
+        )
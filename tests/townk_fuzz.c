@@ -0,0 +1,429 @@
+/* Coverage-guided fuzz target for the whole userspace input pipeline.
+ *
+ * Builds on tests/townk_mouse_layout.c -- the same stubs, the same REAL
+ * townk_mouse.c, townk_mods.c, townk_smtd.c and townk_layers.c -- and turns
+ * each fuzz input into a sequence of what the board would see: key presses
+ * and releases through process_record_townk() -- the pipeline
+ * process_record_user() runs, game mode and SOCD included -- SM_TD holds,
+ * trackball reports, layer moves, the auto-mouse setting being flipped, and
+ * time passing. A key the pipeline hands back to QMK is registered, as QMK
+ * would. After every step it checks the invariants no sequence may break:
+ *
+ *   - once every key is up, no modifier claim is left (mods_claim_count()),
+ *     no modifier is registered, no key or mouse button is held down, no
+ *     layer-tap hold is left on the layer stack, and no layer a layer-tap
+ *     holds is on -- only the default and the toggled layers remain;
+ *   - outside the game layers, auto_mouse is whatever the user last set it
+ *     to; inside them, it is off.
+ *
+ * Any violation aborts with a one-line reason, which libFuzzer reports as a
+ * crash and saves the input that caused it. Built and run by
+ * tests/run_fuzz.py; not part of any firmware build.
+ *
+ * SM_TD itself is not compiled in. The target plays its part, as
+ * fuzz_process_smtd() in place of process_smtd(), by the contract
+ * on_smtd_action() is written against: every press of an SM_TD key is
+ * touched, then either tapped (released before it resolved) or held and
+ * later released. Other keys pass through; SM_TD's own buffering and replay
+ * of them is not modelled.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Every fuzzed key has a matrix position of its own, as game mode tracks
+ * keys by position: two rows of plain keys, two of SM_TD keys. */
+#define MATRIX_ROWS 4
+
+#include "townk_mouse_layout.c"
+
+static bool fuzz_process_smtd(uint16_t keycode, keyrecord_t *record);
+
+/* The real pipeline, with SM_TD played by the target. */
+#define process_smtd(keycode, record) fuzz_process_smtd((keycode), (record))
+#include "../users/townk/townk_record.c"
+#undef process_smtd
+
+/** Decoded steps stop here, leaving the shim's event history room for the
+ * releases at the end of the input. */
+#define FUZZ_HISTORY_RESERVE 24
+
+/** The most distinct keycodes one input can leave held. */
+#define FUZZ_HELD_SLOTS 32
+
+static const uint16_t fuzz_keys[] = {MB_SFT, MB_ALT, MB_GUI, MB_CTL, T_MB_SFT2, KC_A, KC_B};
+static const uint16_t fuzz_smtd_keys[] = {CKC_SPC, CKC_TAB, CKC_BKTAB, CKC_BSPC, CKC_SMSFT};
+
+#define FUZZ_COUNT(array) (sizeof(array) / sizeof((array)[0]))
+#define FUZZ_KEY_COUNT FUZZ_COUNT(fuzz_keys)
+#define FUZZ_SMTD_COUNT FUZZ_COUNT(fuzz_smtd_keys)
+
+/** Where SM_TD has got to with one of its keys. */
+typedef enum {
+    FUZZ_SMTD_UP,
+    FUZZ_SMTD_TOUCHED, ///< Pressed, not yet resolved
+    FUZZ_SMTD_HELD,    ///< Resolved as a hold
+    FUZZ_SMTD_DECIDED, ///< Resolved by on_smtd_action() at the touch
+} fuzz_smtd_state_t;
+
+/* ------------------------------------------------------------------------ *
+ * What the harness believes, to check the firmware against
+ * ------------------------------------------------------------------------ */
+
+static bool              fuzz_key_down[FUZZ_KEY_COUNT];
+static bool              fuzz_smtd_down[FUZZ_SMTD_COUNT];
+static fuzz_smtd_state_t fuzz_smtd[FUZZ_SMTD_COUNT];
+static uint8_t           fuzz_tap_count[FUZZ_SMTD_COUNT];
+static bool              fuzz_auto_mouse;
+
+/** A keycode the host was told about, and how many times it is down. */
+typedef struct {
+    uint16_t keycode;
+    int8_t   down;
+} fuzz_held_t;
+
+/** Keycodes the host was told are down, from the recorded history. */
+static fuzz_held_t fuzz_held[FUZZ_HELD_SLOTS];
+static uint8_t fuzz_held_count;
+static uint8_t fuzz_history_seen;
+
+#ifdef TOWNK_FUZZ_STANDALONE
+static void fuzz_save_input(void);
+#else
+#    define fuzz_save_input() ((void)0)
+#endif
+
+static void fuzz_fail(const char *why) {
+    fprintf(stderr, "invariant broken: %s\n", why);
+    fuzz_save_input();
+    abort();
+}
+
+static void fuzz_reset(void) {
+    TEST_reset();
+    T_reset();
+    memset(fuzz_key_down, 0, sizeof(fuzz_key_down));
+    memset(fuzz_smtd_down, 0, sizeof(fuzz_smtd_down));
+    memset(fuzz_smtd, 0, sizeof(fuzz_smtd));
+    memset(fuzz_tap_count, 0, sizeof(fuzz_tap_count));
+    fuzz_auto_mouse   = global_saved_values.auto_mouse;
+    fuzz_held_count   = 0;
+    fuzz_history_seen = 0;
+}
+
+/** Fold the history recorded since the last call into fuzz_held. */
+static void fuzz_follow_history(void) {
+    static history_t records[MAX_HISTORY];
+    uint8_t          count;
+
+    TEST_get_record_history(records, &count);
+    for (; fuzz_history_seen < count; fuzz_history_seen++) {
+        const history_t *r = &records[fuzz_history_seen];
+        uint8_t          i = 0;
+        while (i < fuzz_held_count && fuzz_held[i].keycode != r->keycode) {
+            i++;
+        }
+        if (i == fuzz_held_count) {
+            if (fuzz_held_count == FUZZ_HELD_SLOTS) {
+                fuzz_fail("more distinct keycodes than the harness tracks");
+            }
+            fuzz_held[fuzz_held_count++] = (fuzz_held_t){r->keycode, 0};
+        }
+        fuzz_held[i].down += r->pressed ? 1 : -1;
+        if (fuzz_held[i].down < 0) {
+            fuzz_fail("a key was released that was never pressed");
+        }
+        if (fuzz_held[i].down > 1) {
+            fuzz_fail("a key was pressed twice without a release");
+        }
+    }
+}
+
+static bool fuzz_all_keys_up(void) {
+    for (size_t i = 0; i < FUZZ_KEY_COUNT; i++) {
+        if (fuzz_key_down[i]) return false;
+    }
+    for (size_t i = 0; i < FUZZ_SMTD_COUNT; i++) {
+        if (fuzz_smtd_down[i] || fuzz_smtd[i] != FUZZ_SMTD_UP) return false;
+    }
+    return true;
+}
+
+/** The layers a layer-tap hold turns on: none may outlive every key up. */
+static layer_state_t fuzz_momentary_layers(void) {
+    layer_state_t layers = 0;
+    for (size_t i = 0; i < FUZZ_SMTD_COUNT; i++) {
+        const smtd_key_t *key = &smtd_keys[fuzz_smtd_keys[i] - RANGE_START];
+        if (key->kind == SMTD_KIND_LAYER_TAP || key->kind == SMTD_KIND_SHIFTED_LAYER_TAP) {
+            layers |= (layer_state_t)1 << key->layer;
+        }
+    }
+    return layers;
+}
+
+static void fuzz_check(void) {
+    fuzz_follow_history();
+
+    bool in_game = layer_state_cmp(layer_state, _GAM1) || layer_state_cmp(layer_state, _GAM2);
+    if (in_game && global_saved_values.auto_mouse) {
+        fuzz_fail("auto_mouse is on inside a game layer");
+    }
+    if (!in_game && global_saved_values.auto_mouse != fuzz_auto_mouse) {
+        fuzz_fail("auto_mouse was not restored after the game layers");
+    }
+
+    if (!fuzz_all_keys_up()) {
+        return;
+    }
+    for (uint8_t bit = 1; bit != 0; bit <<= 1) {
+        if (mods_claim_count(bit) != 0) {
+            fuzz_fail("a modifier claim is left with every key up");
+        }
+    }
+    if (get_mods() != 0) {
+        fuzz_fail("a modifier is registered with every key up");
+    }
+    for (uint8_t i = 0; i < fuzz_held_count; i++) {
+        if (fuzz_held[i].down != 0) {
+            fuzz_fail("a key or mouse button is held with every key up");
+        }
+    }
+    if (smtd_layer_depth != 0) {
+        fuzz_fail("a layer-tap hold is left on the layer stack");
+    }
+    if (layer_state & fuzz_momentary_layers()) {
+        fuzz_fail("a layer-tap layer is on with every key up");
+    }
+}
+
+/* ------------------------------------------------------------------------ *
+ * Steps
+ * ------------------------------------------------------------------------ */
+
+/** process_record_user(), and QMK's own handling of what it lets through. */
+static void fuzz_record(uint16_t keycode, uint8_t row, uint8_t col, bool pressed) {
+    keyrecord_t record = {.event = MAKE_KEYEVENT(row, col, pressed)};
+    if (process_record_townk(keycode, &record)) {
+        if (pressed) {
+            register_code16(keycode);
+        } else {
+            unregister_code16(keycode);
+        }
+    }
+}
+
+static void fuzz_key(size_t index, bool pressed) {
+    if (fuzz_key_down[index] == pressed) {
+        return; // a matrix cannot press a key twice
+    }
+    fuzz_key_down[index] = pressed;
+    fuzz_record(fuzz_keys[index], (uint8_t)(index / MATRIX_COLS), (uint8_t)(index % MATRIX_COLS), pressed);
+}
+
+/** The tap count SM_TD gives the next press of an SM_TD key. */
+static uint8_t fuzz_next_tap_count;
+
+/** SM_TD's part: touch on the press, then a tap or a release on the release. */
+static bool fuzz_process_smtd(uint16_t keycode, keyrecord_t *record) {
+    size_t index = 0;
+    while (index < FUZZ_SMTD_COUNT && fuzz_smtd_keys[index] != keycode) {
+        index++;
+    }
+    if (index == FUZZ_SMTD_COUNT) {
+        return true;
+    }
+
+    uint8_t taps = fuzz_tap_count[index];
+    if (record->event.pressed) {
+        fuzz_tap_count[index] = fuzz_next_tap_count;
+        fuzz_smtd[index]      = on_smtd_action(keycode, SMTD_ACTION_TOUCH, fuzz_next_tap_count) == SMTD_RESOLUTION_DETERMINED ? FUZZ_SMTD_DECIDED : FUZZ_SMTD_TOUCHED;
+        return false;
+    }
+
+    switch (fuzz_smtd[index]) {
+        case FUZZ_SMTD_TOUCHED: // released before it resolved: a tap
+            on_smtd_action(keycode, SMTD_ACTION_TAP, taps);
+            break;
+        case FUZZ_SMTD_HELD:
+        case FUZZ_SMTD_DECIDED:
+            on_smtd_action(keycode, SMTD_ACTION_RELEASE, taps);
+            break;
+        default:
+            break;
+    }
+    fuzz_smtd[index] = FUZZ_SMTD_UP;
+    return false;
+}
+
+static void fuzz_smtd_press(size_t index, uint8_t tap_count) {
+    if (fuzz_smtd_down[index]) {
+        return;
+    }
+    fuzz_smtd_down[index] = true;
+    fuzz_next_tap_count   = tap_count;
+    fuzz_record(fuzz_smtd_keys[index], (uint8_t)(2 + index / MATRIX_COLS), (uint8_t)(index % MATRIX_COLS), true);
+}
+
+/** SM_TD's timer running out on a touched key. */
+static void fuzz_smtd_hold(size_t index) {
+    if (fuzz_smtd[index] != FUZZ_SMTD_TOUCHED) {
+        return;
+    }
+    fuzz_smtd[index] = FUZZ_SMTD_HELD;
+    on_smtd_action(fuzz_smtd_keys[index], SMTD_ACTION_HOLD, fuzz_tap_count[index]);
+}
+
+static void fuzz_smtd_release(size_t index) {
+    if (!fuzz_smtd_down[index]) {
+        return;
+    }
+    fuzz_smtd_down[index] = false;
+    fuzz_record(fuzz_smtd_keys[index], (uint8_t)(2 + index / MATRIX_COLS), (uint8_t)(index % MATRIX_COLS), false);
+}
+
+static void fuzz_pointing(int8_t x, int8_t y, int8_t v) {
+    report_mouse_t report = {.x = x, .y = y, .v = v};
+    pointing_device_task_kb(report);
+}
+
+static void fuzz_layer(uint8_t which) {
+    static const uint8_t moves[] = {_BASE, _GAM1, _GAM2, _QWT};
+    if (which < FUZZ_COUNT(moves)) {
+        layer_move(moves[which]);
+    } else {
+        T_mouse_layer(which & 1);
+    }
+}
+
+/** Let go of everything, let every timer run out, and check once more. */
+static void fuzz_finish(void) {
+    for (size_t i = 0; i < FUZZ_KEY_COUNT; i++) {
+        fuzz_key(i, false);
+        fuzz_check();
+    }
+    for (size_t i = 0; i < FUZZ_SMTD_COUNT; i++) {
+        fuzz_smtd_release(i);
+        fuzz_check();
+    }
+    TEST_advance_time(1000);
+    fuzz_pointing(0, 0, 0);
+    fuzz_check();
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    fuzz_reset();
+
+    /* Each step is an opcode byte and an argument byte. The low three bits
+     * of the opcode pick the step, the rest pick which key. */
+    for (size_t i = 0; i + 1 < size && fuzz_history_seen < MAX_HISTORY - FUZZ_HISTORY_RESERVE; i += 2) {
+        uint8_t op = data[i], arg = data[i + 1];
+        uint8_t key = op >> 3;
+
+        switch (op & 0x07) {
+            case 0:
+                fuzz_key(key % FUZZ_KEY_COUNT, true);
+                break;
+            case 1:
+                fuzz_key(key % FUZZ_KEY_COUNT, false);
+                break;
+            case 2:
+                fuzz_smtd_press(key % FUZZ_SMTD_COUNT, arg % 3);
+                break;
+            case 3:
+                if (arg & 1) {
+                    fuzz_smtd_hold(key % FUZZ_SMTD_COUNT);
+                } else {
+                    fuzz_smtd_release(key % FUZZ_SMTD_COUNT);
+                }
+                break;
+            case 4:
+                fuzz_pointing((int8_t)arg >> 2, (int8_t)(arg << 4) >> 4, key % 3 - 1);
+                break;
+            case 5:
+                TEST_advance_time(arg);
+                break;
+            case 6:
+                fuzz_layer(key % 6);
+                break;
+            default:
+                // The user flips the setting in Vial; mid-game it is not theirs to flip.
+                if (!game_layers_active) {
+                    global_saved_values.auto_mouse = arg & 1;
+                    fuzz_auto_mouse                = arg & 1;
+                }
+                break;
+        }
+        fuzz_check();
+    }
+
+    fuzz_finish();
+    return 0;
+}
+
+#ifdef TOWNK_FUZZ_STANDALONE
+/* For compilers without libFuzzer: replay the inputs named on the command
+ * line, or, with none, run argv-less random inputs from a fixed seed. No
+ * coverage guidance, but the same invariants and the same sanitizers. */
+
+static uint32_t fuzz_rng = 0x9E3779B9u;
+
+static const uint8_t *fuzz_input;
+static size_t         fuzz_input_size;
+
+/* libFuzzer saves a crashing input itself; standalone, do it here. */
+static void fuzz_save_input(void) {
+    FILE *f = fopen("crash-standalone", "wb");
+    if (f) {
+        fwrite(fuzz_input, 1, fuzz_input_size, f);
+        fclose(f);
+        fprintf(stderr, "input saved to crash-standalone\n");
+    }
+}
+
+static void fuzz_run(const uint8_t *data, size_t size) {
+    fuzz_input      = data;
+    fuzz_input_size = size;
+    LLVMFuzzerTestOneInput(data, size);
+}
+
+static uint32_t fuzz_next(void) {
+    fuzz_rng ^= fuzz_rng << 13;
+    fuzz_rng ^= fuzz_rng >> 17;
+    fuzz_rng ^= fuzz_rng << 5;
+    return fuzz_rng;
+}
+
+static int fuzz_replay(const char *path) {
+    static uint8_t data[4096];
+    FILE          *f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return 1;
+    }
+    size_t size = fread(data, 1, sizeof(data), f);
+    fclose(f);
+    fuzz_run(data, size);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1 && argv[1][0] != '-') {
+        for (int i = 1; i < argc; i++) {
+            if (fuzz_replay(argv[i]) != 0) return 1;
+        }
+        return 0;
+    }
+
+    unsigned long runs = argc > 2 && strcmp(argv[1], "-runs") == 0 ? strtoul(argv[2], NULL, 10) : 100000;
+    uint8_t       data[256];
+    for (unsigned long run = 0; run < runs; run++) {
+        size_t size = fuzz_next() % sizeof(data);
+        for (size_t i = 0; i < size; i++) {
+            data[i] = (uint8_t)fuzz_next();
+        }
+        fuzz_run(data, size);
+    }
+    printf("%lu random inputs, no invariant broken\n", runs);
+    return 0;
+}
+#endif // TOWNK_FUZZ_STANDALONE
@@ -18,7 +18,11 @@
 /* SMTD_UNIT_TEST is supplied by the compiler invocation in
  * tests/test_townk_mouse.py, not defined here, so the two cannot disagree. */
 
-#define MATRIX_ROWS 1
+/* Four positions are all the tests need; a target driving more keys at once
+ * (the fuzz target) defines its own rows before including this file. */
+#ifndef MATRIX_ROWS
+#    define MATRIX_ROWS 1
+#endif
 #define MATRIX_COLS 4
 #define TAPPING_TERM 200
 
@@ -45,6 +49,8 @@
 #include "keycodes.h"
 #include "modifiers.h"
 
+#include <string.h>
+
 /* ------------------------------------------------------------------------ *
  * QMK API the sm_td shim does not stub
  * ------------------------------------------------------------------------ */
@@ -63,11 +69,21 @@ void    set_oneshot_mods(uint8_t mods) { oneshot_mods = mods; }
 uint8_t get_oneshot_mods(void) { return oneshot_mods; }
 void    clear_oneshot_mods(void) { oneshot_mods = 0; }
 
+/* Repeat Key never replays on the host. */
+#include "repeat_key.h" /* the stub in tests/stubs, not QMK's */
+int8_t get_repeat_key_count(void) { return 0; }
+
 /* Svalboard persisted settings. On-device this lives in keymap_support.c;
- * only the field townk_layers.c touches is modelled. */
+ * only the fields the userspace touches are modelled: auto_mouse for
+ * townk_layers.c, each ball's scroll mode for townk_mouse.c, and the pointer
+ * ball's DPI index for the acceleration curve in townk_pointing.c. The
+ * defaults are this keymap's (see keyboard_post_init_user()). */
 static struct {
-    bool auto_mouse;
-} global_saved_values = {.auto_mouse = true};
+    bool    auto_mouse;
+    bool    left_scroll;
+    bool    right_scroll;
+    uint8_t right_dpi_index;
+} global_saved_values = {.auto_mouse = true, .left_scroll = true, .right_scroll = false, .right_dpi_index = 3};
 
 /* Supplied by the Svalboard keyboard code on-device. Recorded here so tests can
  * assert on mouse-mode transitions, which are otherwise invisible.
@@ -93,19 +109,43 @@ void mouse_mode(bool on) {
  * The Svalboard defines MOUSE_EXTENDED_REPORT, so on-device x/y are int16_t
  * (see tmk_core/protocol/report.h). The fixture must match, or a large
  * report would be truncated HERE and hide exactly the truncation bugs the
- * motion tests exist to catch. */
+ * motion tests exist to catch.
+ *
+ * POINTING_DEVICE_HIRES_SCROLL_ENABLE is on here, though the keymap leaves
+ * it off, so the tests cover the scroll stage's fractional path. It implies
+ * WHEEL_EXTENDED_REPORT: h/v are int16_t too, in 1/120ths of a notch. */
+#define POINTING_DEVICE_HIRES_SCROLL_ENABLE
+#define POINTING_DEVICE_HIRES_SCROLL_MULTIPLIER 120
+
 typedef int16_t mouse_xy_report_t;
+typedef int16_t mouse_hv_report_t;
 
 typedef struct {
     mouse_xy_report_t x;
     mouse_xy_report_t y;
-    int8_t            h;
-    int8_t            v;
+    mouse_hv_report_t h;
+    mouse_hv_report_t v;
     uint8_t           buttons;
 } report_mouse_t;
 
 report_mouse_t pointing_device_task_user(report_mouse_t report) { return report; }
 
+/* The Svalboard is a dual-ball split (POINTING_DEVICE_COMBINED), where QMK
+ * hands both balls' reports to pointing_device_task_combined_*() before they
+ * are merged. Defining it here compiles townk_mouse.c's per-device path. */
+#define POINTING_DEVICE_COMBINED
+
+/* QMK's merge: sums x/y/h/v and ORs buttons. Saturation is not modelled;
+ * nothing under test reaches it. */
+report_mouse_t pointing_device_combine_reports(report_mouse_t left_report, report_mouse_t right_report) {
+    left_report.x += right_report.x;
+    left_report.y += right_report.y;
+    left_report.h += right_report.h;
+    left_report.v += right_report.v;
+    left_report.buttons |= right_report.buttons;
+    return left_report;
+}
+
 /* Layers. Since 0.6.4 the shim models layer_state as a real bitmask with
  * native additive layer_on/layer_off -- the fidelity this fixture used to
  * bolt on with its own bitmask, now deleted in the shim's favour. Only
@@ -116,6 +156,11 @@ bool layer_state_is(uint8_t layer) { return (layer_state & ((uint32_t)1 << layer
  * as a bare uint32_t, so the typedef makes the two one type. */
 typedef uint32_t layer_state_t;
 
+/* QMK keeps the default layers apart from layer_state; the shim has no
+ * notion of them. T_default_layer_set() drives them like QMK's
+ * default_layer_set(). */
+layer_state_t default_layer_state = 0;
+
 /* QMK's semantics: an empty state means only layer 0 is active. */
 bool layer_state_cmp(layer_state_t state, uint8_t layer) {
     if (!state) {
@@ -125,29 +170,34 @@ bool layer_state_cmp(layer_state_t state, uint8_t layer) {
 }
 
 /* RGB plumbing for townk_layers.c: the layer table is registered and each
- * layer's segment toggled on layer changes. Nothing under test reads RGB
- * state, so recording is unnecessary -- the stub only has to link. */
+ * layer's segment toggled on layer changes. townk_layers.c writes only the
+ * segments whose layer changed, so the stub keeps what each one shows and
+ * counts the writes -- the tests check both. Like the LEDs, neither is
+ * cleared by T_reset(). */
 #include "rgblight.h" /* the stub in tests/stubs, not QMK's */
 
 const rgblight_segment_t *const *rgblight_layers = 0;
 
+static bool     rgb_segment_on[RGBLIGHT_LAYERS];
+static uint32_t rgb_segment_writes;
+
 void rgblight_set_layer_state(uint8_t layer, bool enabled) {
-    (void)layer;
-    (void)enabled;
+    if (layer < RGBLIGHT_LAYERS) {
+        rgb_segment_on[layer] = enabled;
+    }
+    rgb_segment_writes++;
 }
 
+bool     T_rgb_segment(uint8_t layer) { return layer < RGBLIGHT_LAYERS && rgb_segment_on[layer]; }
+uint32_t T_rgb_writes(void) { return rgb_segment_writes; }
+
 /* ------------------------------------------------------------------------ *
  * SM_TD hooks every fixture must define
  * ------------------------------------------------------------------------ */
 
 /* sm_td declares these __attribute__((weak)) and calls them through a NULL
  * check; a shared library still needs concrete definitions to link. Defer to
- * the library defaults -- this fixture has no per-key timing of its own. */
-uint32_t get_smtd_timeout(uint16_t keycode, smtd_timeout timeout) {
-    (void)keycode;
-    return get_smtd_timeout_default(timeout);
-}
-
+ * the library defaults. get_smtd_timeout() is townk_smtd.c's own. */
 bool smtd_feature_enabled(uint16_t keycode, smtd_feature feature) {
     return smtd_feature_enabled_default(keycode, feature);
 }
@@ -169,9 +219,147 @@ void post_process_record(keyrecord_t *record) { (void)record; }
  * The code under test -- the real file, compiled as-is
  * ------------------------------------------------------------------------ */
 
+/* QMK's 32-bit user EEPROM word and user datablock, backed by variables so
+ * tests can inspect what was saved and how often. The keymap reserves the
+ * datablock the same way. */
+#define EECONFIG_USER_DATA_SIZE 64
+
+static uint32_t eeprom_user             = 0;
+static int      eeprom_user_writes      = 0;
+static uint8_t  eeprom_user_data[EECONFIG_USER_DATA_SIZE];
+static int      eeprom_user_data_writes = 0;
+
+uint32_t eeconfig_read_user(void) { return eeprom_user; }
+void     eeconfig_update_user(uint32_t val) {
+    eeprom_user = val;
+    eeprom_user_writes++;
+}
+uint32_t eeconfig_read_user_datablock(void *data, uint32_t offset, uint32_t length) {
+    memcpy(data, &eeprom_user_data[offset], length);
+    return length;
+}
+uint32_t eeconfig_update_user_datablock(const void *data, uint32_t offset, uint32_t length) {
+    memcpy(&eeprom_user_data[offset], data, length);
+    eeprom_user_data_writes++;
+    return length;
+}
+
+/* Deferred execution, as the keymap's rules.mk enables it: a few slots of
+ * tasks run against the shim's virtual clock. Nothing runs them on its own --
+ * a test advances the time and calls T_deferred_tick(), as QMK's housekeeping
+ * would once per scan. */
+#define DEFERRED_EXEC_ENABLE
+#include "deferred_exec.h" /* the stub in tests/stubs, not QMK's */
+
+#define T_DEFERRED_SLOTS 4
+
+static struct {
+    deferred_exec_callback callback;
+    void                  *cb_arg;
+    uint32_t               due;
+} t_deferred[T_DEFERRED_SLOTS];
+
+deferred_token defer_exec(uint32_t delay_ms, deferred_exec_callback callback, void *cb_arg) {
+    if (delay_ms == 0 || !callback) {
+        return INVALID_DEFERRED_TOKEN; /* QMK refuses these too */
+    }
+    for (uint8_t i = 0; i < T_DEFERRED_SLOTS; i++) {
+        if (!t_deferred[i].callback) {
+            t_deferred[i].callback = callback;
+            t_deferred[i].cb_arg   = cb_arg;
+            t_deferred[i].due      = timer_read32() + delay_ms;
+            return i + 1;
+        }
+    }
+    return INVALID_DEFERRED_TOKEN;
+}
+
+bool cancel_deferred_exec(deferred_token token) {
+    if (token == INVALID_DEFERRED_TOKEN || token > T_DEFERRED_SLOTS || !t_deferred[token - 1].callback) {
+        return false;
+    }
+    t_deferred[token - 1].callback = NULL;
+    return true;
+}
+
+/* Run every task that is due -- or, with `all`, every task at all. */
+static void t_deferred_run(bool all) {
+    uint32_t now = timer_read32();
+
+    for (uint8_t i = 0; i < T_DEFERRED_SLOTS; i++) {
+        if (!t_deferred[i].callback || (!all && (int32_t)(now - t_deferred[i].due) < 0)) {
+            continue;
+        }
+        deferred_exec_callback callback = t_deferred[i].callback;
+        t_deferred[i].callback          = NULL;
+        uint32_t again                  = callback(now, t_deferred[i].cb_arg);
+        if (again) {
+            t_deferred[i].callback = callback;
+            t_deferred[i].due      = now + again;
+        }
+    }
+}
+
+void T_deferred_tick(void) { t_deferred_run(false); }
+
+/* The flight recorder and latency histograms are on, as in the keymap, so
+ * the tests see what they record and the benchmark pays for them. */
+#define TOWNK_TRACE_ENABLE
+#define TOWNK_LATENCY_ENABLE
+#include "../users/townk/townk_trace.c"
+#include "../users/townk/townk_latency.c"
+#include "../users/townk/townk_eeconfig.c"
+/* The keymap townk_keycache.c resolves against: every position KC_NO on
+ * every layer until a test fills it in. Reads are counted, so the tests can
+ * see what a layer change re-resolved. */
+#include "keymap_common.h" /* the stub in tests/stubs, not QMK's */
+
+#define T_KEYMAP_LAYERS 32
+static uint16_t t_keymap[T_KEYMAP_LAYERS][MATRIX_ROWS][MATRIX_COLS];
+static uint32_t t_keymap_reads;
+
+uint16_t keymap_key_to_keycode(uint8_t layer, keypos_t key) {
+    t_keymap_reads++;
+    if (layer >= T_KEYMAP_LAYERS || key.row >= MATRIX_ROWS || key.col >= MATRIX_COLS) {
+        return KC_NO;
+    }
+    return t_keymap[layer][key.row][key.col];
+}
+
+#include "../users/townk/townk_keycache.c"
 #include "../users/townk/townk_layers.c"
 #include "../users/townk/townk_mods.c"
+/* townk_mouse.c's four dual-role keys, plus one the keymap does not have: a
+ * second Shift on BTN5. It is how the tests reach a table entry past the
+ * first four, and two keys sharing one modifier. */
+#define T_MB_SFT2 (MB_CTL + 1)
+#define MB_KEYS                                 \
+    {                                           \
+        {MB_SFT, MOD_BIT(KC_LSFT), KC_BTN1},    \
+        {MB_ALT, MOD_BIT(KC_LALT), KC_BTN2},    \
+        {MB_GUI, MOD_BIT(KC_LGUI), KC_BTN3},    \
+        {MB_CTL, MOD_BIT(KC_LCTL), KC_BTN4},    \
+        {T_MB_SFT2, MOD_BIT(KC_LSFT), KC_BTN5}, \
+    }
+
 #include "../users/townk/townk_mouse.c"
+#include "../users/townk/townk_pointing.c"
+
+/* The keymap's two WASD pairs, plus one pair for each other policy, so the
+ * tests reach all three. */
+#define SOCD_PAIRS                            \
+    {                                         \
+        {{KC_A, KC_D}, SOCD_LAST_WINS},       \
+        {{KC_W, KC_S}, SOCD_LAST_WINS},       \
+        {{KC_Q, KC_E}, SOCD_NEUTRAL},         \
+        {{KC_Z, KC_C}, SOCD_FIRST_WINS},      \
+    }
+#include "../users/townk/townk_socd.c"
+
+/* The keymap builds with VIA (and Vial), which is what routes raw HID
+ * custom-value commands to townk_hid.c; tests call its hook directly. */
+#define VIA_ENABLE
+#include "../users/townk/townk_hid.c"
 
 /* ------------------------------------------------------------------------ *
  * Minimal keymap + SM_TD action handler
@@ -193,9 +381,71 @@ uint16_t const keymaps[][MATRIX_ROWS][MATRIX_COLS] = {
 /* Drive one key event through the engine, as process_record_user() would. */
 void T_key(uint16_t keycode, bool pressed) {
     keyrecord_t record = {.event = MAKE_KEYEVENT(0, 0, pressed)};
+    latency_mark(keycode, &record);
+    smtd_streak_record(&record);
+    smtd_timing_record(&record);
     process_special_mouse_keys(keycode, &record);
 }
 
+/* The matrix press process_record_user() stamps before handing an SM_TD key
+ * to process_smtd(); T_smtd_* then stand in for what SM_TD decides later. */
+/* A key event at matrix column `col` through the game-mode switch: true if
+ * process_record_user() would hand it straight to QMK. */
+bool T_game_key(uint8_t col, bool pressed) {
+    keyrecord_t record = {.event = MAKE_KEYEVENT(0, col, pressed)};
+    return game_mode_fast_path(&record);
+}
+
+/* The same, carrying `keycode` on through process_socd() and, when that
+ * leaves it to QMK, registering it as QMK would. False, with nothing sent,
+ * if the event is not game mode's. */
+bool T_game_event(uint16_t keycode, uint8_t col, bool pressed) {
+    keyrecord_t record = {.event = MAKE_KEYEVENT(0, col, pressed)};
+    if (!game_mode_fast_path(&record)) {
+        return false;
+    }
+    if (process_socd(keycode, &record)) {
+        if (pressed) {
+            register_code16(keycode);
+        } else {
+            unregister_code16(keycode);
+        }
+    }
+    return true;
+}
+
+/* The keymap and the keycode cache in front of it. */
+void T_keymap_set(uint8_t layer, uint8_t col, uint16_t keycode) {
+    t_keymap[layer][0][col] = keycode;
+}
+uint32_t T_keymap_reads(void) { return t_keymap_reads; }
+uint16_t T_keycache_keycode(uint8_t col) { return keycache_keycode((keypos_t){.row = 0, .col = col}); }
+uint16_t T_keycache_layer_keycode(uint8_t layer, uint8_t col) {
+    return keycache_layer_keycode(layer, (keypos_t){.row = 0, .col = col});
+}
+
+/* QMK's default_layer_set(): the hook sees the new state before it is stored. */
+void T_default_layer_set(uint8_t layer) {
+    default_layer_state = default_layer_state_set_user((layer_state_t)1 << layer);
+}
+
+void T_matrix_press(uint16_t keycode) {
+    keyrecord_t record = {.event = MAKE_KEYEVENT(0, 0, true)};
+    latency_mark(keycode, &record);
+    smtd_streak_record(&record);
+    smtd_timing_record(&record);
+}
+
+/* The same press as sm_td's replay of it: townk_sm_td.c brackets the
+ * process_record() call, and process_record_user() runs inside it. */
+void T_replay_press(uint16_t keycode) {
+    smtd_replay_begin();
+    T_matrix_press(keycode);
+    smtd_replay_end();
+}
+
+uint16_t T_latency_bucket(uint8_t cls, uint8_t bucket) { return latency_bucket(cls, bucket); }
+
 /* Drive the SM_TD action handler directly. SM_TD-managed keys reach
  * on_smtd_action() and never process_record_user() -- that asymmetry is what
  * produced the phantom click, and it is also why nothing here could be tested
@@ -207,14 +457,66 @@ void T_smtd_touch(uint16_t keycode) { on_smtd_action(keycode, SMTD_ACTION_TOUCH,
 void T_smtd_tap(uint16_t keycode, uint8_t tap_count) { on_smtd_action(keycode, SMTD_ACTION_TAP, tap_count); }
 void T_smtd_hold(uint16_t keycode, uint8_t tap_count) { on_smtd_action(keycode, SMTD_ACTION_HOLD, tap_count); }
 void T_smtd_release(uint16_t keycode, uint8_t tap_count) { on_smtd_action(keycode, SMTD_ACTION_RELEASE, tap_count); }
+int  T_smtd_resolution(uint16_t keycode, uint8_t action) { return on_smtd_action(keycode, action, 0); }
 
 /* Trackball motion. Pointer movement (x/y) is what converts a held key to a
  * held mouse button; h/v are scroll. x/y are 16-bit, as on the board. */
-void T_pointing(mouse_xy_report_t x, mouse_xy_report_t y, int8_t h, int8_t v) {
+void T_pointing(mouse_xy_report_t x, mouse_xy_report_t y, mouse_hv_report_t h, mouse_hv_report_t v) {
     report_mouse_t report = {.x = x, .y = y, .h = h, .v = v, .buttons = 0};
     pointing_device_task_kb(report);
 }
 
+/* Both balls in one scan, the way a dual-ball split delivers them: the
+ * per-device hook first, then the merged report through the _kb hook. */
+void T_pointing_combined(mouse_xy_report_t lx, mouse_xy_report_t ly, mouse_hv_report_t lh, mouse_hv_report_t lv, mouse_xy_report_t rx, mouse_xy_report_t ry, mouse_hv_report_t rh, mouse_hv_report_t rv) {
+    report_mouse_t left  = {.x = lx, .y = ly, .h = lh, .v = lv, .buttons = 0};
+    report_mouse_t right = {.x = rx, .y = ry, .h = rh, .v = rv, .buttons = 0};
+    pointing_device_task_kb(pointing_device_task_combined_user(left, right));
+}
+
+void T_set_left_scroll(bool on) { global_saved_values.left_scroll = on; }
+
+/* T_pointing_combined(), returning the merged report the host would receive;
+ * for asserting on the scroll stage's wheel output. */
+void T_pointing_combined_report(mouse_xy_report_t lx, mouse_xy_report_t ly, mouse_hv_report_t lh, mouse_hv_report_t lv, mouse_xy_report_t rx, mouse_xy_report_t ry, mouse_xy_report_t *out_x, mouse_xy_report_t *out_y, mouse_hv_report_t *out_h, mouse_hv_report_t *out_v) {
+    report_mouse_t left   = {.x = lx, .y = ly, .h = lh, .v = lv, .buttons = 0};
+    report_mouse_t right  = {.x = rx, .y = ry, .h = 0, .v = 0, .buttons = 0};
+    report_mouse_t report = pointing_device_task_kb(pointing_device_task_combined_user(left, right));
+    *out_x                = report.x;
+    *out_y                = report.y;
+    *out_h                = report.h;
+    *out_v                = report.v;
+}
+
+/* One report through the whole hook, returning what the host would receive.
+ * Unlike T_pointing(), this is for asserting on the shaped output. */
+void T_pointing_report(mouse_xy_report_t x, mouse_xy_report_t y, mouse_hv_report_t h, mouse_hv_report_t v, mouse_xy_report_t *out_x, mouse_xy_report_t *out_y, mouse_hv_report_t *out_h, mouse_hv_report_t *out_v) {
+    report_mouse_t report = {.x = x, .y = y, .h = h, .v = v, .buttons = 0};
+    report                = pointing_device_task_kb(report);
+    *out_x                = report.x;
+    *out_y                = report.y;
+    *out_h                = report.h;
+    *out_v                = report.v;
+}
+
+void     T_set_right_dpi(uint8_t dpi_index) { global_saved_values.right_dpi_index = dpi_index; }
+uint16_t T_accel_gain(uint8_t dpi_index, uint32_t speed) { return pointer_accel_gain(dpi_index, speed); }
+
+/* The EEPROM user word as last written, and how many writes it took. Setting
+ * it simulates a power-up with that content. */
+uint32_t T_eeprom_user(void) { return eeprom_user; }
+int      T_eeprom_user_writes(void) { return eeprom_user_writes; }
+void     T_power_up_with_eeprom_user(uint32_t raw) {
+    eeprom_user = raw;
+    townk_eeconfig_init();
+    mb_motion_reset_config();
+    for (size_t i = 0; i < SMTD_KEY_COUNT; i++) {
+        smtd_timing[i] = (smtd_timing_state_t){0};
+    }
+    smtd_timing_loaded = false;
+}
+int      T_eeprom_user_data_writes(void) { return eeprom_user_data_writes; }
+
 /* Pre-seed an EXTERNAL modifier, so the mods_on_press branch is reachable. */
 void T_set_external_mods(uint8_t mods) { set_mods(mods); }
 
@@ -230,29 +532,56 @@ uint8_t T_layer_gam1(void) { return _GAM1; }
 uint8_t T_layer_base(void) { return _BASE; }
 
 /* Clear the engine's own state between tests. TEST_reset() in the sm_td shim
- * clears the recorded history and sm_td, but knows nothing about mb_states. */
+ * clears the recorded history and sm_td, but knows nothing about mb_state. */
 void T_reset(void) {
-    for (int i = 0; i < 4; i++) {
-        mb_states[i] = (mb_state_t){0};
+    mb_state = (mb_state_t){0};
+    for (size_t i = 0; i < MB_KEY_COUNT; i++) {
+        mb_click_mods[i] = 0;
+    }
+    for (int i = 0; i < POINTER_DEVICE_COUNT; i++) {
+        mb_motion[i] = (mb_motion_t){0};
+    }
+    eeprom_user        = 0;
+    townk_eeconfig_init(); /* a blank EEPROM: formats the word */
+    eeprom_user_writes      = 0;
+    eeprom_user_data_writes = 0;
+    for (size_t i = 0; i < SMTD_KEY_COUNT; i++) {
+        smtd_timing[i] = (smtd_timing_state_t){0};
     }
-    mb_motion_accum     = 0;
-    mb_motion_last_time = 0;
+    smtd_timing_loaded = false;
+    mb_motion_reset_config();
+    mb_report_resolved = false;
     mods_reset();
     mouse_mode_calls          = 0;
     mouse_mode_state          = false;
     mouse_mode_saw_auto_mouse = false;
-    global_saved_values.auto_mouse = true; /* the Svalboard EEPROM default */
+    global_saved_values.auto_mouse   = true; /* the Svalboard EEPROM default */
+    global_saved_values.left_scroll  = true; /* this keymap's defaults */
+    global_saved_values.right_scroll = false;
+    global_saved_values.right_dpi_index = MOUSE_DPI_1200;
+    pointer_shaping_reset();
     game_layers_active = false;
     saved_auto_mouse   = false;
+    memset(game_keys, 0, sizeof(game_keys));
+    memset(t_keymap, 0, sizeof(t_keymap));
+    default_layer_state = 0;
+    keycache_valid      = false;
+    socd_reset();
     caps_word_off();
     oneshot_mods = 0;
     set_mods(0);
     layer_move(_BASE);
-    /* The LAYER_PUSH/LAYER_RESTORE refcount lives in townk_smtd.c now that
-     * SM_TD 0.6.2 dropped the macros; the shim's TEST_reset no longer knows
-     * about it, so clear it here or a dangling push leaks across tests. */
-    smtd_return_layer     = RETURN_LAYER_NOT_SET;
-    smtd_return_layer_cnt = 0;
+    /* The layer-tap layer stack lives in townk_smtd.c; the shim's TEST_reset
+     * knows nothing about it, so clear it here or a dangling hold leaks
+     * across tests. */
+    smtd_layer_depth = 0;
+    smtd_replay_depth = 0;
+    memset(&smtd_streak, 0, sizeof(smtd_streak));
+    latency_reset();
+    t_deferred_run(true); /* draw the frame the reset's layer_move() asked for */
+    rgb_layer_reset_stats();
+    t_keymap_reads = 0;
+    townk_trace_clear(); /* last: the resets above leave records of their own */
 }
 
 /* Reference-counted modifier ownership, driven directly. Going through gestures
@@ -286,10 +615,17 @@ uint16_t T_kc_mb_ctl(void) { return MB_CTL; }
 uint16_t T_kc_ckc_spc(void) { return CKC_SPC; }
 uint16_t T_kc_ckc_bspc(void) { return CKC_BSPC; }
 uint8_t  T_layer_nav(void) { return _NAV; }
+uint8_t  T_layer_num(void) { return _NUM; }
+uint16_t T_kc_spc(void) { return KC_SPC; }
+uint16_t T_kc_ckc_smsft(void) { return CKC_SMSFT; }
+uint16_t T_kc_ckc_tab(void) { return CKC_TAB; }
+uint8_t  T_layer_sym(void) { return _SYM; }
 uint8_t  T_layer_mbo(void) { return _MBO; }
 uint16_t T_kc_del(void) { return KC_DEL; }
 uint16_t T_kc_bspc(void) { return KC_BSPC; }
 uint16_t T_kc_btn1(void) { return KC_BTN1; }
 uint16_t T_kc_btn2(void) { return KC_BTN2; }
 uint16_t T_kc_btn3(void) { return KC_BTN3; }
+uint16_t T_kc_btn5(void) { return KC_BTN5; }
+uint16_t T_kc_mb_sft2(void) { return T_MB_SFT2; }
 uint16_t T_kc_plain(void) { return 0x0004; } /* KC_A -- an ordinary, non-SM_TD key */
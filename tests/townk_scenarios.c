@@ -0,0 +1,546 @@
+/* Native runner for the batched scenarios in tests/scenarios/.
+ *
+ * Builds on tests/townk_mouse_layout.c -- the same stubs, the same REAL
+ * townk_mouse.c, townk_mods.c, townk_smtd.c and townk_layers.c -- and runs
+ * whole event scripts in one process, comparing each scenario's recorded
+ * event history against the one it declares. Where test_townk_mouse.py pays
+ * a ctypes crossing per event, a scenario costs a few microseconds, so the
+ * suite can grow by the hundred and still gate a commit.
+ *
+ * Each *.scn file holds any number of scenarios:
+ *
+ *   # MB_* keys: the button is the default role.
+ *   scenario: a bare tap clicks
+ *       press MB_GUI
+ *       release MB_GUI
+ *       => KC_BTN3 down
+ *       => KC_BTN3 up
+ *
+ * A scenario starts from T_reset() and runs its steps in order. Actions:
+ *
+ *   press K / release K     a key through process_special_mouse_keys(), as
+ *                           process_record_user() hands it over
+ *   game-press K [C] / game-release K [C]
+ *                           a key at matrix column C (default 0) through game
+ *                           mode and process_socd(); fails unless game mode
+ *                           takes it
+ *   touch / tap / hold / lift K [N]
+ *                           SMTD_ACTION_TOUCH / TAP / HOLD / RELEASE for K,
+ *                           N taps into a sequence (default 0)
+ *   move X Y [H V]          one pointing report through the _kb hook
+ *   balls LX LY [LH LV] / RX RY [RH RV]
+ *                           both balls in one scan, through the combined hook
+ *   wait MS                 advance the clock
+ *   set-mods M, set-oneshot M, claim M, unclaim M
+ *   begin, commit, commit-press K, commit-release K
+ *                           a townk_mods.c transaction around claims
+ *   layer-on L, layer-off L, layer-move L
+ *   left-scroll on|off, auto-mouse on|off, dpi N
+ *
+ * Expectations:
+ *
+ *   => K down|up [M]        the next recorded event, with exactly the mods M
+ *                           held (none if omitted)
+ *   check mods M, check oneshot M, check claims M N
+ *   check layer L on|off, check auto-mouse on|off, check caps-word on|off
+ *   check mouse-mode on|off
+ *   check resolution uncertain|determined|unhandled
+ *                           what the last touch/tap/hold/lift returned
+ *
+ * Before every action, and at the end, the recorded history must be exactly
+ * the events declared so far: an action's output is declared right after it,
+ * and a scenario that declares nothing asserts that nothing was emitted. At
+ * the end no modifier may be left registered or claimed.
+ *
+ * K is a keycode name from the table below or a number; M is "none" or mod
+ * names joined by '|' (LSFT|LALT); L is a layer name (_NAV).
+ *
+ * Prints one line per scenario, "ok" or "FAIL" with the reason indented
+ * below it, and exits non-zero if any failed. Built and run by
+ * tests/test_townk_scenarios.py; not part of any firmware build.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "townk_mouse_layout.c"
+
+#define SCN_LINE_MAX 256
+#define SCN_TOKENS_MAX 12
+#define SCN_MESSAGE_MAX 2048
+
+typedef struct {
+    const char *name;
+    uint16_t    value;
+} scn_name_t;
+
+static const scn_name_t scn_keycodes[] = {
+    {"MB_SFT", MB_SFT},       {"MB_ALT", MB_ALT},       {"MB_GUI", MB_GUI},       {"MB_CTL", MB_CTL},
+    {"MB_SFT2", T_MB_SFT2},   {"CKC_BSPC", CKC_BSPC},   {"CKC_SPC", CKC_SPC},     {"CKC_TAB", CKC_TAB},
+    {"CKC_BKTAB", CKC_BKTAB}, {"CKC_SMSFT", CKC_SMSFT}, {"KC_A", KC_A},           {"KC_B", KC_B},
+    {"KC_C", KC_C},           {"KC_D", KC_D},           {"KC_E", KC_E},           {"KC_Q", KC_Q},
+    {"KC_S", KC_S},           {"KC_W", KC_W},           {"KC_Z", KC_Z},           {"KC_SPC", KC_SPC},
+    {"KC_TAB", KC_TAB},       {"S(KC_TAB)", S(KC_TAB)}, {"KC_BSPC", KC_BSPC},     {"KC_DEL", KC_DEL},
+    {"KC_BTN1", KC_BTN1},     {"KC_BTN2", KC_BTN2},     {"KC_BTN3", KC_BTN3},     {"KC_BTN4", KC_BTN4},
+    {"KC_BTN5", KC_BTN5},
+};
+
+static const scn_name_t scn_mods[] = {
+    {"LCTL", MOD_BIT(KC_LCTL)}, {"LSFT", MOD_BIT(KC_LSFT)}, {"LALT", MOD_BIT(KC_LALT)}, {"LGUI", MOD_BIT(KC_LGUI)},
+    {"RCTL", MOD_BIT(KC_RCTL)}, {"RSFT", MOD_BIT(KC_RSFT)}, {"RALT", MOD_BIT(KC_RALT)}, {"RGUI", MOD_BIT(KC_RGUI)},
+};
+
+static const scn_name_t scn_layers[] = {
+    {"_BASE", _BASE}, {"_QWT", _QWT}, {"_GAM1", _GAM1}, {"_GAM2", _GAM2}, {"_NAV", _NAV}, {"_NUM", _NUM},
+    {"_SYM", _SYM},   {"_FUN", _FUN}, {"_MED", _MED},   {"_SYS", _SYS},   {"_MBO", _MBO},
+};
+
+static const scn_name_t scn_resolutions[] = {
+    {"uncertain", SMTD_RESOLUTION_UNCERTAIN},
+    {"determined", SMTD_RESOLUTION_DETERMINED},
+    {"unhandled", SMTD_RESOLUTION_UNHANDLED},
+};
+
+#define SCN_COUNT(array) (sizeof(array) / sizeof((array)[0]))
+
+/* ------------------------------------------------------------------------ *
+ * The scenario being run
+ * ------------------------------------------------------------------------ */
+
+static struct {
+    const char *file;
+    int         line; ///< Where the scenario starts
+    char        name[SCN_LINE_MAX];
+    history_t   expected[MAX_HISTORY];
+    uint8_t     expected_len;
+    int         resolution; ///< What the last SM_TD action returned
+    bool        failed;
+    char        message[SCN_MESSAGE_MAX];
+} scn;
+
+static void scn_fail(int line, const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+static void scn_fail(int line, const char *format, ...) {
+    if (scn.failed) {
+        return;
+    }
+    scn.failed = true;
+
+    int     written = snprintf(scn.message, sizeof(scn.message), "line %d: ", line);
+    va_list args;
+    va_start(args, format);
+    vsnprintf(scn.message + written, sizeof(scn.message) - written, format, args);
+    va_end(args);
+}
+
+/* ------------------------------------------------------------------------ *
+ * Names
+ * ------------------------------------------------------------------------ */
+
+static bool scn_lookup(const scn_name_t *names, size_t count, const char *token, uint16_t *out) {
+    for (size_t i = 0; i < count; i++) {
+        if (strcmp(names[i].name, token) == 0) {
+            *out = names[i].value;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool scn_number(const char *token, long *out) {
+    char *end;
+    *out = strtol(token, &end, 0);
+    return *token != '\0' && *end == '\0';
+}
+
+static bool scn_keycode(const char *token, uint16_t *out) {
+    long value;
+    if (scn_lookup(scn_keycodes, SCN_COUNT(scn_keycodes), token, out)) {
+        return true;
+    }
+    if (scn_number(token, &value) && value >= 0 && value <= UINT16_MAX) {
+        *out = (uint16_t)value;
+        return true;
+    }
+    return false;
+}
+
+static bool scn_mod_mask(const char *token, uint8_t *out) {
+    char buffer[SCN_LINE_MAX];
+    *out = 0;
+    if (strcmp(token, "none") == 0) {
+        return true;
+    }
+
+    snprintf(buffer, sizeof(buffer), "%s", token);
+    for (char *name = strtok(buffer, "|"); name; name = strtok(NULL, "|")) {
+        uint16_t bit;
+        if (!scn_lookup(scn_mods, SCN_COUNT(scn_mods), name, &bit)) {
+            return false;
+        }
+        *out |= (uint8_t)bit;
+    }
+    return true;
+}
+
+static bool scn_on_off(const char *token, bool *out) {
+    if (strcmp(token, "on") == 0 || strcmp(token, "off") == 0) {
+        *out = token[1] == 'n';
+        return true;
+    }
+    return false;
+}
+
+/* The name of value in names, or value as hex in buffer. */
+static const char *scn_name_of(const scn_name_t *names, size_t count, int value, char *buffer, size_t size) {
+    for (size_t i = 0; i < count; i++) {
+        if (names[i].value == value) {
+            return names[i].name;
+        }
+    }
+    snprintf(buffer, size, "0x%04X", value);
+    return buffer;
+}
+
+static void scn_format_mods(char *out, size_t size, uint8_t mods) {
+    size_t used = 0;
+    out[0]      = '\0';
+    if (mods == 0) {
+        snprintf(out, size, "none");
+        return;
+    }
+    for (size_t i = 0; i < SCN_COUNT(scn_mods); i++) {
+        if (mods & scn_mods[i].value) {
+            used += snprintf(out + used, size - used, "%s%s", used ? "|" : "", scn_mods[i].name);
+        }
+    }
+}
+
+/* ------------------------------------------------------------------------ *
+ * History
+ * ------------------------------------------------------------------------ */
+
+static size_t scn_format_events(char *out, size_t size, const history_t *events, uint8_t count) {
+    size_t used = snprintf(out, size, "%s", count ? "" : " (nothing)");
+    for (uint8_t i = 0; i < count && used < size; i++) {
+        char mods[64], number[8];
+        scn_format_mods(mods, sizeof(mods), events[i].mods);
+        used += snprintf(out + used, size - used, "\n        %s %s %s", scn_name_of(scn_keycodes, SCN_COUNT(scn_keycodes), events[i].keycode, number, sizeof(number)), events[i].pressed ? "down" : "up", mods);
+    }
+    return used;
+}
+
+/* The recorded history must be exactly the events declared so far. */
+static void scn_check_history(int line) {
+    bool same = history_len == scn.expected_len;
+    for (uint8_t i = 0; same && i < history_len; i++) {
+        same = history[i].keycode == scn.expected[i].keycode && history[i].pressed == scn.expected[i].pressed && history[i].mods == scn.expected[i].mods;
+    }
+    if (same) {
+        return;
+    }
+
+    char expected[SCN_MESSAGE_MAX / 2];
+    char recorded[SCN_MESSAGE_MAX / 2];
+    scn_format_events(expected, sizeof(expected), scn.expected, scn.expected_len);
+    scn_format_events(recorded, sizeof(recorded), history, history_len);
+    scn_fail(line, "events differ\n    expected:%s\n    recorded:%s", expected, recorded);
+}
+
+/* ------------------------------------------------------------------------ *
+ * Steps
+ * ------------------------------------------------------------------------ */
+
+#define SCN_ARG(i) (i < argc ? argv[i] : "")
+
+static void scn_smtd(int line, smtd_action action, int argc, char **argv) {
+    uint16_t keycode;
+    long     tap_count = 0;
+    if (argc < 2 || argc > 3 || !scn_keycode(argv[1], &keycode) || (argc == 3 && (!scn_number(argv[2], &tap_count) || tap_count < 0 || tap_count > UINT8_MAX))) {
+        scn_fail(line, "usage: %s KEYCODE [TAP_COUNT]", argv[0]);
+        return;
+    }
+    scn.resolution = on_smtd_action(keycode, action, (uint8_t)tap_count);
+}
+
+/* "X Y" or "X Y H V", starting at argv[0]; the count of tokens used. */
+static int scn_report(int argc, char **argv, report_mouse_t *report) {
+    long values[4] = {0};
+    int  used      = argc >= 4 && strcmp(argv[2], "/") != 0 ? 4 : 2;
+    if (argc < used) {
+        return 0;
+    }
+    for (int i = 0; i < used; i++) {
+        if (!scn_number(argv[i], &values[i]) || values[i] < INT16_MIN || values[i] > INT16_MAX) {
+            return 0;
+        }
+    }
+    *report = (report_mouse_t){.x = values[0], .y = values[1], .h = values[2], .v = values[3], .buttons = 0};
+    return used;
+}
+
+static void scn_action(int line, int argc, char **argv) {
+    const char *verb = argv[0];
+    uint16_t    value;
+    uint8_t     mods;
+    long        number;
+    bool        on;
+
+    scn_check_history(line);
+    if (scn.failed) {
+        return;
+    }
+
+    if ((strcmp(verb, "press") == 0 || strcmp(verb, "release") == 0) && argc == 2 && scn_keycode(argv[1], &value)) {
+        T_key(value, verb[0] == 'p');
+    } else if ((strcmp(verb, "game-press") == 0 || strcmp(verb, "game-release") == 0) && (argc == 2 || argc == 3) &&
+               scn_keycode(argv[1], &value)) {
+        number = 0;
+        if (argc == 3 && (!scn_number(argv[2], &number) || number < 0 || number >= MATRIX_COLS)) {
+            scn_fail(line, "bad column: %s", argv[2]);
+        } else if (!T_game_event(value, (uint8_t)number, verb[5] == 'p')) {
+            scn_fail(line, "%s %s: not taken by game mode", verb, argv[1]);
+        }
+    } else if (strcmp(verb, "touch") == 0) {
+        scn_smtd(line, SMTD_ACTION_TOUCH, argc, argv);
+    } else if (strcmp(verb, "tap") == 0) {
+        scn_smtd(line, SMTD_ACTION_TAP, argc, argv);
+    } else if (strcmp(verb, "hold") == 0) {
+        scn_smtd(line, SMTD_ACTION_HOLD, argc, argv);
+    } else if (strcmp(verb, "lift") == 0) {
+        scn_smtd(line, SMTD_ACTION_RELEASE, argc, argv);
+    } else if (strcmp(verb, "move") == 0) {
+        report_mouse_t report;
+        if (argc < 3 || scn_report(argc - 1, argv + 1, &report) != argc - 1) {
+            scn_fail(line, "usage: move X Y [H V]");
+            return;
+        }
+        pointing_device_task_kb(report);
+    } else if (strcmp(verb, "balls") == 0) {
+        report_mouse_t left, right;
+        int            used  = scn_report(argc - 1, argv + 1, &left);
+        int            right_count = argc - used - 2;
+        if (used == 0 || strcmp(SCN_ARG(used + 1), "/") != 0 || right_count < 2 || scn_report(right_count, argv + used + 2, &right) != right_count) {
+            scn_fail(line, "usage: balls LX LY [LH LV] / RX RY [RH RV]");
+            return;
+        }
+        pointing_device_task_kb(pointing_device_task_combined_user(left, right));
+    } else if (strcmp(verb, "wait") == 0 && argc == 2 && scn_number(argv[1], &number) && number >= 0) {
+        TEST_advance_time((uint32_t)number);
+    } else if (strcmp(verb, "set-mods") == 0 && argc == 2 && scn_mod_mask(argv[1], &mods)) {
+        set_mods(mods);
+    } else if (strcmp(verb, "set-oneshot") == 0 && argc == 2 && scn_mod_mask(argv[1], &mods)) {
+        set_oneshot_mods(mods);
+    } else if (strcmp(verb, "claim") == 0 && argc == 2 && scn_mod_mask(argv[1], &mods)) {
+        mods_acquire(mods);
+    } else if (strcmp(verb, "unclaim") == 0 && argc == 2 && scn_mod_mask(argv[1], &mods)) {
+        mods_release(mods);
+    } else if (strcmp(verb, "begin") == 0 && argc == 1) {
+        mods_begin();
+    } else if (strcmp(verb, "commit") == 0 && argc == 1) {
+        mods_commit();
+    } else if (strcmp(verb, "commit-press") == 0 && argc == 2 && scn_keycode(argv[1], &value)) {
+        mods_commit_press(value);
+    } else if (strcmp(verb, "commit-release") == 0 && argc == 2 && scn_keycode(argv[1], &value)) {
+        mods_commit_release(value);
+    } else if (strcmp(verb, "layer-on") == 0 && argc == 2 && scn_lookup(scn_layers, SCN_COUNT(scn_layers), argv[1], &value)) {
+        layer_on((uint8_t)value);
+    } else if (strcmp(verb, "layer-off") == 0 && argc == 2 && scn_lookup(scn_layers, SCN_COUNT(scn_layers), argv[1], &value)) {
+        layer_off((uint8_t)value);
+    } else if (strcmp(verb, "layer-move") == 0 && argc == 2 && scn_lookup(scn_layers, SCN_COUNT(scn_layers), argv[1], &value)) {
+        layer_move((uint8_t)value);
+    } else if (strcmp(verb, "left-scroll") == 0 && argc == 2 && scn_on_off(argv[1], &on)) {
+        global_saved_values.left_scroll = on;
+    } else if (strcmp(verb, "auto-mouse") == 0 && argc == 2 && scn_on_off(argv[1], &on)) {
+        global_saved_values.auto_mouse = on;
+    } else if (strcmp(verb, "dpi") == 0 && argc == 2 && scn_number(argv[1], &number) && number >= 0 && number <= UINT8_MAX) {
+        global_saved_values.right_dpi_index = (uint8_t)number;
+    } else {
+        scn_fail(line, "not a step: %s", verb);
+    }
+}
+
+static void scn_expect_event(int line, int argc, char **argv) {
+    uint16_t keycode;
+    uint8_t  mods = 0;
+    bool     down = strcmp(SCN_ARG(2), "down") == 0;
+
+    if (argc < 3 || argc > 4 || !scn_keycode(argv[1], &keycode) || (!down && strcmp(argv[2], "up") != 0) || (argc == 4 && !scn_mod_mask(argv[3], &mods))) {
+        scn_fail(line, "usage: => KEYCODE down|up [MODS]");
+        return;
+    }
+    if (scn.expected_len == MAX_HISTORY) {
+        scn_fail(line, "more than %d events", MAX_HISTORY);
+        return;
+    }
+    scn.expected[scn.expected_len++] = (history_t){.keycode = keycode, .pressed = down, .mods = mods};
+}
+
+static void scn_check_flag(int line, const char *what, const char *token, bool actual) {
+    bool expected;
+    if (!scn_on_off(token, &expected)) {
+        scn_fail(line, "usage: check %s on|off", what);
+    } else if (actual != expected) {
+        scn_fail(line, "%s is %s, expected %s", what, actual ? "on" : "off", token);
+    }
+}
+
+static void scn_check_mods(int line, const char *what, const char *token, uint8_t actual) {
+    uint8_t expected;
+    char    names[64];
+    if (!scn_mod_mask(token, &expected)) {
+        scn_fail(line, "usage: check %s MODS", what);
+    } else if (actual != expected) {
+        scn_format_mods(names, sizeof(names), actual);
+        scn_fail(line, "%s are %s, expected %s", what, names, token);
+    }
+}
+
+static void scn_check(int line, int argc, char **argv) {
+    const char *what = SCN_ARG(1);
+    uint16_t    value;
+    uint8_t     mods;
+    long        number;
+
+    if (strcmp(what, "mods") == 0 && argc == 3) {
+        scn_check_mods(line, what, argv[2], get_mods());
+    } else if (strcmp(what, "oneshot") == 0 && argc == 3) {
+        scn_check_mods(line, "oneshot mods", argv[2], get_oneshot_mods());
+    } else if (strcmp(what, "claims") == 0 && argc == 4 && scn_mod_mask(argv[2], &mods) && scn_number(argv[3], &number)) {
+        if (mods_claim_count(mods) != number) {
+            scn_fail(line, "%s has %d claims, expected %ld", argv[2], mods_claim_count(mods), number);
+        }
+    } else if (strcmp(what, "layer") == 0 && argc == 4 && scn_lookup(scn_layers, SCN_COUNT(scn_layers), argv[2], &value)) {
+        scn_check_flag(line, argv[2], argv[3], layer_state_is((uint8_t)value));
+    } else if (strcmp(what, "auto-mouse") == 0 && argc == 3) {
+        scn_check_flag(line, what, argv[2], global_saved_values.auto_mouse);
+    } else if (strcmp(what, "caps-word") == 0 && argc == 3) {
+        scn_check_flag(line, what, argv[2], is_caps_word_on());
+    } else if (strcmp(what, "mouse-mode") == 0 && argc == 3) {
+        scn_check_flag(line, what, argv[2], mouse_mode_state);
+    } else if (strcmp(what, "resolution") == 0 && argc == 3 && scn_lookup(scn_resolutions, SCN_COUNT(scn_resolutions), argv[2], &value)) {
+        char number[8];
+        if (scn.resolution != value) {
+            scn_fail(line, "resolution is %s, expected %s", scn_name_of(scn_resolutions, SCN_COUNT(scn_resolutions), scn.resolution, number, sizeof(number)), argv[2]);
+        }
+    } else {
+        scn_fail(line, "not a check: %s", what);
+    }
+}
+
+/* ------------------------------------------------------------------------ *
+ * Files
+ * ------------------------------------------------------------------------ */
+
+static int scn_total, scn_failures;
+
+static void scn_begin(const char *file, int line, const char *name) {
+    scn.file         = file;
+    scn.line         = line;
+    scn.expected_len = 0;
+    scn.resolution   = -1;
+    scn.failed       = false;
+    snprintf(scn.name, sizeof(scn.name), "%s", name);
+
+    TEST_reset();
+    T_reset();
+}
+
+static void scn_end(int line) {
+    scn_check_history(line);
+    if (history_len == MAX_HISTORY) {
+        scn_fail(line, "the event history filled up; split the scenario");
+    }
+    if (get_mods() != 0) {
+        scn_check_mods(line, "modifiers left at the end", "none", get_mods());
+    }
+    for (uint8_t bit = 1; bit != 0; bit <<= 1) {
+        if (mods_claim_count(bit) != 0) {
+            scn_fail(line, "a claim on mod bit 0x%02X is left at the end", bit);
+        }
+    }
+
+    scn_total++;
+    if (scn.failed) {
+        scn_failures++;
+        printf("FAIL %s:%d: %s\n    %s\n", scn.file, scn.line, scn.name, scn.message);
+    } else {
+        printf("ok %s:%d: %s\n", scn.file, scn.line, scn.name);
+    }
+}
+
+static int scn_tokenize(char *text, char **argv) {
+    int argc = 0;
+    for (char *token = strtok(text, " \t\r\n"); token && argc < SCN_TOKENS_MAX; token = strtok(NULL, " \t\r\n")) {
+        argv[argc++] = token;
+    }
+    return argc;
+}
+
+static bool scn_run_file(const char *path) {
+    char  text[SCN_LINE_MAX];
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+
+    bool open_scenario = false;
+    int  line          = 0;
+    while (fgets(text, sizeof(text), f)) {
+        line++;
+        char *start = text + strspn(text, " \t");
+        if (*start == '#' || *start == '\n' || *start == '\0') {
+            continue;
+        }
+
+        if (strncmp(start, "scenario:", 9) == 0) {
+            if (open_scenario) {
+                scn_end(line - 1);
+            }
+            char *name = start + 9 + strspn(start + 9, " \t");
+            name[strcspn(name, "\r\n")] = '\0';
+            scn_begin(path, line, name);
+            open_scenario = true;
+            continue;
+        }
+
+        if (!open_scenario) {
+            fprintf(stderr, "%s:%d: step outside a scenario\n", path, line);
+            fclose(f);
+            return false;
+        }
+        if (scn.failed) {
+            continue;
+        }
+
+        char *argv[SCN_TOKENS_MAX] = {0};
+        int   argc                 = scn_tokenize(start, argv);
+        if (argc == 0) {
+            continue;
+        } else if (strcmp(argv[0], "=>") == 0) {
+            scn_expect_event(line, argc, argv);
+        } else if (strcmp(argv[0], "check") == 0) {
+            scn_check(line, argc, argv);
+        } else {
+            scn_action(line, argc, argv);
+        }
+    }
+    if (open_scenario) {
+        scn_end(line);
+    }
+
+    fclose(f);
+    return true;
+}
+
+int main(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        if (!scn_run_file(argv[i])) {
+            return 2;
+        }
+    }
+    printf("%d scenarios, %d failed\n", scn_total, scn_failures);
+    return scn_failures ? 1 : 0;
+}
@@ -0,0 +1,277 @@
+#!/usr/bin/env python3
+"""Read and change the firmware's runtime settings over raw HID.
+
+    python3 tools/townk_hid.py motion                   # show every knob
+    python3 tools/townk_hid.py motion coherence 192     # set one, right ball
+    python3 tools/townk_hid.py motion threshold 12 --ball left
+    python3 tools/townk_hid.py trace                    # dump the flight recorder
+    python3 tools/townk_hid.py trace --clear            # start a fresh recording
+    python3 tools/townk_hid.py latency                  # press-to-report delays
+    python3 tools/townk_hid.py latency --clear
+    python3 tools/townk_hid.py streak                   # typing-streak fast path
+    python3 tools/townk_hid.py streak --clear
+    python3 tools/townk_hid.py rgb                      # RGB layer writes skipped
+    python3 tools/townk_hid.py rgb --clear
+
+Speaks the custom-value packets described in users/townk/townk_hid.h on the
+Vial/VIA raw HID interface, so it needs the `hidapi` Python package
+(`pip install hidapi`) and nothing else. Changes take effect at once and last
+until the board is power-cycled.
+
+The flight recorder (users/townk/townk_trace.h) holds the last few hundred
+MB_* key, modifier, SM_TD and layer decisions. Reproduce the problem, then run
+`trace` straight away, before the records of interest are overwritten.
+
+The latency histograms (users/townk/townk_latency.h) count how long the keys
+that hold their output back -- the SM_TD layer-taps and the MB_* clicks and
+drags -- took from the key press to the report. Clear them, type for a while,
+then read them to see what a change to the SM_TD terms really did.
+
+The streak counters (users/townk/townk_smtd.h) count the layer-taps sent as a
+tap the moment they were pressed, mid-streak, against those SM_TD resolved
+the usual way.
+
+The RGB layer counters (users/townk/townk_layers.h) count the layer segments
+each layer change wrote, against those it left alone because their layer had
+not changed.
+"""
+
+import argparse
+import sys
+
+VENDOR_ID = 0x303A  # vial.json
+PRODUCT_ID = 0x4044
+RAW_USAGE_PAGE = 0xFF60  # QMK's raw HID interface
+RAW_USAGE = 0x61
+REPORT_SIZE = 32
+
+ID_CUSTOM_SET_VALUE = 0x07
+ID_CUSTOM_GET_VALUE = 0x08
+ID_UNHANDLED = 0xFF
+TOWNK_HID_CHANNEL = 0x54
+
+# townk_hid_value_id_t
+MOTION = {
+    "threshold": 0x01,
+    "reset_ms": 0x02,
+    "window_ms": 0x03,
+    "min_velocity": 0x04,
+    "coherence": 0x05,
+}
+BALLS = {"left": 0, "right": 1}
+TRACE_READ = 0x10
+TRACE_INFO = 0x11
+TRACE_RECORD_SIZE = 8
+LATENCY_HISTOGRAM = 0x20
+LATENCY_BUCKETS = 12
+LATENCY_CLASSES = ["layer-tap tap", "layer-tap hold", "MB_* click", "MB_* drag"]
+SMTD_STREAK = 0x30
+RGB_LAYERS = 0x40
+
+# townk_trace_type_t, townk_trace_role_t and the tables they index into. The
+# MB_* keys are the keymap's MB_KEYS, in order.
+TRACE_TYPES = {
+    1: "mb-press", 2: "mb-resolve", 3: "mb-release",
+    4: "mods-acquire", 5: "mods-release",
+    6: "smtd", 7: "layer",
+}
+ROLES = ["undecided", "click", "modifier", "drag", "button"]
+MB_KEYS = ["MB_SFT", "MB_ALT", "MB_GUI", "MB_CTL"]
+MODS = ["LCTL", "LSFT", "LALT", "LGUI", "RCTL", "RSFT", "RALT", "RGUI"]
+SMTD_ACTIONS = ["touch", "tap", "hold", "release"]
+LAYERS = {0: "BASE", 1: "QWT", 2: "GAM1", 3: "GAM2", 4: "NAV", 5: "NUM",
+          6: "SYM", 7: "FUN", 8: "MED", 14: "SYS", 15: "MBO"}
+
+
+def open_board():
+    """Open the board's raw HID interface, or exit with a reason."""
+    try:
+        import hid
+    except ImportError:
+        sys.exit("needs the hidapi package: pip install hidapi")
+
+    for info in hid.enumerate(VENDOR_ID, PRODUCT_ID):
+        if info["usage_page"] == RAW_USAGE_PAGE and info["usage"] == RAW_USAGE:
+            device = hid.device()
+            device.open_path(info["path"])
+            return device
+
+    sys.exit("no Svalboard raw HID interface found")
+
+
+def transact(device, command: int, value_id: int, ball: int, value: int = 0) -> bytes:
+    """Send one custom-value packet and return the board's reply."""
+    packet = bytes([command, TOWNK_HID_CHANNEL, value_id, ball,
+                    value >> 8, value & 0xFF]).ljust(REPORT_SIZE, b"\0")
+    device.write(b"\0" + packet)  # leading report ID
+    reply = bytes(device.read(REPORT_SIZE, 1000))
+    if len(reply) < 6 or reply[0] == ID_UNHANDLED:
+        sys.exit("the firmware refused the request (too old, or a bad value)")
+    return reply
+
+
+def names(table: list[str], mask: int) -> str:
+    """The names of the bits set in mask, or '-'."""
+    return "+".join(n for i, n in enumerate(table) if mask & (1 << i)) or "-"
+
+
+def describe(kind: int, a: int, b: int) -> str:
+    """One record, the way townk_trace_type_t documents its fields."""
+    def role(r: int) -> str:
+        return ROLES[r] if r < len(ROLES) else str(r)
+
+    if kind in (1, 3):
+        key = MB_KEYS[a] if a < len(MB_KEYS) else f"MB_KEYS[{a}]"
+        return f"{key} as {role(b)}"
+    if kind == 2:
+        return f"{names(MB_KEYS, b)} -> {role(a)}"
+    if kind in (4, 5):
+        return f"{names(MODS, a)}, now held: {names(MODS, b)}"
+    if kind == 6:
+        action = SMTD_ACTIONS[a & 0x0F] if a & 0x0F < 4 else str(a & 0x0F)
+        return f"0x{b:04X} {action} (tap count {a >> 4})"
+    if kind == 7:
+        active = [LAYERS.get(i, str(i)) for i in range(16) if b & (1 << i)]
+        return f"{LAYERS.get(a, str(a))} on top of {'+'.join(active) or '-'}"
+    return f"a=0x{a:02X} b=0x{b:04X}"
+
+
+def dump_trace(device) -> None:
+    """Print every record the ring still holds, oldest first."""
+    reply = transact(device, ID_CUSTOM_GET_VALUE, TRACE_INFO, 0)
+    head, size = reply[3] << 8 | reply[4], reply[5] << 8 | reply[6]
+    seq = (head - min(head, size)) & 0xFFFF  # all written, or the last `size`
+
+    start = None
+    while seq != head:
+        reply = transact(device, ID_CUSTOM_GET_VALUE, TRACE_READ,
+                         seq >> 8, (seq & 0xFF) << 8)
+        if reply[5] == 0:
+            break  # overtaken by new records while reading
+        for i in range(reply[5]):
+            r = reply[6 + TRACE_RECORD_SIZE * i:][:TRACE_RECORD_SIZE]
+            time = int.from_bytes(r[0:4], "big")
+            start = time if start is None else start
+            kind = TRACE_TYPES.get(r[4], f"type {r[4]}")
+            print(f"{time - start:>8} ms  {kind:<13} "
+                  f"{describe(r[4], r[5], r[6] << 8 | r[7])}")
+        seq = (seq + reply[5]) & 0xFFFF
+
+
+def bucket_range(bucket: int) -> str:
+    """The milliseconds a townk_latency.h histogram bucket counts."""
+    if bucket == 0:
+        return "0 ms"
+    low = 1 << (bucket - 1)
+    if bucket == LATENCY_BUCKETS - 1:
+        return f"{low}+ ms"
+    return f"{low}-{(low << 1) - 1} ms"
+
+
+def dump_latency(device) -> None:
+    """Print every class's histogram, with a bar per bucket."""
+    for cls, name in enumerate(LATENCY_CLASSES):
+        reply = transact(device, ID_CUSTOM_GET_VALUE, LATENCY_HISTOGRAM, cls)
+        counts = [reply[4 + 2 * b] << 8 | reply[5 + 2 * b]
+                  for b in range(LATENCY_BUCKETS)]
+        print(f"{name} ({sum(counts)} presses)")
+        peak = max(counts) or 1
+        for b, count in enumerate(counts):
+            if count:
+                print(f"  {bucket_range(b):>13} {count:>6} "
+                      f"{'#' * max(1, 40 * count // peak)}")
+
+
+def dump_streak(device) -> None:
+    """Print how often the typing-streak fast path was taken."""
+    reply = transact(device, ID_CUSTOM_GET_VALUE, SMTD_STREAK, 0)
+    fast = int.from_bytes(reply[3:7], "big")
+    slow = int.from_bytes(reply[7:11], "big")
+    total = fast + slow
+    share = f" ({100 * fast / total:.1f}%)" if total else ""
+    print(f"fast path    {fast:>8}{share}")
+    print(f"resolved     {slow:>8}")
+
+
+def dump_rgb(device) -> None:
+    """Print how many RGB layer segment writes layer changes made and skipped."""
+    reply = transact(device, ID_CUSTOM_GET_VALUE, RGB_LAYERS, 0)
+    written = int.from_bytes(reply[3:7], "big")
+    skipped = int.from_bytes(reply[7:11], "big")
+    total = written + skipped
+    share = f" ({100 * skipped / total:.1f}%)" if total else ""
+    print(f"written      {written:>8}")
+    print(f"skipped      {skipped:>8}{share}")
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    sub = parser.add_subparsers(dest="group", required=True)
+
+    motion = sub.add_parser("motion", help="the MB_* drag classifier")
+    motion.add_argument("name", nargs="?", choices=MOTION)
+    motion.add_argument("value", nargs="?", type=int)
+    motion.add_argument("--ball", choices=BALLS, default="right")
+
+    trace = sub.add_parser("trace", help="the input decision flight recorder")
+    trace.add_argument("--clear", action="store_true",
+                       help="forget every record instead of printing them")
+
+    latency = sub.add_parser("latency", help="press-to-report latency histograms")
+    latency.add_argument("--clear", action="store_true",
+                         help="empty the histograms instead of printing them")
+
+    streak = sub.add_parser("streak", help="typing-streak fast-path counters")
+    streak.add_argument("--clear", action="store_true",
+                        help="zero the counters instead of printing them")
+
+    rgb = sub.add_parser("rgb", help="RGB layer segment write counters")
+    rgb.add_argument("--clear", action="store_true",
+                     help="zero the counters instead of printing them")
+
+    args = parser.parse_args()
+    device = open_board()
+
+    if args.group == "rgb":
+        if args.clear:
+            transact(device, ID_CUSTOM_SET_VALUE, RGB_LAYERS, 0)
+        else:
+            dump_rgb(device)
+        return 0
+
+    if args.group == "streak":
+        if args.clear:
+            transact(device, ID_CUSTOM_SET_VALUE, SMTD_STREAK, 0)
+        else:
+            dump_streak(device)
+        return 0
+
+    if args.group == "latency":
+        if args.clear:
+            transact(device, ID_CUSTOM_SET_VALUE, LATENCY_HISTOGRAM, 0)
+        else:
+            dump_latency(device)
+        return 0
+
+    if args.group == "trace":
+        if args.clear:
+            transact(device, ID_CUSTOM_SET_VALUE, TRACE_INFO, 0)
+        else:
+            dump_trace(device)
+        return 0
+
+    ball = BALLS[args.ball]
+
+    if args.value is not None:
+        transact(device, ID_CUSTOM_SET_VALUE, MOTION[args.name], ball, args.value)
+
+    names = [args.name] if args.name else list(MOTION)
+    for name in names:
+        reply = transact(device, ID_CUSTOM_GET_VALUE, MOTION[name], ball)
+        print(f"{args.ball} {name:<13} {reply[4] << 8 | reply[5]}")
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -20,16 +20,26 @@ SRC += keymap_support.c
 # rather than as a community module, so that process_record_user() can guard
 # it against Repeat Key's replayed records — the module hook runs before
 # anything the userspace controls and offers no such seam. The module
-# manifest only auto-enabled deferred_exec, replicated here.
+# manifest only auto-enabled deferred_exec, replicated here. sm_td.c is
+# compiled through townk_sm_td.c, which sends its keycode lookup to the
+# transparency-resolving cache in townk_keycache.c.
 VPATH += $(QMK_USERSPACE)/modules/stasmarkin/sm_td
-SRC += sm_td.c
+SRC += townk_sm_td.c
 DEFERRED_EXEC_ENABLE = yes
 
+SRC += townk_eeconfig.c
+SRC += townk_hid.c
+SRC += townk_keycache.c
+SRC += townk_latency.c
 SRC += townk_layers.c
 SRC += townk_mods.c
 SRC += townk_mouse.c
 SRC += townk_overrides.c
+SRC += townk_pointing.c
+SRC += townk_record.c
 SRC += townk_smtd.c
+SRC += townk_socd.c
+SRC += townk_trace.c
 
 CFLAGS += -fcommon
 
@@ -0,0 +1,148 @@
+/* Copyright (C) 2025 Thiago Alves (https://github.com/townk)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file townk_eeconfig.c
+ * @brief This userspace's persistent settings -- see townk_eeconfig.h
+ *
+ * @author Thiago Alves
+ */
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "eeconfig.h"
+#include "timer.h"
+
+#include "townk_eeconfig.h"
+
+/** Minimum time between two EEPROM writes (default: 10 minutes). */
+#ifndef TOWNK_EECONFIG_SAVE_INTERVAL_MS
+#    define TOWNK_EECONFIG_SAVE_INTERVAL_MS 600000
+#endif
+
+#define TOWNK_EECONFIG_FIELD_BITS 5
+#define TOWNK_EECONFIG_FIELD_MASK ((1u << TOWNK_EECONFIG_FIELD_BITS) - 1)
+#define TOWNK_EECONFIG_FIELDS 6
+#define TOWNK_EECONFIG_VERSION_SHIFT 30
+
+#if defined(EECONFIG_USER_DATA_SIZE) && EECONFIG_USER_DATA_SIZE > 0
+#    define TOWNK_EECONFIG_DATABLOCK
+_Static_assert(sizeof(townk_eeconfig_data_t) <= EECONFIG_USER_DATA_SIZE, "EECONFIG_USER_DATA_SIZE is too small for townk_eeconfig_data_t");
+#endif
+
+static uint32_t townk_eeconfig_raw       = 0;
+static bool     townk_eeconfig_dirty     = false;
+static uint32_t townk_eeconfig_last_save = 0;
+
+static townk_eeconfig_data_t townk_eeconfig_data       = {0};
+static bool                  townk_eeconfig_data_dirty = false;
+
+/**
+ * @brief An empty word of the current version
+ * @private
+ */
+static uint32_t townk_eeconfig_default(void) {
+    return (uint32_t)TOWNK_EECONFIG_VERSION << TOWNK_EECONFIG_VERSION_SHIFT;
+}
+
+void eeconfig_init_user(void) {
+    townk_eeconfig_raw   = townk_eeconfig_default();
+    townk_eeconfig_dirty = false;
+    eeconfig_update_user(townk_eeconfig_raw);
+
+    townk_eeconfig_data       = (townk_eeconfig_data_t){0};
+    townk_eeconfig_data_dirty = false;
+#ifdef TOWNK_EECONFIG_DATABLOCK
+    eeconfig_update_user_datablock(&townk_eeconfig_data, 0, sizeof(townk_eeconfig_data));
+#endif
+}
+
+void townk_eeconfig_init(void) {
+    townk_eeconfig_raw = eeconfig_read_user();
+    if ((townk_eeconfig_raw >> TOWNK_EECONFIG_VERSION_SHIFT) != TOWNK_EECONFIG_VERSION) {
+        eeconfig_init_user();
+    } else {
+#ifdef TOWNK_EECONFIG_DATABLOCK
+        eeconfig_read_user_datablock(&townk_eeconfig_data, 0, sizeof(townk_eeconfig_data));
+#endif
+    }
+    townk_eeconfig_dirty      = false;
+    townk_eeconfig_data_dirty = false;
+    townk_eeconfig_last_save = timer_read32();
+}
+
+uint8_t townk_eeconfig_drag_threshold(uint8_t dpi_index) {
+    if (dpi_index >= TOWNK_EECONFIG_FIELDS) {
+        return 0;
+    }
+
+    return (townk_eeconfig_raw >> (dpi_index * TOWNK_EECONFIG_FIELD_BITS)) & TOWNK_EECONFIG_FIELD_MASK;
+}
+
+void townk_eeconfig_set_drag_threshold(uint8_t dpi_index, uint8_t threshold) {
+    if (dpi_index >= TOWNK_EECONFIG_FIELDS) {
+        return;
+    }
+    if (threshold > TOWNK_EECONFIG_DRAG_THRESHOLD_MAX) {
+        threshold = TOWNK_EECONFIG_DRAG_THRESHOLD_MAX;
+    }
+
+    uint8_t  shift = dpi_index * TOWNK_EECONFIG_FIELD_BITS;
+    uint32_t raw   = (townk_eeconfig_raw & ~(TOWNK_EECONFIG_FIELD_MASK << shift)) | ((uint32_t)threshold << shift);
+    if (raw != townk_eeconfig_raw) {
+        townk_eeconfig_raw   = raw;
+        townk_eeconfig_dirty = true;
+    }
+}
+
+bool townk_eeconfig_smtd_timing(uint8_t index, townk_smtd_timing_t *out) {
+    if (index >= TOWNK_EECONFIG_SMTD_KEYS || townk_eeconfig_data.smtd[index].tap_mean == 0) {
+        return false;
+    }
+
+    *out = townk_eeconfig_data.smtd[index];
+    return true;
+}
+
+void townk_eeconfig_set_smtd_timing(uint8_t index, const townk_smtd_timing_t *timing) {
+    if (index >= TOWNK_EECONFIG_SMTD_KEYS) {
+        return;
+    }
+
+    if (memcmp(&townk_eeconfig_data.smtd[index], timing, sizeof(*timing)) != 0) {
+        townk_eeconfig_data.smtd[index] = *timing;
+        townk_eeconfig_data_dirty       = true;
+    }
+}
+
+void townk_eeconfig_task(void) {
+    if (!(townk_eeconfig_dirty || townk_eeconfig_data_dirty) || timer_elapsed32(townk_eeconfig_last_save) < TOWNK_EECONFIG_SAVE_INTERVAL_MS) {
+        return;
+    }
+
+    if (townk_eeconfig_dirty) {
+        eeconfig_update_user(townk_eeconfig_raw);
+    }
+#ifdef TOWNK_EECONFIG_DATABLOCK
+    if (townk_eeconfig_data_dirty) {
+        eeconfig_update_user_datablock(&townk_eeconfig_data, 0, sizeof(townk_eeconfig_data));
+    }
+#endif
+    townk_eeconfig_dirty      = false;
+    townk_eeconfig_data_dirty = false;
+    townk_eeconfig_last_save  = timer_read32();
+}
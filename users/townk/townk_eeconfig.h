@@ -0,0 +1,116 @@
+/* Copyright (C) 2025 Thiago Alves (https://github.com/townk)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file townk_eeconfig.h
+ * @brief This userspace's persistent settings, in QMK's 32-bit user EEPROM
+ *        word
+ *
+ * The Svalboard keeps its own settings (global_saved_values) in its own
+ * EEPROM area; the user word that eeconfig_read_user() returns is free for the
+ * keymap, and this module owns it. Layout, low bit first:
+ *
+ * | bits  | content                                                    |
+ * |-------|------------------------------------------------------------|
+ * | 0-29  | learned MB_* drag threshold, 5 bits per MOUSE_DPI_* index; |
+ * |       | 0 means "nothing learned yet"                              |
+ * | 30-31 | TOWNK_EECONFIG_VERSION                                     |
+ *
+ * Settings too big for the word -- the learned SM_TD timing -- live in QMK's
+ * user datablock, when the keymap reserves one with EECONFIG_USER_DATA_SIZE
+ * (see townk_eeconfig_data_t). Without it they are kept in RAM only. The
+ * datablock is only trusted when the word's version matches.
+ *
+ * Reads come from a RAM copy. Writes only mark it dirty; townk_eeconfig_task()
+ * commits at most once per TOWNK_EECONFIG_SAVE_INTERVAL_MS, so a value that
+ * changes often cannot wear the flash out.
+ *
+ * @author Thiago Alves
+ */
+
+#ifndef QMK_USERSPACE_TOWNK_EECONFIG_H
+#define QMK_USERSPACE_TOWNK_EECONFIG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** Bumped when the layout changes; a mismatch resets the word and datablock. */
+#define TOWNK_EECONFIG_VERSION 2
+
+/** The largest drag threshold the 5-bit fields can hold. */
+#define TOWNK_EECONFIG_DRAG_THRESHOLD_MAX 31
+
+/** SM_TD keys whose learned timing can be kept. */
+#define TOWNK_EECONFIG_SMTD_KEYS 8
+
+/**
+ * @brief One SM_TD key's learned timing, in townk_smtd.c's fixed point
+ *
+ * All zero means nothing has been learned.
+ */
+typedef struct {
+    uint16_t tap_mean;  ///< Typical press-to-tap time
+    uint16_t tap_dev;   ///< Its mean absolute deviation
+    uint16_t hold_mean; ///< Typical press-to-release time of a hold
+    uint16_t hold_dev;  ///< Its mean absolute deviation
+} townk_smtd_timing_t;
+
+/** The user datablock's layout; EECONFIG_USER_DATA_SIZE must be at least this. */
+typedef struct {
+    townk_smtd_timing_t smtd[TOWNK_EECONFIG_SMTD_KEYS]; ///< By offset from RANGE_START
+} townk_eeconfig_data_t;
+
+/**
+ * @brief Load the word from EEPROM, resetting it if its version is stale
+ *
+ * Call once from keyboard_post_init_user(), before the first pointing task.
+ */
+void townk_eeconfig_init(void);
+
+/**
+ * @brief The drag threshold learned for a DPI index
+ * @return 0 if none has been learned (or the index is out of range)
+ */
+uint8_t townk_eeconfig_drag_threshold(uint8_t dpi_index);
+
+/**
+ * @brief Record a learned drag threshold, to be saved by the next
+ *        townk_eeconfig_task() that is due
+ *
+ * Values above TOWNK_EECONFIG_DRAG_THRESHOLD_MAX are stored as the maximum.
+ */
+void townk_eeconfig_set_drag_threshold(uint8_t dpi_index, uint8_t threshold);
+
+/**
+ * @brief The learned timing of the SM_TD key @p index keycodes after RANGE_START
+ * @return false, leaving @p out untouched, if nothing has been learned for it
+ */
+bool townk_eeconfig_smtd_timing(uint8_t index, townk_smtd_timing_t *out);
+
+/**
+ * @brief Record an SM_TD key's learned timing, to be saved by the next
+ *        townk_eeconfig_task() that is due
+ */
+void townk_eeconfig_set_smtd_timing(uint8_t index, const townk_smtd_timing_t *timing);
+
+/**
+ * @brief Write pending changes to EEPROM when the save interval allows
+ *
+ * Cheap when there is nothing to do; call it from housekeeping_task_user().
+ */
+void townk_eeconfig_task(void);
+
+#endif // QMK_USERSPACE_TOWNK_EECONFIG_H
@@ -0,0 +1,270 @@
+/* Copyright (C) 2025 Thiago Alves (https://github.com/townk)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file townk_hid.c
+ * @brief Runtime tuning over VIA's raw HID custom-value commands -- see
+ *        townk_hid.h for the packet layout
+ *
+ * QMK routes every custom-value command to via_custom_value_command_kb(),
+ * whose default hands it on to the _user hook here. A keyboard that defines
+ * its own _kb hook must forward other channels to _user for this to be
+ * reached.
+ *
+ * @author Thiago Alves
+ */
+
+#ifdef VIA_ENABLE
+
+#    include "via.h"
+
+#    include "townk_hid.h"
+#    include "townk_latency.h"
+#    include "townk_layers.h"
+#    include "townk_mouse.h"
+#    include "townk_smtd.h"
+#    include "townk_trace.h"
+
+/**
+ * @brief Map a motion value ID to the classifier knob it addresses
+ * @return MB_MOTION_PARAM_COUNT for any other value ID
+ * @private
+ */
+static mb_motion_param_t townk_hid_motion_param(uint8_t value_id) {
+    switch (value_id) {
+        case TOWNK_HID_MOTION_THRESHOLD:    return MB_MOTION_THRESHOLD;
+        case TOWNK_HID_MOTION_RESET_MS:     return MB_MOTION_RESET_MS;
+        case TOWNK_HID_MOTION_WINDOW_MS:    return MB_MOTION_WINDOW_MS;
+        case TOWNK_HID_MOTION_MIN_VELOCITY: return MB_MOTION_MIN_VELOCITY;
+        case TOWNK_HID_MOTION_COHERENCE:    return MB_MOTION_COHERENCE;
+        default:                            return MB_MOTION_PARAM_COUNT;
+    }
+}
+
+/**
+ * @brief Get or set one motion classifier knob
+ * @return false if the command could not be handled
+ * @private
+ */
+static bool townk_hid_motion(uint8_t command_id, uint8_t value_id, uint8_t *value_data) {
+    mb_motion_param_t param  = townk_hid_motion_param(value_id);
+    pointer_device_t  device = (pointer_device_t)value_data[0];
+    if (param == MB_MOTION_PARAM_COUNT || device >= POINTER_DEVICE_COUNT) {
+        return false;
+    }
+
+    switch (command_id) {
+        case id_custom_set_value:
+            return mb_motion_set(device, param, ((uint16_t)value_data[1] << 8) | value_data[2]);
+        case id_custom_get_value: {
+            uint16_t value = mb_motion_get(device, param);
+            value_data[1]  = value >> 8;
+            value_data[2]  = value & 0xFF;
+            return true;
+        }
+        case id_custom_save:
+            return true; // nothing persists yet; acknowledge so the host does not retry
+        default:
+            return false;
+    }
+}
+
+#    ifdef TOWNK_TRACE_ENABLE
+/**
+ * @brief Report on, clear, or read out the flight recorder
+ *
+ * @p length bounds how many records a read packs into the reply.
+ * @return false if the command could not be handled
+ * @private
+ */
+static bool townk_hid_trace(uint8_t command_id, uint8_t value_id, uint8_t *value_data, uint8_t length) {
+    if (value_id == TOWNK_HID_TRACE_INFO) {
+        if (command_id == id_custom_set_value) {
+            townk_trace_clear();
+            return true;
+        }
+        if (command_id != id_custom_get_value) {
+            return false;
+        }
+
+        value_data[0] = townk_trace_head >> 8;
+        value_data[1] = townk_trace_head & 0xFF;
+        value_data[2] = TOWNK_TRACE_SIZE >> 8;
+        value_data[3] = TOWNK_TRACE_SIZE & 0xFF;
+        return true;
+    }
+
+    if (value_id != TOWNK_HID_TRACE_READ || command_id != id_custom_get_value) {
+        return false;
+    }
+
+    // Replies carry [seq hi, seq lo, count, count records of 8 bytes], and
+    // stop at the first record the ring no longer (or not yet) holds.
+    uint16_t seq   = ((uint16_t)value_data[0] << 8) | value_data[1];
+    uint8_t  room  = (length - 6) / TOWNK_HID_TRACE_RECORD_SIZE;
+    uint8_t  count = 0;
+    uint8_t *out   = &value_data[3];
+
+    townk_trace_entry_t entry;
+    while (count < room && townk_trace_read(seq + count, &entry)) {
+        out[0] = entry.time >> 24;
+        out[1] = (entry.time >> 16) & 0xFF;
+        out[2] = (entry.time >> 8) & 0xFF;
+        out[3] = entry.time & 0xFF;
+        out[4] = entry.type;
+        out[5] = entry.a;
+        out[6] = entry.b >> 8;
+        out[7] = entry.b & 0xFF;
+        out += TOWNK_HID_TRACE_RECORD_SIZE;
+        count++;
+    }
+
+    value_data[2] = count;
+    return true;
+}
+#    endif // TOWNK_TRACE_ENABLE
+
+#    ifdef TOWNK_LATENCY_ENABLE
+/**
+ * @brief Read one latency histogram, or clear them all
+ * @return false if the command could not be handled
+ * @private
+ */
+static bool townk_hid_latency(uint8_t command_id, uint8_t value_id, uint8_t *value_data) {
+    if (value_id != TOWNK_HID_LATENCY_HISTOGRAM) {
+        return false;
+    }
+
+    if (command_id == id_custom_set_value) {
+        latency_reset();
+        return true;
+    }
+
+    latency_class_t cls = (latency_class_t)value_data[0];
+    if (command_id != id_custom_get_value || cls >= LATENCY_CLASS_COUNT) {
+        return false;
+    }
+
+    for (uint8_t b = 0; b < LATENCY_BUCKETS; b++) {
+        uint16_t count        = latency_bucket(cls, b);
+        value_data[1 + 2 * b] = count >> 8;
+        value_data[2 + 2 * b] = count & 0xFF;
+    }
+    return true;
+}
+#    endif // TOWNK_LATENCY_ENABLE
+
+#    ifndef SMTD_STREAK_DISABLE
+/**
+ * @brief Read or clear the typing-streak counters
+ * @return false if the command could not be handled
+ * @private
+ */
+static bool townk_hid_smtd(uint8_t command_id, uint8_t value_id, uint8_t *value_data) {
+    if (value_id != TOWNK_HID_SMTD_STREAK) {
+        return false;
+    }
+
+    switch (command_id) {
+        case id_custom_set_value:
+            smtd_streak_reset_stats();
+            return true;
+        case id_custom_get_value: {
+            smtd_streak_stats_t stats = smtd_streak_stats();
+            for (uint8_t i = 0; i < 4; i++) {
+                value_data[i]     = stats.fast >> (24 - 8 * i);
+                value_data[4 + i] = stats.slow >> (24 - 8 * i);
+            }
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+#    endif // SMTD_STREAK_DISABLE
+
+/**
+ * @brief Read or clear the RGB layer segment write counters
+ * @return false if the command could not be handled
+ * @private
+ */
+static bool townk_hid_rgb(uint8_t command_id, uint8_t value_id, uint8_t *value_data) {
+    if (value_id != TOWNK_HID_RGB_LAYERS) {
+        return false;
+    }
+
+    switch (command_id) {
+        case id_custom_set_value:
+            rgb_layer_reset_stats();
+            return true;
+        case id_custom_get_value: {
+            rgb_layer_stats_t stats = rgb_layer_stats();
+            for (uint8_t i = 0; i < 4; i++) {
+                value_data[i]     = stats.written >> (24 - 8 * i);
+                value_data[4 + i] = stats.skipped >> (24 - 8 * i);
+            }
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+void via_custom_value_command_user(uint8_t *data, uint8_t length) {
+    uint8_t *command_id = &data[0];
+    uint8_t *channel_id = &data[1];
+    uint8_t *value_id   = &data[2];
+    uint8_t *value_data = &data[3];
+
+    if (length < 6 || *channel_id != TOWNK_HID_CHANNEL) {
+        *command_id = id_unhandled;
+        return;
+    }
+
+    // Value IDs come in groups of 16, one per feature.
+    bool handled = false;
+    switch (*value_id & 0xF0) {
+        case 0x00:
+            handled = townk_hid_motion(*command_id, *value_id, value_data);
+            break;
+#    ifdef TOWNK_TRACE_ENABLE
+        case 0x10:
+            handled = townk_hid_trace(*command_id, *value_id, value_data, length);
+            break;
+#    endif
+#    ifdef TOWNK_LATENCY_ENABLE
+        case 0x20:
+            handled = length >= 4 + 2 * LATENCY_BUCKETS && townk_hid_latency(*command_id, *value_id, value_data);
+            break;
+#    endif
+#    ifndef SMTD_STREAK_DISABLE
+        case 0x30:
+            handled = length >= 11 && townk_hid_smtd(*command_id, *value_id, value_data);
+            break;
+#    endif
+        case 0x40:
+            handled = length >= 11 && townk_hid_rgb(*command_id, *value_id, value_data);
+            break;
+        default:
+            break;
+    }
+
+    if (!handled) {
+        *command_id = id_unhandled;
+    }
+}
+
+#endif // VIA_ENABLE
@@ -0,0 +1,95 @@
+/* Copyright (C) 2025 Thiago Alves (https://github.com/townk)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file townk_hid.h
+ * @brief Runtime tuning over VIA's raw HID custom-value commands
+ *
+ * Vial's own QMK Settings tab only knows QMK's built-in settings, so this
+ * userspace's knobs are reached through the command VIA keeps for exactly
+ * this purpose: id_custom_get_value / id_custom_set_value / id_custom_save,
+ * on a channel of our own so the keyboard's channel is left alone. Every
+ * packet is 32 bytes:
+ *
+ * | byte | content                                              |
+ * |------|------------------------------------------------------|
+ * | 0    | id_custom_set_value (0x07) or id_custom_get_value (0x08) |
+ * | 1    | TOWNK_HID_CHANNEL                                    |
+ * | 2    | value ID, one of townk_hid_value_id_t                |
+ * | 3    | which ball: 0 left, 1 right (pointer_device_t)       |
+ * | 4-5  | the value, big-endian; a get fills these in          |
+ *
+ * The flight recorder (townk_trace.h, when TOWNK_TRACE_ENABLE is on) is read
+ * through two more value IDs, with no ball byte:
+ *
+ * - TOWNK_HID_TRACE_INFO: a get returns, from byte 3, the sequence number the
+ *   next record will take and the ring's capacity, each big-endian; a set
+ *   clears the ring.
+ * - TOWNK_HID_TRACE_READ: a get sends a starting sequence number in bytes 3-4
+ *   and gets back, in byte 5, how many records follow from byte 6 -- each
+ *   TOWNK_HID_TRACE_RECORD_SIZE bytes: time (4), type, a, b (2), big-endian.
+ *   Fewer than asked means the ring holds no more from there.
+ *
+ * The latency histograms (townk_latency.h, when TOWNK_LATENCY_ENABLE is on)
+ * use one value ID, TOWNK_HID_LATENCY_HISTOGRAM: a get sends a
+ * latency_class_t in byte 3 and gets back its LATENCY_BUCKETS counts from
+ * byte 4, each big-endian; a set clears every histogram.
+ *
+ * The typing-streak counters (townk_smtd.h, unless SMTD_STREAK_DISABLE is on)
+ * use TOWNK_HID_SMTD_STREAK: a get returns, from byte 3, how many layer-taps
+ * were sent as immediate taps and how many SM_TD resolved as usual, each a
+ * big-endian uint32; a set zeroes both.
+ *
+ * The RGB layer counters (townk_layers.h) use TOWNK_HID_RGB_LAYERS: a get
+ * returns, from byte 3, how many layer segments layer changes wrote and how
+ * many they left alone because the layer had not changed, each a big-endian
+ * uint32; a set zeroes both.
+ *
+ * Anything the firmware does not understand comes back with byte 0 set to
+ * id_unhandled (0xFF). tools/townk_hid.py speaks this from the host.
+ *
+ * @author Thiago Alves
+ */
+
+#ifndef QMK_USERSPACE_TOWNK_HID_H
+#define QMK_USERSPACE_TOWNK_HID_H
+
+/** The custom-value channel this userspace answers on: 'T'. VIA's own
+ * channels are 0-5, with 0 left to the keyboard. */
+#define TOWNK_HID_CHANNEL 0x54
+
+/**
+ * @brief Value IDs on TOWNK_HID_CHANNEL
+ *
+ * Append only: the host tool addresses values by number.
+ */
+typedef enum {
+    TOWNK_HID_MOTION_THRESHOLD    = 0x01, ///< MB_MOTION_THRESHOLD
+    TOWNK_HID_MOTION_RESET_MS     = 0x02, ///< MB_MOTION_RESET_MS
+    TOWNK_HID_MOTION_WINDOW_MS    = 0x03, ///< MB_MOTION_WINDOW_MS
+    TOWNK_HID_MOTION_MIN_VELOCITY = 0x04, ///< MB_MOTION_MIN_VELOCITY
+    TOWNK_HID_MOTION_COHERENCE    = 0x05, ///< MB_MOTION_COHERENCE
+    TOWNK_HID_TRACE_READ          = 0x10, ///< Flight recorder records, from a sequence number
+    TOWNK_HID_TRACE_INFO          = 0x11, ///< Flight recorder head and capacity; set clears
+    TOWNK_HID_LATENCY_HISTOGRAM   = 0x20, ///< One class's latency histogram; set clears all
+    TOWNK_HID_SMTD_STREAK         = 0x30, ///< Typing-streak fast-path counters; set clears
+    TOWNK_HID_RGB_LAYERS          = 0x40, ///< RGB layer segment write counters; set clears
+} townk_hid_value_id_t;
+
+/** Bytes per flight recorder record in a TOWNK_HID_TRACE_READ reply. */
+#define TOWNK_HID_TRACE_RECORD_SIZE 8
+
+#endif // QMK_USERSPACE_TOWNK_HID_H
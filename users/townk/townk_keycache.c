@@ -0,0 +1,135 @@
+/* Copyright (C) 2025 Thiago Alves (https://github.com/townk)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file townk_keycache.c
+ * @brief Transparency-resolved keycodes per matrix position -- see townk_keycache.h
+ *
+ * @author Thiago Alves
+ */
+
+#include "townk_keycache.h"
+
+#include <stdbool.h>
+
+#include "keycodes.h"
+#include "keymap_common.h"
+
+/* For each matrix position, the layer its keycode comes from. */
+static uint8_t keycache_source[MATRIX_ROWS][MATRIX_COLS];
+
+/* The active layers the sources were resolved against; nothing is cached
+ * until the first update. */
+static layer_state_t keycache_layers = 0;
+static bool          keycache_valid  = false;
+
+/** The highest set bit of a nonzero layer mask. */
+#define KEYCACHE_TOP(mask) ((uint8_t)(31 - __builtin_clz((uint32_t)(mask))))
+
+/**
+ * @brief QMK's layer walk for one position: the highest of @p layers that is
+ *        not transparent there, or layer 0 if none is
+ * @private
+ */
+static uint8_t keycache_resolve(layer_state_t layers, keypos_t key) {
+    for (uint32_t rest = layers; rest; rest &= ~((uint32_t)1 << KEYCACHE_TOP(rest))) {
+        uint8_t layer = KEYCACHE_TOP(rest);
+        if (keymap_key_to_keycode(layer, key) != KC_TRANSPARENT) {
+            return layer;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Re-resolve every position against @p layers
+ * @private
+ */
+static void keycache_rebuild(layer_state_t layers) {
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            keycache_source[row][col] = keycache_resolve(layers, (keypos_t){.row = row, .col = col});
+        }
+    }
+}
+
+/**
+ * @brief Apply one layer turning on or off, @p layers being the state after
+ *
+ * A position's source is the highest active layer that is not transparent
+ * there, so a layer only matters where it is, or would be, above the
+ * others: turning on, it takes over the positions resolved below it where it
+ * is not transparent, for one read each; turning off, it hands its own
+ * positions to the layers under it. Every other position keeps its source.
+ * @private
+ */
+static void keycache_apply(layer_state_t layers, uint8_t layer) {
+    bool     on    = (layers >> layer) & 1;
+    uint32_t below = (uint32_t)layers & (((uint32_t)1 << layer) - 1);
+
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            uint8_t *source = &keycache_source[row][col];
+            keypos_t key    = {.row = row, .col = col};
+            if (on && *source < layer) {
+                if (keymap_key_to_keycode(layer, key) != KC_TRANSPARENT) {
+                    *source = layer;
+                }
+            } else if (!on && *source == layer) {
+                *source = keycache_resolve(below, key);
+            }
+        }
+    }
+}
+
+void keycache_update(layer_state_t layers) {
+    if (!keycache_valid) {
+        keycache_rebuild(layers);
+    } else {
+        layer_state_t now = keycache_layers;
+        for (uint32_t changed = layers ^ keycache_layers; changed; changed &= changed - 1) {
+            uint8_t layer = __builtin_ctz(changed);
+            now ^= (layer_state_t)1 << layer;
+            keycache_apply(now, layer);
+        }
+    }
+
+    keycache_layers = layers;
+    keycache_valid  = true;
+}
+
+uint16_t keycache_keycode(keypos_t key) {
+    if (key.row >= MATRIX_ROWS || key.col >= MATRIX_COLS) {
+        return KC_NO;
+    }
+    keycache_update(layer_state | default_layer_state);
+
+    uint8_t *source  = &keycache_source[key.row][key.col];
+    uint16_t keycode = keymap_key_to_keycode(*source, key);
+    if (keycode == KC_TRANSPARENT && *source != 0) {
+        // Remapped to transparent since it was resolved.
+        *source = keycache_resolve(keycache_layers, key);
+        keycode = keymap_key_to_keycode(*source, key);
+    }
+    return keycode;
+}
+
+uint16_t keycache_layer_keycode(uint8_t layer, keypos_t key) {
+    if (layer == get_highest_layer(layer_state) && key.row < MATRIX_ROWS && key.col < MATRIX_COLS) {
+        return keycache_keycode(key);
+    }
+    return keymap_key_to_keycode(layer, key);
+}
@@ -0,0 +1,86 @@
+/* Copyright (C) 2025 Thiago Alves (https://github.com/townk)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file townk_keycache.h
+ * @brief Transparency-resolved keycodes per matrix position
+ *
+ * QMK finds a key's keycode by walking the active layers from the top down
+ * until one is not KC_TRANSPARENT: up to one keymap read per layer, and under
+ * VIA each read goes to the dynamic keymap. sm_td cuts that walk short -- it
+ * reads the highest active layer only -- so a _______ on a layer that can be
+ * on top (_MBO, with mouse mode on) hands it KC_TRANSPARENT instead of the
+ * key's real keycode.
+ *
+ * This keeps, for every matrix position, the layer its keycode currently
+ * comes from. layer_state_set_user() and default_layer_state_set_user()
+ * update it as the layers change, one changed layer at a time: a layer
+ * turning on reads only the positions resolved below it, and a layer turning
+ * off re-walks only the positions it was the source of.
+ * A lookup is then one keymap read, at the cached layer, so a key remapped
+ * there from VIA or Vial reads its new keycode at once. If the read finds
+ * KC_TRANSPARENT, that position is walked again.
+ *
+ * townk_sm_td.c builds sm_td with its keymap lookup sent here. The keycode
+ * process_record_user() is handed does not come from here: QMK resolved it
+ * before the call, with the same result for a press, and it keeps a release
+ * on the keycode of its press when the layers changed in between.
+ *
+ * @author Thiago Alves
+ */
+
+#ifndef QMK_USERSPACE_TOWNK_KEYCACHE_H
+#define QMK_USERSPACE_TOWNK_KEYCACHE_H
+
+#include <stdint.h>
+
+#include "action.h"
+
+/**
+ * @brief Bring the cache up to date with a new set of active layers
+ *
+ * Call from the layer hooks with what QMK resolves keys against: the layer
+ * state ORed with the default layer state. Lookups also call it, so a state
+ * the hooks never saw is caught before it is read.
+ *
+ * @param layers Every active layer, default layers included
+ */
+void keycache_update(layer_state_t layers);
+
+/**
+ * @brief The keycode a key position sends on the current layers
+ *
+ * What QMK's own layer walk would find, for one keymap read.
+ *
+ * @param key A matrix position
+ * @return The keycode, or KC_NO for a position outside the matrix
+ */
+uint16_t keycache_keycode(keypos_t key);
+
+/**
+ * @brief keymap_key_to_keycode(), resolving the highest layer through the cache
+ *
+ * A drop-in for code that asks for the keycode "on the current layer" by
+ * passing get_highest_layer(layer_state): that layer answers with the
+ * transparency-resolved keycode, and every other layer with the raw keymap
+ * entry, as before.
+ *
+ * @param layer The layer asked for
+ * @param key A matrix position
+ */
+uint16_t keycache_layer_keycode(uint8_t layer, keypos_t key);
+
+#endif // QMK_USERSPACE_TOWNK_KEYCACHE_H
@@ -0,0 +1,125 @@
+/* Copyright (C) 2025 Thiago Alves (https://github.com/townk)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file townk_latency.c
+ * @brief Press-to-report latency histograms -- see townk_latency.h
+ *
+ * @author Thiago Alves
+ */
+
+#include "townk_latency.h"
+
+#ifdef TOWNK_LATENCY_ENABLE
+
+#    include "timer.h"
+
+#    include "townk_keycodes.h"
+#    include "townk_mouse.h"
+#    include "townk_smtd.h"
+
+/** Presses that can be waiting for their output at once. */
+#    ifndef LATENCY_PENDING
+#        define LATENCY_PENDING 8
+#    endif
+
+/** A measured key that has been pressed and has not produced output yet. */
+typedef struct {
+    uint16_t keycode; ///< KC_NO when the slot is free
+    uint16_t time;    ///< record->event.time of the press
+} latency_pending_t;
+
+/** @private */
+static latency_pending_t latency_pending[LATENCY_PENDING] = {0};
+/** @private */
+static uint8_t latency_next = 0;
+/** @private */
+static uint16_t latency_histogram[LATENCY_CLASS_COUNT][LATENCY_BUCKETS] = {0};
+
+/**
+ * @brief Whether a keycode's output can be held back, so is worth measuring
+ * @private
+ */
+static bool latency_is_measured(uint16_t keycode) {
+    return (keycode >= CKC_BSPC && keycode <= CKC_BKTAB) || is_mb_key(keycode);
+}
+
+void latency_mark(uint16_t keycode, const keyrecord_t *record) {
+    // SM_TD's replay of a press comes later than the press itself; stamping
+    // it would hide the time SM_TD held the key back.
+    if (!record->event.pressed || !latency_is_measured(keycode) || smtd_replaying()) {
+        return;
+    }
+
+    // A repeat press of a key whose output never came replaces the old one;
+    // otherwise take the slots in turn, so the oldest press is overwritten.
+    uint8_t slot = LATENCY_PENDING;
+    for (uint8_t i = 0; i < LATENCY_PENDING; i++) {
+        if (latency_pending[i].keycode == keycode) {
+            slot = i;
+            break;
+        }
+    }
+    if (slot == LATENCY_PENDING) {
+        slot         = latency_next;
+        latency_next = (latency_next + 1) % LATENCY_PENDING;
+    }
+
+    latency_pending[slot] = (latency_pending_t){keycode, record->event.time};
+}
+
+void latency_observe(latency_class_t cls, uint16_t keycode) {
+    for (uint8_t i = 0; i < LATENCY_PENDING; i++) {
+        if (latency_pending[i].keycode != keycode || keycode == KC_NO) {
+            continue;
+        }
+
+        uint16_t elapsed = timer_elapsed(latency_pending[i].time);
+        uint8_t  bucket  = elapsed == 0 ? 0 : 32 - __builtin_clz(elapsed);
+        if (bucket >= LATENCY_BUCKETS) {
+            bucket = LATENCY_BUCKETS - 1;
+        }
+
+        uint16_t *count = &latency_histogram[cls][bucket];
+        if (*count < UINT16_MAX) {
+            (*count)++;
+        }
+
+        latency_pending[i].keycode = KC_NO;
+        return;
+    }
+}
+
+uint16_t latency_bucket(latency_class_t cls, uint8_t bucket) {
+    if (cls >= LATENCY_CLASS_COUNT || bucket >= LATENCY_BUCKETS) {
+        return 0;
+    }
+
+    return latency_histogram[cls][bucket];
+}
+
+void latency_reset(void) {
+    for (uint8_t i = 0; i < LATENCY_CLASS_COUNT; i++) {
+        for (uint8_t b = 0; b < LATENCY_BUCKETS; b++) {
+            latency_histogram[i][b] = 0;
+        }
+    }
+    for (uint8_t i = 0; i < LATENCY_PENDING; i++) {
+        latency_pending[i].keycode = KC_NO;
+    }
+}
+
+#endif // TOWNK_LATENCY_ENABLE
@@ -0,0 +1,93 @@
+/* Copyright (C) 2025 Thiago Alves (https://github.com/townk)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file townk_latency.h
+ * @brief Press-to-report latency histograms for the keys that hold output back
+ *
+ * The SM_TD layer-taps cannot send anything until they know whether they were
+ * tapped or held, and an MB_* click is only sent on release. How long that
+ * takes is what SMTD_GLOBAL_SEQUENCE_TERM and SMTD_GLOBAL_RELEASE_TERM trade
+ * against misfires, so with TOWNK_LATENCY_ENABLE defined it is measured on the
+ * board: from the matrix event (record->event.time, taken before SM_TD gets to
+ * delay the record) to the moment the output is handed to the host, binned
+ * into one log-scale histogram per class of output. townk_hid.c reads and
+ * clears them; `python3 tools/townk_hid.py latency` prints them.
+ *
+ * Without TOWNK_LATENCY_ENABLE both hooks compile to nothing.
+ *
+ * @author Thiago Alves
+ */
+
+#ifndef QMK_USERSPACE_TOWNK_LATENCY_H
+#define QMK_USERSPACE_TOWNK_LATENCY_H
+
+#include <stdint.h>
+
+#include "action.h"
+
+/**
+ * @brief What a measured key ended up sending
+ *
+ * Append only: tools/townk_hid.py reads classes by number.
+ */
+typedef enum {
+    LATENCY_SMTD_TAP,  ///< A layer-tap's tap key
+    LATENCY_SMTD_HOLD, ///< A layer-tap's layer switching on
+    LATENCY_MB_CLICK,  ///< An MB_* key's click, sent at release
+    LATENCY_MB_DRAG,   ///< An MB_* key's button, sent when motion made it a drag
+    LATENCY_CLASS_COUNT,
+} latency_class_t;
+
+/**
+ * Buckets per histogram. Bucket 0 counts 0 ms; bucket n counts
+ * 2^(n-1) .. 2^n - 1 ms; the last also counts everything longer.
+ */
+#define LATENCY_BUCKETS 12
+
+#ifdef TOWNK_LATENCY_ENABLE
+
+/**
+ * @brief Note when a measured key was pressed
+ *
+ * Call first thing in process_record_user(), before process_smtd(): SM_TD
+ * replays records later, and only the original carries the matrix time.
+ * Ignores releases, keys that are not measured and SM_TD's replays
+ * (smtd_replaying()), so a press keeps the time it was first seen.
+ */
+void latency_mark(uint16_t keycode, const keyrecord_t *record);
+
+/**
+ * @brief Bin the time since @p keycode was pressed under @p cls
+ *
+ * Call just before the output is sent. Each press is counted once, under
+ * whichever output it produced first; without a matching latency_mark() it
+ * counts nothing.
+ */
+void latency_observe(latency_class_t cls, uint16_t keycode);
+
+/** @brief One bucket of one class's histogram (0 if out of range) */
+uint16_t latency_bucket(latency_class_t cls, uint8_t bucket);
+
+/** @brief Empty every histogram */
+void latency_reset(void);
+
+#else
+#    define latency_mark(keycode, record) ((void)0)
+#    define latency_observe(cls, keycode) ((void)0)
+#endif // TOWNK_LATENCY_ENABLE
+
+#endif // QMK_USERSPACE_TOWNK_LATENCY_H
@@ -46,7 +46,14 @@
 
 #include "townk_layers.h"
 #include "rgblight.h"
+#include "townk_keycache.h"
 #include "color.h"
+#include "townk_trace.h"
+#include "caps_word.h"
+
+#ifdef DEFERRED_EXEC_ENABLE
+#    include "deferred_exec.h"
+#endif
 
 // HSV version of the layer colors
 #define BASE_GREEN          70, 220, 180
@@ -101,6 +108,84 @@ const rgblight_segment_t*  const rgb_layers[] = RGBLIGHT_LAYERS_LIST(
     layer12_colors, layer13_colors, layer14_colors, layer15_colors
 );
 
+/** Every segment rgblight_layers can hold. */
+#define RGB_LAYERS_MASK ((layer_state_t)(((uint64_t)1 << RGBLIGHT_LAYERS) - 1))
+
+/* What the segments currently show, bit n for segment n. rgblight starts with
+ * every segment off, and nothing but this file turns them on or off, so it
+ * only has to write the segments whose bit changed. SM_TD holds and
+ * auto-mouse flip layers many times a second, and each write marks the LEDs
+ * for a refresh. */
+static layer_state_t     rgb_shown = 0;
+static rgb_layer_stats_t rgb_stats = {0};
+
+/**
+ * @brief Turn each segment on or off to match @p lit, writing only changes
+ * @private
+ */
+static void rgb_show(layer_state_t lit) {
+    layer_state_t changed = (lit ^ rgb_shown) & RGB_LAYERS_MASK;
+    uint8_t       written = 0;
+
+    for (; changed; changed &= changed - 1) {
+        uint8_t i = __builtin_ctz(changed);
+        rgblight_set_layer_state(i, (lit >> i) & 1);
+        written++;
+    }
+
+    rgb_shown = lit & RGB_LAYERS_MASK;
+    rgb_stats.written += written;
+    rgb_stats.skipped += RGBLIGHT_LAYERS - written;
+}
+
+/* What the segments should show once the next frame is drawn. */
+static layer_state_t rgb_wanted = 0;
+
+#ifdef DEFERRED_EXEC_ENABLE
+/** Longest the indicators may lag the layer state, in ms: one frame at 60 Hz. */
+#    ifndef RGB_LAYER_FRAME_MS
+#        define RGB_LAYER_FRAME_MS 16
+#    endif
+
+/* A CKC_TAB tap-hold-release or an auto-mouse round trip changes layers
+ * several times within a few ms. Each change only records what it wants
+ * shown; one deferred task per frame shows the last of them, so key
+ * processing never waits on the LEDs. The task is scheduled by the first
+ * change after a frame and not pushed back by the ones that follow, which
+ * keeps the indicators at most RGB_LAYER_FRAME_MS behind. */
+static deferred_token rgb_frame = INVALID_DEFERRED_TOKEN;
+
+/**
+ * @brief Draw the frame: show what the last layer change wanted
+ * @private
+ */
+static uint32_t rgb_draw_frame(uint32_t trigger_time, void *cb_arg) {
+    rgb_frame = INVALID_DEFERRED_TOKEN;
+    rgb_show(rgb_wanted);
+    return 0;
+}
+#endif // DEFERRED_EXEC_ENABLE
+
+/**
+ * @brief Show @p lit on the segments by the next frame
+ * @private
+ */
+static void rgb_request(layer_state_t lit) {
+    rgb_wanted = lit;
+
+#ifdef DEFERRED_EXEC_ENABLE
+    if (rgb_frame == INVALID_DEFERRED_TOKEN) {
+        rgb_frame = defer_exec(RGB_LAYER_FRAME_MS, rgb_draw_frame, NULL);
+    }
+    if (rgb_frame != INVALID_DEFERRED_TOKEN) {
+        return;
+    }
+    // Every executor slot is taken: draw now rather than not at all.
+#endif
+
+    rgb_show(lit);
+}
+
 /**
  * @brief User callback for default layer state changes
  *
@@ -111,6 +196,9 @@ const rgblight_segment_t*  const rgb_layers[] = RGBLIGHT_LAYERS_LIST(
  * The function enables the layer 0 RGB lighting segment when layer 0 is the
  * default layer, and disables it otherwise.
  *
+ * It also re-resolves the keycode cache's positions the change can affect
+ * (townk_keycache.h).
+ *
  * @param state The new default layer state bitmask.
  * @return layer_state_t The same state value (required by QMK).
  *
@@ -118,23 +206,69 @@ const rgblight_segment_t*  const rgb_layers[] = RGBLIGHT_LAYERS_LIST(
  *       firmware when the default layer changes.
  */
 layer_state_t default_layer_state_set_user(layer_state_t state) {
-  rgblight_set_layer_state(0, layer_state_cmp(state, 0));
+  keycache_update(layer_state | state);
+  if (layer_state_cmp(state, 0)) {
+      rgb_request(rgb_wanted | 1);
+  } else {
+      rgb_request(rgb_wanted & ~(layer_state_t)1);
+  }
   return state;
 }
 
+/* The game layers borrow the auto_mouse flag; they do not own it. It is a
+ * persisted user preference (SV_TOGGLE_AUTOMOUSE writes it to EEPROM), so it
+ * is saved on the way into the game layers and restored -- not force-enabled
+ * -- on the way out, and ordinary layer changes leave it alone entirely. */
+static bool game_layers_active = false;
+static bool saved_auto_mouse   = false;
+
+/* Keys pressed while a game layer was active, one bit per matrix position.
+ * A release takes the path its press took, whatever the mode is by then:
+ * sm_td and the MB_* engine must see the release of every key they saw
+ * pressed, and must not see one whose press they never saw. */
+#define GAME_KEY_POSITIONS (MATRIX_ROWS * MATRIX_COLS)
+static uint8_t game_keys[(GAME_KEY_POSITIONS + 7) / 8];
+
+bool game_mode_fast_path(const keyrecord_t *record) {
+    uint16_t position = record->event.key.row * MATRIX_COLS + record->event.key.col;
+    if (position >= GAME_KEY_POSITIONS) {
+        return false; // combos and encoders have no matrix position
+    }
+
+    uint8_t *byte = &game_keys[position >> 3];
+    uint8_t  bit  = 1 << (position & 7);
+
+    if (record->event.pressed) {
+        if (!game_layers_active) {
+            return false;
+        }
+        *byte |= bit;
+        return true;
+    }
+
+    bool fast = *byte & bit;
+    *byte &= ~bit;
+    return fast;
+}
+
 /**
  * @brief User callback for layer state changes
  *
  * This QMK hook is called whenever any layer is activated or deactivated. It
  * updates the RGB lighting for all layers to reflect the current layer state.
  *
- * The function iterates through all available RGB lighting layers (0-15) and
- * enables/disables each layer's RGB segment based on whether that layer is
- * currently active in the layer state.
+ * The function enables/disables each layer's RGB segment based on whether
+ * that layer is currently active in the layer state, writing only the
+ * segments whose layer changed since the last frame drawn. With
+ * DEFERRED_EXEC_ENABLE the write waits for the end of the frame, at most
+ * RGB_LAYER_FRAME_MS, and a burst of layer changes draws only the last.
  *
  * When multiple layers are active simultaneously (e.g., momentary layer on top
  * of base layer), the RGB lighting will show the highest active layer's color.
  *
+ * It also re-resolves the keycode cache's positions the change can affect
+ * (townk_keycache.h), so sm_td reads transparency-resolved keycodes.
+ *
  * @param state The new layer state bitmask.
  * @return layer_state_t The same state value (required by QMK).
  *
@@ -143,29 +277,30 @@ layer_state_t default_layer_state_set_user(layer_state_t state) {
  *
  * @see RGBLIGHT_LAYERS constant for the maximum number of RGB layers.
  */
-/* The game layers borrow the auto_mouse flag; they do not own it. It is a
- * persisted user preference (SV_TOGGLE_AUTOMOUSE writes it to EEPROM), so it
- * is saved on the way into the game layers and restored -- not force-enabled
- * -- on the way out, and ordinary layer changes leave it alone entirely. */
-static bool game_layers_active = false;
-static bool saved_auto_mouse   = false;
-
 layer_state_t layer_state_set_user(layer_state_t state) {
-  for (int i = 0; i < RGBLIGHT_LAYERS; ++i) {
-      rgblight_set_layer_state(i, layer_state_cmp(state, i));
-  }
+  TOWNK_TRACE(TOWNK_TRACE_LAYER, get_highest_layer(state), state);
+  keycache_update(state | default_layer_state);
+
+  // layer_state_cmp() counts an empty state as layer 0 being on.
+  rgb_request(state ? state : 1);
 
   // Game layers want the pointer dead: no auto-mouse layer popping up
   // mid-game. Svalboard's mouse_mode() body is GATED on auto_mouse, so the
   // teardown must run BEFORE the flag is cleared or it is a guaranteed
   // no-op -- keymap_support.c orders the same pair this way, with the
   // warning "needs to go first to avoid the lockout".
+  //
+  // They want no typing aids either. Caps Word runs inside QMK, outside
+  // process_record_user(), so the fast path cannot skip it: switch it off
+  // here instead, and leave it off. Key overrides need nothing here: their
+  // layer masks leave the game layers out (townk_overrides.c).
   bool in_game = layer_state_cmp(state, _GAM1) || layer_state_cmp(state, _GAM2);
   if (in_game && !game_layers_active) {
       game_layers_active = true;
       saved_auto_mouse   = global_saved_values.auto_mouse;
       mouse_mode(false);
       global_saved_values.auto_mouse = false;
+      caps_word_off();
   } else if (!in_game && game_layers_active) {
       game_layers_active = false;
       global_saved_values.auto_mouse = saved_auto_mouse;
@@ -178,3 +313,11 @@ void setup_rgb_light_layer() {
     rgblight_layers = rgb_layers;
 }
 
+rgb_layer_stats_t rgb_layer_stats(void) {
+    return rgb_stats;
+}
+
+void rgb_layer_reset_stats(void) {
+    rgb_stats = (rgb_layer_stats_t){0};
+}
+
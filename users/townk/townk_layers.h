@@ -17,6 +17,10 @@
 #ifndef QMK_USERSPACE_TOWNK_LAYERS_H
 #define QMK_USERSPACE_TOWNK_LAYERS_H
 
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "action.h"
 #include "rgblight.h"
 
 #ifdef SVALBOARD
@@ -64,4 +68,34 @@ enum layer_names {
  */
 void setup_rgb_light_layer(void);
 
+/**
+ * @brief Whether a key event skips the typing pipeline for game mode
+ *
+ * While _GAM1 or _GAM2 is active, the keys want no tap-hold decisions, no
+ * dual-role mouse buttons and no typing streak -- only the keycode, at once.
+ * Call first thing in process_record_user() and, when this returns true,
+ * return process_socd()'s answer straight away, before process_smtd() and
+ * process_special_mouse_keys().
+ *
+ * The decision is made at the press and kept for its release, so a key held
+ * across a switch into or out of game mode is released by whoever saw it
+ * pressed.
+ *
+ * @param record The key event
+ * @return true if the event should go straight to QMK
+ */
+bool game_mode_fast_path(const keyrecord_t *record);
+
+/** How many layer segment writes layer changes made, and how many they skipped. */
+typedef struct {
+    uint32_t written; ///< Segments turned on or off because their layer changed
+    uint32_t skipped; ///< Segments left alone because their layer did not
+} rgb_layer_stats_t;
+
+/** @brief The segment write counters since the last reset */
+rgb_layer_stats_t rgb_layer_stats(void);
+
+/** @brief Zero the segment write counters */
+void rgb_layer_reset_stats(void);
+
 #endif // QMK_USERSPACE_TOWNK_LAYERS_H
@@ -21,54 +21,198 @@
  * @author Thiago Alves
  */
 
-#include "action.h" // register_mods / unregister_mods
+#include "action.h"      // register_mods / register_code and their unregister_*
+#include "action_util.h" // get_mods / get_*_mods / add_mods / del_mods / send_keyboard_report
 #include "townk_mods.h"
+#include "townk_trace.h"
 
-/** One claim counter per modifier bit. QMK modifier masks are 8 bits. */
-#define MOD_BIT_COUNT 8
+/**
+ * One 4-bit claim counter per modifier bit, packed into a word: bit n of a
+ * QMK modifier mask counts in nibble n. A whole mask is claimed or released
+ * with a few word operations (SWAR, SIMD within a register) instead of a
+ * loop over its bits, and the "first claim" and "last release" sets come out
+ * as masks, ready for a single register or unregister call.
+ */
+typedef uint32_t mods_claims_t;
+
+/** The low bit of every nibble. */
+#define MODS_NIBBLE_LSB 0x11111111u
 
 /** @private */
-static uint8_t claims[MOD_BIT_COUNT] = {0};
+static mods_claims_t claims = 0;
 
-void mods_acquire(uint8_t mods) {
-    for (uint8_t bit = 0; bit < MOD_BIT_COUNT; bit++) {
-        uint8_t mask = (uint8_t)(1 << bit);
-        if (!(mods & mask)) continue;
+/**
+ * @brief Each bit of @p mask as a 1 in its own nibble
+ * @private
+ */
+static inline mods_claims_t mods_spread(uint8_t mask) {
+    mods_claims_t x = mask;
 
-        // Register on the FIRST claim only; further claims just count.
-        if (claims[bit] == 0) {
-            register_mods(mask);
-        }
+    x = (x | (x << 12)) & 0x000F000Fu; // bits 4-7 up to the top half
+    x = (x | (x << 6)) & 0x03030303u;  // two bits per byte
+    x = (x | (x << 3)) & MODS_NIBBLE_LSB;
+    return x;
+}
 
-        // Saturate rather than wrap. An overflow here would mean thousands of
-        // unbalanced claims, and dropping one is far better than wrapping to
-        // zero and releasing a modifier somebody still holds.
-        if (claims[bit] < UINT8_MAX) {
-            claims[bit]++;
-        }
+/**
+ * @brief The inverse of mods_spread(): the low bit of each nibble, as a mask
+ * @private
+ */
+static inline uint8_t mods_gather(mods_claims_t x) {
+    x &= MODS_NIBBLE_LSB;
+    x = (x | (x >> 3)) & 0x03030303u;
+    x = (x | (x >> 6)) & 0x000F000Fu;
+    return (uint8_t)(x | (x >> 12));
+}
+
+/**
+ * @brief A 1 in the low bit of every nonzero counter
+ *
+ * The shifts carry bits across nibbles, but only into the bits above each
+ * low bit, which the final mask drops.
+ *
+ * @private
+ */
+static inline mods_claims_t mods_nonzero(mods_claims_t c) {
+    c |= c >> 1;
+    c |= c >> 2;
+    return c & MODS_NIBBLE_LSB;
+}
+
+/**
+ * @brief A 1 in the low bit of every counter at its ceiling of 15
+ * @private
+ */
+static inline mods_claims_t mods_saturated(mods_claims_t c) {
+    c &= c >> 1;
+    c &= c >> 2;
+    return c & MODS_NIBBLE_LSB;
+}
+
+/**
+ * The open transaction, if any: which modifiers the claims since
+ * mods_begin() have turned on and off, net of each other.
+ * @private
+ */
+typedef struct {
+    bool    open;
+    uint8_t on;
+    uint8_t off;
+} mods_pending_t;
+
+static mods_pending_t pending = {0};
+
+/**
+ * @brief The modifiers as the host will see them once any transaction commits
+ * @private
+ */
+static uint8_t mods_effective(void) {
+    return (get_mods() | pending.on) & ~pending.off;
+}
+
+/**
+ * @brief Register modifiers whose first claim just arrived
+ * @private
+ */
+static void mods_turn_on(uint8_t mask) {
+    if (!mask) return;
+
+    if (pending.open) {
+        // Off then on again in one transaction is no change at all.
+        pending.on |= mask & ~pending.off;
+        pending.off &= ~mask;
+    } else {
+        register_mods(mask);
+    }
+}
+
+/**
+ * @brief Unregister modifiers whose last claim just went away
+ * @private
+ */
+static void mods_turn_off(uint8_t mask) {
+    if (!mask) return;
+
+    if (pending.open) {
+        pending.off |= mask & ~pending.on;
+        pending.on &= ~mask;
+    } else {
+        unregister_mods(mask);
     }
 }
 
+void mods_acquire(uint8_t mods) {
+    mods_claims_t ones = mods_spread(mods);
+
+    // Register on the FIRST claim only; further claims just count.
+    uint8_t turned_on = mods & (uint8_t)~mods_gather(mods_nonzero(claims));
+
+    // Saturate rather than wrap. An overflow here would mean more unbalanced
+    // claims than there are keys, and dropping one is far better than
+    // wrapping to zero and releasing a modifier somebody still holds. With
+    // saturated counters left alone, no nibble carries into the next.
+    claims += ones & ~mods_saturated(claims);
+
+    // One report for every modifier this claim turned on, not one per bit.
+    mods_turn_on(turned_on);
+
+    TOWNK_TRACE(TOWNK_TRACE_MODS_ACQUIRE, mods, mods_effective());
+}
+
 void mods_release(uint8_t mods) {
-    for (uint8_t bit = 0; bit < MOD_BIT_COUNT; bit++) {
-        uint8_t mask = (uint8_t)(1 << bit);
-        if (!(mods & mask)) continue;
+    // Releasing something never claimed is a caller bug, but silently
+    // ignoring it beats unregistering a modifier held by someone else. Only
+    // nonzero counters are decremented, so no nibble borrows from the next.
+    mods_claims_t ones = mods_spread(mods) & mods_nonzero(claims);
 
-        // Releasing something never claimed is a caller bug, but silently
-        // ignoring it beats unregistering a modifier held by someone else.
-        if (claims[bit] == 0) continue;
+    claims -= ones;
 
-        claims[bit]--;
-        if (claims[bit] == 0) {
-            unregister_mods(mask);
-        }
+    uint8_t turned_off = mods_gather(ones & ~mods_nonzero(claims));
+    mods_turn_off(turned_off);
+
+    TOWNK_TRACE(TOWNK_TRACE_MODS_RELEASE, mods, mods_effective());
+}
+
+void mods_begin(void) {
+    pending = (mods_pending_t){.open = true};
+}
+
+void mods_commit(void) {
+    uint8_t on  = pending.on;
+    uint8_t off = pending.off;
+
+    pending = (mods_pending_t){0};
+    if (on | off) {
+        add_mods(on);
+        del_mods(off);
+        send_keyboard_report();
     }
 }
 
+void mods_commit_press(uint16_t button) {
+    mods_commit();
+    register_code(button);
+}
+
+void mods_commit_release(uint16_t button) {
+    unregister_code(button);
+    mods_commit();
+}
+
+uint8_t mods_owned(void) {
+    return mods_gather(mods_nonzero(claims));
+}
+
+uint8_t mods_foreign(void) {
+    // What the host sees -- including a transaction not yet committed, whose
+    // releases must not read as somebody else's modifiers -- minus ours.
+    return (mods_effective() | get_oneshot_mods() | get_weak_mods()) & (uint8_t)~mods_owned();
+}
+
 uint8_t mods_claim_count(uint8_t mod_bit) {
-    for (uint8_t bit = 0; bit < MOD_BIT_COUNT; bit++) {
-        if (mod_bit & (uint8_t)(1 << bit)) {
-            return claims[bit];
+    for (uint8_t nibble = 0; nibble < 8; nibble++) {
+        if (mod_bit & (uint8_t)(1 << nibble)) {
+            return (uint8_t)((claims >> (nibble * 4)) & 0xF);
         }
     }
 
@@ -76,10 +220,11 @@ uint8_t mods_claim_count(uint8_t mod_bit) {
 }
 
 void mods_reset(void) {
-    for (uint8_t bit = 0; bit < MOD_BIT_COUNT; bit++) {
-        if (claims[bit] > 0) {
-            unregister_mods((uint8_t)(1 << bit));
-        }
-        claims[bit] = 0;
+    uint8_t held = mods_owned();
+
+    pending = (mods_pending_t){0};
+    claims  = 0;
+    if (held) {
+        unregister_mods(held);
     }
 }
@@ -34,6 +34,13 @@
  * modifiers to clicks, and it fails silently rather than loudly: the modifier
  * simply stops being held mid-gesture.
  *
+ * Claims made between mods_begin() and one of the mods_commit*() calls are
+ * counted at once but reach the host together, in a single keyboard report,
+ * and the commit can carry the mouse button they qualify: modifiers before
+ * the button goes down, the button before they come up. Without that, a
+ * click and its modifiers are separate reports the host may see in either
+ * order, and a drag resolving several keys sends a report per key.
+ *
  * @author Thiago Alves
  */
 
@@ -44,6 +51,10 @@
 
 /**
  * @brief Claim one or more modifiers, registering any not already held
+ *
+ * Each modifier counts up to 15 claims; more are dropped rather than wrapping
+ * the count back to zero.
+ *
  * @param mods MOD_BIT mask of the modifiers to claim
  */
 void mods_acquire(uint8_t mods);
@@ -54,6 +65,55 @@ void mods_acquire(uint8_t mods);
  */
 void mods_release(uint8_t mods);
 
+/**
+ * @brief Hold back the keyboard report for the claims that follow
+ *
+ * Until the matching commit, mods_acquire() and mods_release() count claims
+ * as usual but only note which modifiers turn on or off; get_mods() does not
+ * see them yet. Transactions do not nest.
+ */
+void mods_begin(void);
+
+/**
+ * @brief Send the modifiers changed since mods_begin(), in one report
+ *
+ * Sends nothing if the claims made in between cancelled out.
+ */
+void mods_commit(void);
+
+/**
+ * @brief mods_commit(), then press a mouse button carrying those modifiers
+ * @param button The button keycode to register
+ */
+void mods_commit_press(uint16_t button);
+
+/**
+ * @brief Release a mouse button, then mods_commit()
+ *
+ * The release still carries the modifiers released in the transaction --
+ * which is what makes Finder treat a drop as a copy.
+ *
+ * @param button The button keycode to unregister
+ */
+void mods_commit_release(uint16_t button);
+
+/**
+ * @brief Every modifier at least one claim is holding
+ * @return MOD_BIT mask; bits turned on in an open transaction count already
+ */
+uint8_t mods_owned(void);
+
+/**
+ * @brief Modifiers held by someone else: the user, a one-shot or a weak mod
+ *
+ * Everything active -- normal, one-shot and weak -- minus mods_owned(). A
+ * single AND-NOT, so callers on the key press path need not work out which
+ * of the active modifiers are their own.
+ *
+ * @return MOD_BIT mask of the active modifiers nobody has claimed
+ */
+uint8_t mods_foreign(void);
+
 /**
  * @brief Number of outstanding claims on a single modifier
  *
@@ -91,22 +91,41 @@
 
 #include "timer.h"
 
+#include "townk_eeconfig.h"
 #include "townk_keycodes.h"
+#include "townk_latency.h"
 #include "townk_layers.h"
 #include "townk_mods.h"
 #include "townk_mouse.h"
+#include "townk_pointing.h"
+#include "townk_trace.h"
 
 /* A hand merely RESTING on the trackball produces occasional one-count
  * reports, and a single report is indistinguishable from the start of a
  * deliberate drag -- so "the pointer moved" must be earned, not assumed.
- * Deliberate motion is a dense stream of reports whose distance adds up
- * within a few tens of milliseconds; resting jitter is sparse blips with
- * long silences in between. Accumulate |x|+|y| across reports, forget the
- * total when the stream goes quiet, and call the pointer moving only once
- * the total crosses the threshold. Both knobs are overridable per build.
- *
- * The cost is that a real drag travels MB_MOVE_THRESHOLD counts before the
- * button goes down -- at trackball resolution, an imperceptible slip. */
+ *
+ * Distance alone is not enough to earn it. Resting jitter that is dense
+ * enough, or that goes on long enough, adds up to any threshold; what it
+ * never does is GO somewhere. So the last MB_MOVE_WINDOW_MS of motion is
+ * kept, and the pointer is called moving only when, over that window, all
+ * three hold:
+ *
+ * - distance: |x|+|y| adds up to MB_MOVE_THRESHOLD counts;
+ * - velocity: that distance was covered at MB_MOVE_MIN_VELOCITY counts per
+ *   second or faster -- a slow creep is a hand settling, not a drag;
+ * - coherence: the motion kept a direction. The net travel (|sum x| +
+ *   |sum y|) must be at least MB_MOVE_COHERENCE/256 of the path length; a
+ *   wobble back and forth has a long path and almost no net travel.
+ *
+ * A quiet gap of MB_MOVE_RESET_MS still forgets everything at once.
+ *
+ * A real drag travels MB_MOVE_THRESHOLD counts before the button can go
+ * down. So that the drag still starts where the user began it, that travel is
+ * withheld from the host while a key is undecided and replayed right after
+ * the button-down -- see pointer_track().
+ *
+ * Every knob here is a build-time default; the values in use live in RAM and
+ * can be changed at runtime (see mb_motion_set() and townk_hid.c). */
 #ifndef MB_MOVE_THRESHOLD
 #    define MB_MOVE_THRESHOLD 8
 #endif
@@ -116,35 +135,484 @@
 #    define MB_MOVE_RESET_MS 50
 #endif
 
-static uint32_t mb_motion_accum     = 0;
-static uint32_t mb_motion_last_time = 0;
+/** How much recent motion the classifier looks at. */
+#ifndef MB_MOVE_WINDOW_MS
+#    define MB_MOVE_WINDOW_MS 96
+#endif
+
+/** Slowest average speed over the window that still counts, in counts/s. */
+#ifndef MB_MOVE_MIN_VELOCITY
+#    define MB_MOVE_MIN_VELOCITY 150
+#endif
+
+/** Net travel over path length, in 1/256ths, below which motion is a wobble. */
+#ifndef MB_MOVE_COHERENCE
+#    define MB_MOVE_COHERENCE 160
+#endif
+
+/* The Svalboard has a ball under each hand, and they are not the same kind of
+ * input: with left_scroll on, the left one is a scroll wheel whose jitter and
+ * travel have nothing to do with where the pointer is. Sharing one
+ * accumulator let the two add up -- a scroll-ball wiggle plus a few counts on
+ * the pointer ball read as a drag. Each ball therefore keeps its own motion
+ * state and its own knobs, defaulting to the shared ones above. */
+#ifndef MB_MOVE_THRESHOLD_LEFT
+#    define MB_MOVE_THRESHOLD_LEFT MB_MOVE_THRESHOLD
+#endif
+#ifndef MB_MOVE_THRESHOLD_RIGHT
+#    define MB_MOVE_THRESHOLD_RIGHT MB_MOVE_THRESHOLD
+#endif
+#ifndef MB_MOVE_RESET_MS_LEFT
+#    define MB_MOVE_RESET_MS_LEFT MB_MOVE_RESET_MS
+#endif
+#ifndef MB_MOVE_RESET_MS_RIGHT
+#    define MB_MOVE_RESET_MS_RIGHT MB_MOVE_RESET_MS
+#endif
+
+/** The motion window is a ring of this many time slots of window/N ms each;
+ * a power of two. Reports falling in the same slot are summed, so the cost
+ * per report is fixed however fast the sensor reports. */
+#define MB_MOTION_SLOTS 8
+
+/** Per-device tuning of the motion classifier. */
+typedef struct {
+    uint16_t threshold;    ///< Path length over the window that counts as deliberate motion
+    uint16_t reset_ms;     ///< Quiet gap after which the window is forgotten
+    uint16_t window_ms;    ///< How much recent motion is judged
+    uint16_t min_velocity; ///< Slowest average speed that counts, in counts/s
+    uint16_t coherence;    ///< Minimum net travel / path length, in 1/256ths
+} mb_motion_config_t;
+
+/** Per-device build-time tuning: what mb_motion_config starts from. */
+static const mb_motion_config_t mb_motion_defaults[POINTER_DEVICE_COUNT] = {
+    [POINTER_LEFT] =
+        {
+            .threshold    = MB_MOVE_THRESHOLD_LEFT,
+            .reset_ms     = MB_MOVE_RESET_MS_LEFT,
+            .window_ms    = MB_MOVE_WINDOW_MS,
+            .min_velocity = MB_MOVE_MIN_VELOCITY,
+            .coherence    = MB_MOVE_COHERENCE,
+        },
+    [POINTER_RIGHT] =
+        {
+            .threshold    = MB_MOVE_THRESHOLD_RIGHT,
+            .reset_ms     = MB_MOVE_RESET_MS_RIGHT,
+            .window_ms    = MB_MOVE_WINDOW_MS,
+            .min_velocity = MB_MOVE_MIN_VELOCITY,
+            .coherence    = MB_MOVE_COHERENCE,
+        },
+};
+
+/** Per-device tuning in use; starts at the defaults, changeable at runtime.
+ * C cannot initialise one array from another, hence the repetition. */
+static mb_motion_config_t mb_motion_config[POINTER_DEVICE_COUNT] = {
+    [POINTER_LEFT]  = {MB_MOVE_THRESHOLD_LEFT, MB_MOVE_RESET_MS_LEFT, MB_MOVE_WINDOW_MS, MB_MOVE_MIN_VELOCITY, MB_MOVE_COHERENCE},
+    [POINTER_RIGHT] = {MB_MOVE_THRESHOLD_RIGHT, MB_MOVE_RESET_MS_RIGHT, MB_MOVE_WINDOW_MS, MB_MOVE_MIN_VELOCITY, MB_MOVE_COHERENCE},
+};
+
+/** The motion that fell into one time slot of the window. */
+typedef struct {
+    int32_t  x;    ///< Summed signed x
+    int32_t  y;    ///< Summed signed y
+    uint32_t path; ///< Summed |x|+|y|
+    uint32_t slot; ///< Which slot number (time / slot width) this holds
+} mb_motion_slot_t;
+
+/** Per-device motion history. */
+typedef struct {
+    mb_motion_slot_t ring[MB_MOTION_SLOTS]; ///< The window, indexed by slot number mod MB_MOTION_SLOTS
+    uint32_t         last_time;             ///< Timestamp of the last nonzero report
+    int32_t          withheld_x;            ///< Motion held back from the host while a key is undecided
+    int32_t          withheld_y;
+    uint32_t         withheld_path;         ///< Summed |x|+|y| of that motion
+    bool             withhold_spent;        ///< This stream already withheld a threshold's worth
+} mb_motion_t;
+
+/* One per physical ball. A build with a single pointing device (or one whose
+ * reports arrive already merged) attributes everything to POINTER_RIGHT, the
+ * ball that moves the pointer in this keymap. */
+static mb_motion_t mb_motion[POINTER_DEVICE_COUNT] = {0};
+
+/**
+ * @brief Whether a device's motion stream has gone quiet
+ *
+ * True once MB_MOVE_RESET_MS (per device) has passed since its last motion
+ * report: whatever it accumulated before that was not a drag.
+ * @private
+ */
+static bool pointer_motion_is_stale(pointer_device_t device) {
+    return timer_elapsed32(mb_motion[device].last_time) > mb_motion_config[device].reset_ms;
+}
+
+/* Online calibration of the pointer ball's drag threshold.
+ *
+ * MB_MOVE_THRESHOLD has to sit above whatever a resting hand produces, and
+ * that depends on the hand, on how it rests, and on the DPI: the same tremor
+ * is three times the counts at 1200 DPI that it is at 400. A fixed value is
+ * either too high for a still hand (every drag starts late) or too low for a
+ * restless one (a resting hand clicks). So the threshold is learned.
+ *
+ * Every burst of pointer-ball motion -- reports up to a MB_MOVE_RESET_MS gap
+ * -- has a peak: the most path the motion window held at any point in it.
+ * A burst is taken as idle jitter only if its peak stays below
+ * MB_CALIB_BUCKETS counts, no MB_* key is held during it, no mouse button is
+ * pressed before it goes quiet (so it does not end in a click or a drag), and
+ * it is sparse: on average at most one report per MB_CALIB_REPORT_GAP_MS, or
+ * slower overall than MB_MOVE_MIN_VELOCITY. A small deliberate nudge streams
+ * reports; a resting hand leaks the odd count. Anything else tells us nothing
+ * about resting. Their peaks go
+ * into a histogram per DPI index, and the learned threshold is one count more
+ * than the smallest peak that at most 1 in 2^MB_CALIB_TAIL_SHIFT jitter bursts
+ * reaches -- the lowest threshold (so the quickest drag start) a resting hand
+ * still essentially never crosses, on top of which the velocity and coherence
+ * gates still have to agree before anything converts.
+ *
+ * A learned value replaces the pointer ball's threshold for that DPI once
+ * MB_CALIB_MIN_SAMPLES bursts back it, and is saved through townk_eeconfig so
+ * the next power-up starts from it. The histogram halves itself as it fills,
+ * so an old habit fades. Setting the threshold by hand (mb_motion_set())
+ * turns calibration off until the next power-up; MB_CALIBRATION_DISABLE
+ * compiles it out. */
+#ifndef MB_CALIBRATION_DISABLE
+
+/** Peaks of this many counts or more are deliberate motion, not jitter. */
+#    define MB_CALIB_BUCKETS 24
+
+/** Jitter bursts needed before a learned threshold is trusted. */
+#    ifndef MB_CALIB_MIN_SAMPLES
+#        define MB_CALIB_MIN_SAMPLES 32
+#    endif
+
+/** The learned threshold leaves 1 in 2^this jitter bursts above it. */
+#    ifndef MB_CALIB_TAIL_SHIFT
+#        define MB_CALIB_TAIL_SHIFT 6
+#    endif
+
+/** Bounds on the learned threshold. */
+#    ifndef MB_CALIB_MIN_THRESHOLD
+#        define MB_CALIB_MIN_THRESHOLD 3
+#    endif
+#    ifndef MB_CALIB_MAX_THRESHOLD
+#        define MB_CALIB_MAX_THRESHOLD 16
+#    endif
+
+/** A burst averaging more than one report per this many ms is a stream of
+ * motion, not jitter, unless it is also slower than MB_MOVE_MIN_VELOCITY. */
+#    ifndef MB_CALIB_REPORT_GAP_MS
+#        define MB_CALIB_REPORT_GAP_MS 16
+#    endif
+
+/** A DPI index's histogram halves when it holds this many bursts. */
+#    define MB_CALIB_DECAY_AT 1024
+
+#    define MB_CALIB_DPI_COUNT (MOUSE_DPI_2400 + 1)
+#    define MB_CALIB_DPI_NONE 0xFF
+
+typedef struct {
+    uint16_t hist[MB_CALIB_DPI_COUNT][MB_CALIB_BUCKETS]; ///< Burst peaks, per DPI index
+    uint16_t total[MB_CALIB_DPI_COUNT];                  ///< Bursts in each histogram
+    uint32_t burst_start;                                ///< Time of the burst's first report
+    uint32_t burst_last;                                 ///< Time of its latest report
+    uint32_t burst_path;                                 ///< Summed |x|+|y| of its reports
+    uint16_t burst_reports;                              ///< Motion reports in it
+    uint16_t burst_peak;                                 ///< Peak window path of the burst in progress
+    bool     burst_tainted;                              ///< An MB_* key was held, or a button pressed, during it
+    bool     enabled;                                    ///< Cleared by a manual threshold
+    uint8_t  applied_dpi;                                ///< DPI index the threshold in use belongs to
+} mb_calibration_t;
+
+static mb_calibration_t mb_calibration = {.enabled = true, .applied_dpi = MB_CALIB_DPI_NONE};
+
+static bool mb_key_held(void);
+
+/**
+ * @brief The threshold a DPI index's histogram supports, or 0 for "not yet"
+ * @private
+ */
+static uint8_t mb_calibration_estimate(uint8_t dpi) {
+    uint16_t total = mb_calibration.total[dpi];
+    if (total < MB_CALIB_MIN_SAMPLES) {
+        return 0;
+    }
+
+    // Walk down from the longest peaks until the tail would be too heavy.
+    uint32_t tail = 0;
+    uint8_t  peak = MB_CALIB_BUCKETS;
+    while (peak > 0) {
+        tail += mb_calibration.hist[dpi][peak - 1];
+        if ((tail << MB_CALIB_TAIL_SHIFT) > total) {
+            break;
+        }
+        peak--;
+    }
+
+    uint8_t threshold = peak + 1; // one count above what jitter reaches
+    if (threshold < MB_CALIB_MIN_THRESHOLD) threshold = MB_CALIB_MIN_THRESHOLD;
+    if (threshold > MB_CALIB_MAX_THRESHOLD) threshold = MB_CALIB_MAX_THRESHOLD;
+    return threshold;
+}
+
+/**
+ * @brief Point the pointer ball's threshold at what its DPI has learned
+ * @private
+ */
+static void mb_calibration_apply(uint8_t dpi) {
+    uint8_t learned = townk_eeconfig_drag_threshold(dpi);
+
+    mb_motion_config[POINTER_RIGHT].threshold = learned ? learned : mb_motion_defaults[POINTER_RIGHT].threshold;
+    mb_calibration.applied_dpi                = dpi;
+}
+
+/**
+ * @brief Whether the closing burst was sparse in time
+ *
+ * Few reports for its span, or little path for its span. A single report is
+ * sparse.
+ * @private
+ */
+static bool mb_calibration_burst_sparse(void) {
+    uint32_t span_ms = mb_calibration.burst_last - mb_calibration.burst_start;
+
+    if ((uint32_t)(mb_calibration.burst_reports - 1) * MB_CALIB_REPORT_GAP_MS <= span_ms) {
+        return true;
+    }
+    return mb_calibration.burst_path * 1000 < (uint32_t)mb_motion_config[POINTER_RIGHT].min_velocity * span_ms;
+}
+
+/**
+ * @brief Close the burst that just went quiet, learning from it if it was
+ *        idle jitter
+ * @private
+ */
+static void mb_calibration_end_burst(void) {
+    uint16_t peak    = mb_calibration.burst_peak;
+    bool     tainted = mb_calibration.burst_tainted;
+    bool     sparse  = peak != 0 && mb_calibration_burst_sparse();
+
+    mb_calibration.burst_peak    = 0;
+    mb_calibration.burst_tainted = false;
+    mb_calibration.burst_reports = 0;
+    mb_calibration.burst_path    = 0;
+
+    if (peak == 0 || tainted || !sparse || peak >= MB_CALIB_BUCKETS || !mb_calibration.enabled) {
+        return;
+    }
+
+    uint8_t dpi = mb_calibration.applied_dpi;
+    if (dpi >= MB_CALIB_DPI_COUNT) {
+        return;
+    }
+
+    if (++mb_calibration.total[dpi] >= MB_CALIB_DECAY_AT) {
+        mb_calibration.total[dpi] = 0;
+        for (uint8_t i = 0; i < MB_CALIB_BUCKETS; i++) {
+            mb_calibration.hist[dpi][i] /= 2;
+            mb_calibration.total[dpi] += mb_calibration.hist[dpi][i];
+        }
+    }
+    mb_calibration.hist[dpi][peak - 1]++;
+
+    uint8_t threshold = mb_calibration_estimate(dpi);
+    if (threshold != 0) {
+        townk_eeconfig_set_drag_threshold(dpi, threshold);
+        mb_calibration_apply(dpi);
+    }
+}
+
+/**
+ * @brief Calibration's share of a pointer-ball motion report
+ *
+ * Called before the report is classified (@p stale: it opens a new burst)
+ * and after, with the report's own path (@p moved) and the window's
+ * (@p path nonzero). O(1) except when a burst closes, which is at most once
+ * per MB_MOVE_RESET_MS.
+ * @private
+ */
+static void mb_calibration_observe(bool stale, uint32_t moved, uint32_t path) {
+    if (!mb_calibration.enabled) {
+        return;
+    }
+
+    if (path == 0) {
+        uint8_t dpi = global_saved_values.right_dpi_index;
+        if (stale) {
+            mb_calibration_end_burst();
+        }
+        if (dpi != mb_calibration.applied_dpi && dpi < MB_CALIB_DPI_COUNT) {
+            mb_calibration_apply(dpi);
+        }
+        return;
+    }
+
+    uint32_t now = timer_read32();
+    if (mb_calibration.burst_reports == 0) {
+        mb_calibration.burst_start = now;
+    }
+    mb_calibration.burst_last = now;
+    if (mb_calibration.burst_reports < UINT16_MAX) {
+        mb_calibration.burst_reports++;
+    }
+    mb_calibration.burst_path += moved;
+
+    if (path > mb_calibration.burst_peak) {
+        mb_calibration.burst_peak = path > UINT16_MAX ? UINT16_MAX : path;
+    }
+    mb_calibration.burst_tainted |= mb_key_held();
+}
+
+/**
+ * @brief A mouse button went down: the burst in progress ends in a click or
+ *        a drag, not at rest
+ * @private
+ */
+static void mb_calibration_observe_button(void) {
+    if (!pointer_motion_is_stale(POINTER_RIGHT)) {
+        mb_calibration.burst_tainted = true;
+    }
+}
+#endif // MB_CALIBRATION_DISABLE
 
 /**
  * @brief Decides whether this report is part of deliberate pointer motion.
  *
- * Feeds one report's x/y into the motion accumulator and answers whether
- * enough distance has built up, densely enough in time, to treat the pointer
- * as moving. Zero-motion reports leave the accumulator alone; the idle reset
- * happens lazily on the next motion report instead.
+ * Adds one report's x/y to the motion window of the device that produced it
+ * and answers whether the window now holds deliberate motion: enough
+ * distance, covered fast enough, in a consistent enough direction. Zero-motion
+ * reports leave the window alone; expired slots are skipped lazily on the
+ * next motion report instead. Fixed cost: one device's MB_MOTION_SLOTS slots.
  */
-static bool pointer_is_moving(mouse_xy_report_t x, mouse_xy_report_t y) {
+static bool pointer_is_moving(pointer_device_t device, mouse_xy_report_t x, mouse_xy_report_t y) {
     if (x == 0 && y == 0) {
         return false;
     }
 
-    if (timer_elapsed32(mb_motion_last_time) > MB_MOVE_RESET_MS) {
-        mb_motion_accum = 0;
+    const mb_motion_config_t *config = &mb_motion_config[device];
+    mb_motion_t              *motion = &mb_motion[device];
+
+    uint32_t now   = timer_read32();
+    bool     stale = pointer_motion_is_stale(device);
+    if (stale) {
+        for (uint8_t i = 0; i < MB_MOTION_SLOTS; i++) {
+            motion->ring[i].path = 0; // an empty slot counts for nothing
+        }
+    }
+    motion->last_time = now;
+
+#ifndef MB_CALIBRATION_DISABLE
+    if (device == POINTER_RIGHT) {
+        mb_calibration_observe(stale, 0, 0);
+    }
+#endif // MB_CALIBRATION_DISABLE
+
+    uint32_t slot_ms = config->window_ms / MB_MOTION_SLOTS;
+    if (slot_ms == 0) {
+        slot_ms = 1;
+    }
+    uint32_t current = now / slot_ms;
+
+    mb_motion_slot_t *slot = &motion->ring[current % MB_MOTION_SLOTS];
+    if (slot->slot != current || slot->path == 0) {
+        *slot = (mb_motion_slot_t){.slot = current};
     }
-    mb_motion_last_time = timer_read32();
 
     /* mouse_xy_report_t is int16_t on this board (MOUSE_EXTENDED_REPORT);
      * int promotion makes -x safe even for x == INT16_MIN */
-    uint32_t distance = (uint32_t)(x < 0 ? -x : x) + (uint32_t)(y < 0 ? -y : y);
-    if (mb_motion_accum < MB_MOVE_THRESHOLD) { /* saturate; a drag can outlast the accumulator */
-        mb_motion_accum += distance;
+    uint32_t moved = (uint32_t)(x < 0 ? -x : x) + (uint32_t)(y < 0 ? -y : y);
+    slot->x += x;
+    slot->y += y;
+    slot->path += moved;
+
+    int32_t  sum_x  = 0;
+    int32_t  sum_y  = 0;
+    uint32_t path   = 0;
+    uint32_t oldest = current;
+    for (uint8_t i = 0; i < MB_MOTION_SLOTS; i++) {
+        const mb_motion_slot_t *s = &motion->ring[i];
+        if (s->path == 0 || current - s->slot >= MB_MOTION_SLOTS) {
+            continue; // empty, or fell out of the window
+        }
+        sum_x += s->x;
+        sum_y += s->y;
+        path += s->path;
+        if (current - s->slot > current - oldest) {
+            oldest = s->slot;
+        }
+    }
+
+#ifndef MB_CALIBRATION_DISABLE
+    if (device == POINTER_RIGHT) {
+        mb_calibration_observe(false, moved, path);
+    }
+#endif // MB_CALIBRATION_DISABLE
+
+    if (path < config->threshold) {
+        return false;
+    }
+
+    uint32_t net = (uint32_t)(sum_x < 0 ? -sum_x : sum_x) + (uint32_t)(sum_y < 0 ? -sum_y : sum_y);
+    if (net * 256 < (uint32_t)config->coherence * path) {
+        return false;
     }
 
-    return mb_motion_accum >= MB_MOVE_THRESHOLD;
+    uint32_t span_ms = (current - oldest + 1) * slot_ms;
+    return path * 1000 >= (uint32_t)config->min_velocity * span_ms;
+}
+
+bool mb_motion_set(pointer_device_t device, mb_motion_param_t param, uint16_t value) {
+    if (device >= POINTER_DEVICE_COUNT) {
+        return false;
+    }
+
+    mb_motion_config_t *config = &mb_motion_config[device];
+    switch (param) {
+        case MB_MOTION_THRESHOLD:
+            config->threshold = value;
+#ifndef MB_CALIBRATION_DISABLE
+            if (device == POINTER_RIGHT) {
+                mb_calibration.enabled = false; // a hand-set value wins over a learned one
+            }
+#endif // MB_CALIBRATION_DISABLE
+            break;
+        case MB_MOTION_RESET_MS:     config->reset_ms = value; break;
+        case MB_MOTION_WINDOW_MS:    config->window_ms = value; break;
+        case MB_MOTION_MIN_VELOCITY: config->min_velocity = value; break;
+        case MB_MOTION_COHERENCE:
+            if (value > 256) return false; // net travel never exceeds the path
+            config->coherence = value;
+            break;
+        default: return false;
+    }
+
+    // Slot numbers depend on the window width; start the window over.
+    for (uint8_t i = 0; i < MB_MOTION_SLOTS; i++) {
+        mb_motion[device].ring[i].path = 0;
+    }
+    return true;
+}
+
+uint16_t mb_motion_get(pointer_device_t device, mb_motion_param_t param) {
+    if (device >= POINTER_DEVICE_COUNT) {
+        return 0;
+    }
+
+    const mb_motion_config_t *config = &mb_motion_config[device];
+    switch (param) {
+        case MB_MOTION_THRESHOLD:    return config->threshold;
+        case MB_MOTION_RESET_MS:     return config->reset_ms;
+        case MB_MOTION_WINDOW_MS:    return config->window_ms;
+        case MB_MOTION_MIN_VELOCITY: return config->min_velocity;
+        case MB_MOTION_COHERENCE:    return config->coherence;
+        default:                     return 0;
+    }
+}
+
+void mb_motion_reset_config(void) {
+    for (uint8_t i = 0; i < POINTER_DEVICE_COUNT; i++) {
+        mb_motion_config[i] = mb_motion_defaults[i];
+    }
+#ifndef MB_CALIBRATION_DISABLE
+    mb_calibration = (mb_calibration_t){.enabled = true, .applied_dpi = MB_CALIB_DPI_NONE};
+#endif // MB_CALIBRATION_DISABLE
 }
 
 /**
@@ -154,80 +622,111 @@ static bool pointer_is_moving(mouse_xy_report_t x, mouse_xy_report_t y) {
 extern void mouse_mode(bool on);
 
 /**
- * @brief State information for a mouse button key
- *
- * This structure tracks the current state and behavior mode of each special
- * mouse button key (MB_SFT, MB_ALT, MB_GUI, MB_CTL) to determine whether it
- * should act as a modifier or mouse button.
+ * @brief One dual-role key: a mouse button by default, a modifier when it
+ *        has to be
  */
 typedef struct {
-    bool is_held;                  ///< True if the key is currently pressed down
-    bool used_as_modifier;         ///< True if the key has been used as a modifier in this press
-    bool converted_to_mouse;       ///< True if the key was converted to mouse button due to mouse movement
-    bool mods_on_press;            ///< True if external modifiers were active when this key was pressed
-    bool should_exit_mouse_mode;   ///< True if mouse mode should be exited when this key is released
-    uint8_t click_mods;            ///< Modifiers contributed by OTHER held keys, claimed for this button's press
-} mb_state_t;
+    uint16_t keycode; ///< The key, as process_record_user() sees it
+    uint8_t  mods;    ///< MOD_BIT mask it holds when it acts as a modifier
+    uint16_t button;  ///< KC_BTN1..KC_BTN8 it presses when it acts as a button
+} mb_key_t;
+
+/* The dual-role keys. Any keycode can be one, with any modifier mask and any
+ * mouse button; define MB_KEYS in config.h with the same shape to replace the
+ * set (a right-hand MB_RSFT on KC_BTN5, say). Up to MB_KEY_MAX entries: each
+ * state set below is one bit per entry, so adding keys costs nothing per
+ * event beyond the keycode lookup. */
+#ifndef MB_KEYS
+#    define MB_KEYS                                 \
+        {                                           \
+            {MB_SFT, MOD_BIT(KC_LSFT), KC_BTN1},    \
+            {MB_ALT, MOD_BIT(KC_LALT), KC_BTN2},    \
+            {MB_GUI, MOD_BIT(KC_LGUI), KC_BTN3},    \
+            {MB_CTL, MOD_BIT(KC_LCTL), KC_BTN4},    \
+        }
+#endif
+
+static const mb_key_t mb_keys[] = MB_KEYS;
+
+#define MB_KEY_COUNT (sizeof(mb_keys) / sizeof(mb_keys[0]))
+#define MB_KEY_MAX 16
+_Static_assert(MB_KEY_COUNT <= MB_KEY_MAX, "MB_KEYS holds at most 16 keys");
+
+/** A set of dual-role keys: bit i is mb_keys[i]. */
+typedef uint16_t mb_mask_t;
+#define MB_BIT(index) ((mb_mask_t)1 << (index))
+
+/** Iterate over the indexes of a mask's set bits, lowest first. */
+#define MB_FOR_EACH(index, mask) \
+    for (mb_mask_t _mb_rest = (mask); _mb_rest && ((index) = __builtin_ctz(_mb_rest), 1); _mb_rest &= _mb_rest - 1)
 
 /**
- * @brief State array for all four special mouse button keys
+ * @brief What every dual-role key is doing, as one set per property
  *
- * Index mapping:
- * - 0: MB_SFT (Shift)
- * - 1: MB_ALT (Alt)
- * - 2: MB_GUI (GUI/Super/Command)
- * - 3: MB_CTL (Control)
+ * A key is UNDECIDED while it is held and in none of the three role sets --
+ * see mb_undecided(). Keeping each property as a set turns "resolve every
+ * pending key" into a couple of mask operations, however many keys there are.
  */
-static mb_state_t mb_states[4] = {0};
+typedef struct {
+    mb_mask_t held;            ///< Currently pressed down
+    mb_mask_t modifier;        ///< Used as a modifier in this press
+    mb_mask_t converted;       ///< Converted to a held button by pointer motion
+    mb_mask_t mods_on_press;   ///< External modifiers were active at press: a button from the start
+    mb_mask_t exit_mouse_mode; ///< Mouse mode should be exited when this key is released
+} mb_state_t;
+
+static mb_state_t mb_state = {0};
+
+/** Modifiers contributed by OTHER held keys, claimed for each key's button press. */
+static uint8_t mb_click_mods[MB_KEY_COUNT] = {0};
 
 /**
- * @brief Maps a special mouse button keycode to its state array index
+ * @brief Maps a keycode to its mb_keys[] index
  *
- * @param keycode The keycode to map (MB_SFT, MB_ALT, MB_GUI, or MB_CTL)
- * @return int Index into mb_states array (0-3), or -1 if keycode is not a
- *         special mouse button
+ * @param keycode Any keycode
+ * @return int Index into mb_keys, or -1 if keycode is not a dual-role key
  */
 static int get_mb_index(uint16_t keycode) {
-    switch (keycode) {
-        case MB_SFT: return 0;
-        case MB_ALT: return 1;
-        case MB_GUI: return 2;
-        case MB_CTL: return 3;
-        default:     return -1;
+    for (uint8_t i = 0; i < MB_KEY_COUNT; i++) {
+        if (mb_keys[i].keycode == keycode) {
+            return i;
+        }
     }
+
+    return -1;
+}
+
+bool is_mb_key(uint16_t keycode) {
+    return get_mb_index(keycode) >= 0;
 }
 
 /**
- * @brief Gets the modifier bit corresponding to a state array index
+ * @brief The held keys that have not committed to a role yet
  *
- * @param index Index into mb_states array (0-3)
- * @return uint8_t Modifier bit mask (MOD_BIT format), or 0 if index is invalid
+ * Exactly the keys a competing signal (pointer motion, a scroll, another
+ * key) would resolve.
+ * @private
  */
-static uint8_t get_modifier(int index) {
-    switch (index) {
-        case 0: return MOD_BIT(KC_LSFT);
-        case 1: return MOD_BIT(KC_LALT);
-        case 2: return MOD_BIT(KC_LGUI);
-        case 3: return MOD_BIT(KC_LCTL);
-        default: return 0;
-    }
+static mb_mask_t mb_undecided(void) {
+    return mb_state.held & ~(mb_state.modifier | mb_state.converted | mb_state.mods_on_press);
 }
 
 /**
- * @brief Gets the mouse button keycode corresponding to a state array index
+ * @brief Claim each key's modifier, one claim per key
  *
- * @param index Index into mb_states array (0-3)
- * @return uint16_t Mouse button keycode (KC_BTN1-KC_BTN4), or KC_NO if index
- *         is invalid
+ * Per key rather than for the union, so two keys sharing a modifier each
+ * hold their own claim and releasing one cannot drop the other's. The host
+ * still gets them in one report, however many keys resolved at once.
+ * @private
  */
-static uint16_t get_mouse_button(int index) {
-    switch (index) {
-        case 0: return KC_BTN1;
-        case 1: return KC_BTN2;
-        case 2: return KC_BTN3;
-        case 3: return KC_BTN4;
-        default: return KC_NO;
+static void mb_acquire_mods(mb_mask_t keys) {
+    int i;
+
+    mods_begin();
+    MB_FOR_EACH(i, keys) {
+        mods_acquire(mb_keys[i].mods);
     }
+    mods_commit();
 }
 
 /**
@@ -241,17 +740,6 @@ static bool is_mouse_button(uint16_t keycode) {
     return keycode >= KC_BTN1 && keycode <= KC_BTN8;
 }
 
-/**
- * @brief True while another special key is committed to its mouse-button role
- *
- * That is: a drag (converted by pointer motion) or a click being held down
- * (decided at press time by external modifiers). Either way a mouse gesture is
- * already in flight.
- *
- * @param except_index State index to ignore, normally the key being pressed
- * @return true if some OTHER special key is currently acting as a mouse button
- * @private
- */
 /**
  * @brief Modifiers that other currently-held keys contribute to a mouse click
  *
@@ -288,40 +776,63 @@ static uint8_t click_modifiers(void) {
 /**
  * @brief Claim the contributed modifiers for a button that is going down
  *
- * Called BEFORE the button is emitted, so the press already carries them.
+ * Inside a townk_mods.c transaction whose commit presses the button, so the
+ * press already carries them.
  * @private
  */
-static void acquire_click_modifiers(mb_state_t *state) {
-    state->click_mods = click_modifiers();
-    mods_acquire(state->click_mods);
+static void acquire_click_modifiers(int index) {
+    mb_click_mods[index] = click_modifiers();
+    mods_acquire(mb_click_mods[index]);
 }
 
 /**
  * @brief Give up the modifiers claimed for a button that has gone up
  *
- * Called AFTER the button is released, so the release still carries them --
- * which is what makes Finder treat a drop as a copy. Scoped to the button
- * rather than to how long the contributing key is held, so the modifier cannot
- * leak into the layer that key is also holding open (Option+arrow is
- * word-jump, not character-move).
+ * Inside a townk_mods.c transaction whose commit releases the button first,
+ * so the release still carries them -- which is what makes Finder treat a
+ * drop as a copy. Scoped to the button rather than to how long the
+ * contributing key is held, so the modifier cannot leak into the layer that
+ * key is also holding open (Option+arrow is word-jump, not character-move).
  * @private
  */
-static void release_click_modifiers(mb_state_t *state) {
-    mods_release(state->click_mods);
-    state->click_mods = 0;
+static void release_click_modifiers(int index) {
+    mods_release(mb_click_mods[index]);
+    mb_click_mods[index] = 0;
 }
 
-static bool button_gesture_in_flight(int except_index) {
-    for (int i = 0; i < 4; i++) {
-        if (i == except_index) continue;
+/**
+ * @brief Press a key's mouse button, with its contributed modifiers
+ * @private
+ */
+static void mb_button_down(int index) {
+    mods_begin();
+    acquire_click_modifiers(index);
+    mods_commit_press(mb_keys[index].button);
+}
 
-        mb_state_t *state = &mb_states[i];
-        if (state->is_held && (state->converted_to_mouse || state->mods_on_press)) {
-            return true;
-        }
-    }
+/**
+ * @brief Release a key's mouse button, then its contributed modifiers
+ * @private
+ */
+static void mb_button_up(int index) {
+    mods_begin();
+    release_click_modifiers(index);
+    mods_commit_release(mb_keys[index].button);
+}
 
-    return false;
+/**
+ * @brief True while another special key is committed to its mouse-button role
+ *
+ * That is: a drag (converted by pointer motion) or a click being held down
+ * (decided at press time by external modifiers). Either way a mouse gesture is
+ * already in flight.
+ *
+ * @param except_index State index to ignore, normally the key being pressed
+ * @return true if some OTHER special key is currently acting as a mouse button
+ * @private
+ */
+static bool button_gesture_in_flight(int except_index) {
+    return (mb_state.held & (mb_state.converted | mb_state.mods_on_press) & ~MB_BIT(except_index)) != 0;
 }
 
 void confirm_pending_modifiers(uint16_t keycode) {
@@ -329,30 +840,29 @@ void confirm_pending_modifiers(uint16_t keycode) {
     bool is_special_key = (mb_index >= 0);
     bool is_mouse_btn   = is_mouse_button(keycode);
 
-    for (int i = 0; i < 4; i++) {
-        // Skip the key being pressed if it's also a special key
-        if (i == mb_index) continue;
-
-        mb_state_t *state = &mb_states[i];
+    // Every held key that hasn't committed to a role yet becomes a modifier
+    // -- except the key being pressed, if it is a special key itself.
+    mb_mask_t pending = mb_undecided();
+    if (is_special_key) {
+        pending &= ~MB_BIT(mb_index);
+    }
+    if (!pending) {
+        return;
+    }
 
-        // If a special key is held but hasn't committed to a role yet,
-        // make it a modifier
-        if (state->is_held && !state->used_as_modifier && !state->converted_to_mouse && !state->mods_on_press) {
-            state->used_as_modifier = true;
+    mb_state.modifier |= pending;
+    TOWNK_TRACE(TOWNK_TRACE_MB_RESOLVE, TOWNK_TRACE_ROLE_MODIFIER, pending);
 
-            // Register the modifier HERE, not at press time. Every caller
-            // reaches this before the key that triggered it is emitted --
-            // process_record_user() returns true afterwards, and
-            // on_smtd_action() runs this ahead of its own switch -- so the
-            // modifier is down in time to apply to that key.
-            mods_acquire(get_modifier(i));
+    // Register the modifiers HERE, not at press time. Every caller reaches
+    // this before the key that triggered it is emitted --
+    // process_record_user() returns true afterwards, and on_smtd_action()
+    // runs this ahead of its own switch -- so the modifiers are down in time
+    // to apply to that key.
+    mb_acquire_mods(pending);
 
-            // Defer mouse_mode(false) until release, only for non-mouse
-            // keys
-            if (!is_mouse_btn && !is_special_key) {
-                state->should_exit_mouse_mode = true;
-            }
-        }
+    // Defer mouse_mode(false) until release, only for non-mouse keys
+    if (!is_mouse_btn && !is_special_key) {
+        mb_state.exit_mouse_mode |= pending;
     }
 }
 
@@ -363,38 +873,38 @@ bool process_special_mouse_keys(uint16_t keycode, keyrecord_t *record) {
     // FIRST: For ANY key press, confirm pending special keys as modifiers
     if (record->event.pressed) {
         confirm_pending_modifiers(keycode);
+#ifndef MB_CALIBRATION_DISABLE
+        if (is_special_key || is_mouse_button(keycode)) {
+            mb_calibration_observe_button();
+        }
+#endif // MB_CALIBRATION_DISABLE
     }
 
     // THEN: Handle our custom mouse/modifier keys
     if (is_special_key) {
-        mb_state_t *state = &mb_states[mb_index];
+        mb_mask_t       bit = MB_BIT(mb_index);
+        const mb_key_t *key = &mb_keys[mb_index];
 
         if (record->event.pressed) {
             // Initialize state for this key press
-            state->is_held = true;
-            state->used_as_modifier = false;
-            state->converted_to_mouse = false;
-
-            // Check if there are external modifiers (not from our special
-            // keys)
-            // Check all modifier sources: normal, oneshot, and weak mods
-            uint8_t current_mods = get_mods() | get_oneshot_mods() | get_weak_mods();
-            uint8_t our_mods = 0;
-            for (int i = 0; i < 4; i++) {
-                // Skip the key being pressed to avoid false detection
-                if (i == mb_index) continue;
-
-                if (mb_states[i].is_held && !mb_states[i].mods_on_press) {
-                    our_mods |= get_modifier(i);
-                }
+            mb_state.held |= bit;
+            mb_state.modifier &= ~bit;
+            mb_state.converted &= ~bit;
+            mb_state.exit_mouse_mode &= ~bit;
+
+            // External modifiers -- normal, one-shot or weak -- that no
+            // townk_mods claim holds: another MB_* key acting as one, or a
+            // modifier it contributes to a click, does not count.
+            if (mods_foreign() != 0) {
+                mb_state.mods_on_press |= bit;
+            } else {
+                mb_state.mods_on_press &= ~bit;
             }
-            state->mods_on_press = ((current_mods & ~our_mods) != 0);
-            state->should_exit_mouse_mode = false;
 
             // If external modifiers are active, act as mouse button
-            if (state->mods_on_press) {
-                acquire_click_modifiers(state);
-                register_code(get_mouse_button(mb_index));
+            if (mb_state.mods_on_press & bit) {
+                TOWNK_TRACE(TOWNK_TRACE_MB_PRESS, mb_index, TOWNK_TRACE_ROLE_BUTTON);
+                mb_button_down(mb_index);
             } else if (button_gesture_in_flight(mb_index)) {
                 // A drag or held click is already in flight, so this key is
                 // qualifying that gesture rather than starting one of its
@@ -405,8 +915,11 @@ bool process_special_mouse_keys(uint16_t keycode, keyrecord_t *record) {
                 // The mirror of the branch above: a modifier held at press
                 // time makes the key a button, a button held at press time
                 // makes it a modifier.
-                state->used_as_modifier = true;
-                mods_acquire(get_modifier(mb_index));
+                TOWNK_TRACE(TOWNK_TRACE_MB_PRESS, mb_index, TOWNK_TRACE_ROLE_MODIFIER);
+                mb_state.modifier |= bit;
+                mods_acquire(key->mods);
+            } else {
+                TOWNK_TRACE(TOWNK_TRACE_MB_PRESS, mb_index, TOWNK_TRACE_ROLE_UNDECIDED);
             }
             // Otherwise commit to NOTHING yet. On this layer the key is a
             // button by default and a modifier only by exception, so the
@@ -416,36 +929,39 @@ bool process_special_mouse_keys(uint16_t keycode, keyrecord_t *record) {
         } else {
             // Key release - determine what to release based on how the key was
             // used
-            if (state->mods_on_press) {
+            if (mb_state.mods_on_press & bit) {
                 // Was used as mouse button due to external modifiers
-                unregister_code(get_mouse_button(mb_index));
-                release_click_modifiers(state);
-            } else if (state->converted_to_mouse) {
+                TOWNK_TRACE(TOWNK_TRACE_MB_RELEASE, mb_index, TOWNK_TRACE_ROLE_BUTTON);
+                mb_button_up(mb_index);
+            } else if (mb_state.converted & bit) {
                 // Was converted to mouse button by mouse movement
-                unregister_code(get_mouse_button(mb_index));
-                release_click_modifiers(state);
-            } else if (state->used_as_modifier) {
+                TOWNK_TRACE(TOWNK_TRACE_MB_RELEASE, mb_index, TOWNK_TRACE_ROLE_DRAG);
+                mb_button_up(mb_index);
+            } else if (mb_state.modifier & bit) {
                 // Was used as a modifier (another key was pressed, or a scroll)
-                mods_release(get_modifier(mb_index));
+                TOWNK_TRACE(TOWNK_TRACE_MB_RELEASE, mb_index, TOWNK_TRACE_ROLE_MODIFIER);
+                mods_release(key->mods);
             } else {
                 // Nothing ever competed for this press, so it keeps its
                 // default role: a click. No modifier to release first --
                 // none was ever registered.
-                acquire_click_modifiers(state);
-                tap_code(get_mouse_button(mb_index));
-                release_click_modifiers(state);
+                TOWNK_TRACE(TOWNK_TRACE_MB_RELEASE, mb_index, TOWNK_TRACE_ROLE_CLICK);
+                latency_observe(LATENCY_MB_CLICK, keycode);
+                mb_button_down(mb_index);
+                mb_button_up(mb_index);
             }
 
             // Exit mouse mode on release if flagged
-            if (state->should_exit_mouse_mode) {
+            if (mb_state.exit_mouse_mode & bit) {
                 mouse_mode(false);
             }
 
-            // Reset state
-            state->is_held = false;
-            state->used_as_modifier = false;
-            state->converted_to_mouse = false;
-            state->should_exit_mouse_mode = false;
+            // Reset state. mods_on_press is left as it was: it only means
+            // anything while the key is held, and the next press sets it.
+            mb_state.held &= ~bit;
+            mb_state.modifier &= ~bit;
+            mb_state.converted &= ~bit;
+            mb_state.exit_mouse_mode &= ~bit;
         }
 
         return false; // Key was handled, stop further processing
@@ -454,6 +970,220 @@ bool process_special_mouse_keys(uint16_t keycode, keyrecord_t *record) {
     return true; // Not a special key, continue processing
 }
 
+/**
+ * @brief True while any special key is held, whatever its role
+ * @private
+ */
+static bool mb_key_held(void) {
+    return mb_state.held != 0;
+}
+
+/**
+ * @brief True while some held special key has not committed to a role yet
+ * @private
+ */
+static bool mb_key_undecided(void) {
+    return mb_undecided() != 0;
+}
+
+/**
+ * @brief Add withheld motion back into a report axis, saturating
+ * @private
+ */
+static mouse_xy_report_t pointer_replay_axis(mouse_xy_report_t value, int32_t withheld) {
+    int32_t out = (int32_t)value + withheld;
+    if (out > XY_REPORT_MAX) return XY_REPORT_MAX;
+    if (out < XY_REPORT_MIN) return XY_REPORT_MIN;
+    return (mouse_xy_report_t)out;
+}
+
+/**
+ * @brief Classify one pointer device's report, withholding motion that is
+ *        not yet a drag
+ *
+ * While a key is undecided, the motion that pointer_is_moving() has not yet
+ * called deliberate is held back instead of moving the pointer: if it turns
+ * out to be the start of a drag, the button must go down where that motion
+ * BEGAN, not MB_MOVE_THRESHOLD counts later -- the difference between
+ * selecting a word's first letter and its second. The held-back motion is
+ * replayed into the report that follows the decision (and the decision's
+ * register_code() has already sent the button-down by then), so the drag
+ * starts at the original position with no added latency.
+ *
+ * Nothing is ever dropped. Motion withheld for a key that then becomes a
+ * click or a modifier is replayed on the next report; motion from a stream
+ * that went quiet is replayed as plain pointer motion before the new stream
+ * starts.
+ *
+ * Nor is anything held for long. A slow drag never satisfies the velocity
+ * gate, and its reports come too close together to go quiet, so once a
+ * stream has withheld the device's threshold in path the motion is let
+ * through, and the rest of that stream flows as it comes: the pointer lags
+ * by at most one threshold instead of freezing and then jumping. The key
+ * stays undecided -- a drag still has to be fast enough to earn.
+ *
+ * @param device The ball the report came from
+ * @param report That ball's report; x/y are withheld or topped up in place
+ * @param undecided Whether a held special key is waiting for a verdict
+ * @return Whether the device is moving deliberately (see pointer_is_moving())
+ * @private
+ */
+static bool pointer_track(pointer_device_t device, report_mouse_t *report, bool undecided) {
+    mb_motion_t *motion = &mb_motion[device];
+
+    // Checked before pointer_is_moving() stamps this report's time.
+    bool stale  = (report->x != 0 || report->y != 0) && pointer_motion_is_stale(device);
+    bool moving = pointer_is_moving(device, report->x, report->y);
+
+    int32_t replay_x = 0;
+    int32_t replay_y = 0;
+
+    if (stale) {
+        // The stream that went quiet was not a drag; let it move the pointer
+        // before this new stream is judged on its own.
+        replay_x               = motion->withheld_x;
+        replay_y               = motion->withheld_y;
+        motion->withheld_x     = 0;
+        motion->withheld_y     = 0;
+        motion->withheld_path  = 0;
+        motion->withhold_spent = false;
+    }
+
+    if (undecided && !moving && !motion->withhold_spent) {
+        motion->withheld_x += report->x;
+        motion->withheld_y += report->y;
+        motion->withheld_path += (uint32_t)(report->x < 0 ? -report->x : report->x) + (uint32_t)(report->y < 0 ? -report->y : report->y);
+        report->x = 0;
+        report->y = 0;
+        // A threshold's worth of slow travel: the pointer has to follow it.
+        motion->withhold_spent = motion->withheld_path >= mb_motion_config[device].threshold;
+    }
+    if (!undecided) {
+        motion->withhold_spent = false;
+    }
+    if (!undecided || moving || motion->withhold_spent) {
+        replay_x += motion->withheld_x;
+        replay_y += motion->withheld_y;
+        motion->withheld_x    = 0;
+        motion->withheld_y    = 0;
+        motion->withheld_path = 0;
+    }
+
+    if (replay_x != 0 || replay_y != 0) {
+        report->x = pointer_replay_axis(report->x, replay_x);
+        report->y = pointer_replay_axis(report->y, replay_y);
+    }
+
+    return moving;
+}
+
+/**
+ * @brief Resolve every undecided held special key from one report's verdict
+ *
+ * Pointer motion and scrolling resolve an undecided key in OPPOSITE
+ * directions, so motion is checked first and wins when a report carries both
+ * (a drag with a little scroll noise is still a drag). "Motion" means the
+ * accumulated threshold of pointer_is_moving(), not any nonzero report: a
+ * sub-threshold wiggle riding on a scroll is treated as the scroll.
+ *
+ * The keys resolved are exactly mb_undecided(): held, and not yet a
+ * modifier, a converted button, or a button from the start (mods_on_press).
+ *
+ * @param moving True if some pointer-moving device crossed its threshold
+ * @param scrolled True if the report carries any wheel motion
+ * @private
+ */
+static void resolve_pending_from_pointer(bool moving, bool scrolled) {
+    mb_mask_t pending = mb_undecided();
+    if (!pending || (!moving && !scrolled)) {
+        return;
+    }
+
+    if (moving) {
+        // Dragging: hold the button down for the whole gesture.
+        mb_state.converted |= pending;
+        TOWNK_TRACE(TOWNK_TRACE_MB_RESOLVE, TOWNK_TRACE_ROLE_DRAG, pending);
+
+        // Every converted key's modifiers in one report, then the buttons.
+        int i;
+        mods_begin();
+        MB_FOR_EACH(i, pending) {
+            latency_observe(LATENCY_MB_DRAG, mb_keys[i].keycode);
+            acquire_click_modifiers(i);
+        }
+        mods_commit();
+        MB_FOR_EACH(i, pending) {
+            register_code(mb_keys[i].button);
+        }
+    } else {
+        // Scrolling: the key is qualifying the scroll, not clicking
+        // through it -- this is what keeps Cmd+scroll as zoom. It
+        // also stops the release from firing a stray click, which
+        // is the same defect as a modifier-less phantom press.
+        mb_state.modifier |= pending;
+        TOWNK_TRACE(TOWNK_TRACE_MB_RESOLVE, TOWNK_TRACE_ROLE_MODIFIER, pending);
+        mb_acquire_mods(pending);
+    }
+}
+
+#ifdef POINTING_DEVICE_COMBINED
+/** Set when the per-device hook below has already resolved this report. */
+static bool mb_report_resolved = false;
+
+/**
+ * @brief Whether a device's x/y is scroll rather than pointer motion
+ *
+ * A ball in scroll mode never starts a drag, whatever its x/y say: its travel
+ * becomes wheel motion, and a drag is a claim about where the POINTER is.
+ * @private
+ */
+static bool pointer_is_scroll_ball(pointer_device_t device) {
+    return device == POINTER_LEFT ? global_saved_values.left_scroll : global_saved_values.right_scroll;
+}
+
+/**
+ * @brief QMK combined pointing hook: classify each trackball on its own
+ *
+ * On a dual-ball build this is the one place the two reports are still
+ * separate, so each one is fed to its own device's accumulator here -- the
+ * drag decision then belongs to the ball that actually moved the pointer,
+ * and a scroll ball's travel never counts toward it. Each device costs O(1).
+ *
+ * It is also where a scroll ball's travel becomes wheel motion, through the
+ * fractional scroll stage in townk_pointing.c.
+ *
+ * pointing_device_task_kb() still runs on the merged report afterwards; it
+ * sees that the report was resolved here and does not classify it again.
+ */
+report_mouse_t pointing_device_task_combined_user(report_mouse_t left_report, report_mouse_t right_report) {
+    bool moving    = false;
+    bool undecided = mb_key_undecided();
+
+    // A scroll ball's travel goes through the scroll stage instead, which
+    // turns it into (possibly high-resolution) wheel motion.
+    if (pointer_is_scroll_ball(POINTER_LEFT)) {
+        left_report = pointer_scroll_apply(POINTER_LEFT, left_report);
+    } else {
+        moving |= pointer_track(POINTER_LEFT, &left_report, undecided);
+    }
+    if (pointer_is_scroll_ball(POINTER_RIGHT)) {
+        right_report = pointer_scroll_apply(POINTER_RIGHT, right_report);
+    } else {
+        moving |= pointer_track(POINTER_RIGHT, &right_report, undecided);
+    }
+
+    // Judged on the wheel output, not on the ball's raw travel: a resting
+    // hand's blip on the scroll ball stays below a tick and must not turn a
+    // held key into a modifier any more than it may turn it into a drag.
+    bool scrolled = (left_report.h != 0 || left_report.v != 0 || right_report.h != 0 || right_report.v != 0);
+
+    resolve_pending_from_pointer(moving, scrolled);
+    mb_report_resolved = true;
+
+    return pointing_device_combine_reports(left_report, right_report);
+}
+#endif // POINTING_DEVICE_COMBINED
+
 /**
  * @brief QMK pointing device task hook for automatic modifier-to-mouse
  *        conversion
@@ -464,21 +1194,21 @@ bool process_special_mouse_keys(uint16_t keycode, keyrecord_t *record) {
  *
  * **Conversion Logic:**
  * When deliberate mouse movement is detected (accumulated motion crossing
- * MB_MOVE_THRESHOLD -- see pointer_is_moving()), this function checks each
- * special key to see if it should be converted to a mouse button. A key is
- * converted if:
- * - The key is currently held (is_held)
- * - It hasn't been used as a modifier yet (used_as_modifier is false)
- * - It hasn't already been converted (converted_to_mouse is false)
- * - No external modifiers were active when pressed (mods_on_press is false)
- *
- * When conversion happens:
- * 1. The modifier is unregistered
- * 2. The corresponding mouse button is registered
- * 3. The state is marked as converted_to_mouse
+ * MB_MOVE_THRESHOLD -- see pointer_is_moving()), each undecided held special
+ * key is converted to its held mouse button -- see
+ * resolve_pending_from_pointer().
+ *
+ * On a dual-ball build the decision has already been made per device by
+ * pointing_device_task_combined_user(); this hook only classifies reports
+ * that never went through it, attributing them to the pointer ball.
  *
  * This allows users to hold a special key and then move the mouse to perform
- * drag operations without having to press multiple keys.
+ * drag operations without having to press multiple keys. The motion that
+ * earned the drag is withheld until the button is down and then replayed, so
+ * the drag starts where the pointer was -- see pointer_track().
+ *
+ * Once the keys are resolved, the report goes through the shaping stages in
+ * townk_pointing.c (pointer acceleration) before it is handed on.
  *
  * @param report The mouse movement report from QMK
  * @return report_mouse_t The report to be sent (passed to user layer)
@@ -487,37 +1217,22 @@ bool process_special_mouse_keys(uint16_t keycode, keyrecord_t *record) {
  *       pointing_device_task_user() for further user-level processing.
  */
 report_mouse_t pointing_device_task_kb(report_mouse_t report) {
-    bool moving     = pointer_is_moving(report.x, report.y);
-    bool scrolled   = (report.h != 0 || report.v != 0);
-
-    // Pointer motion and scrolling resolve an undecided key in OPPOSITE
-    // directions, so motion is checked first and wins when a report carries
-    // both (a drag with a little scroll noise is still a drag). "Motion"
-    // means the accumulated threshold above, not any nonzero report: a
-    // sub-threshold wiggle riding on a scroll is treated as the scroll.
-    if (moving || scrolled) {
-        for (int i = 0; i < 4; i++) {
-            mb_state_t *state = &mb_states[i];
-
-            if (!state->is_held || state->used_as_modifier || state->converted_to_mouse || state->mods_on_press) {
-                continue;
-            }
+    bool resolved = false;
+#ifdef POINTING_DEVICE_COMBINED
+    resolved           = mb_report_resolved;
+    mb_report_resolved = false;
+#endif // POINTING_DEVICE_COMBINED
 
-            if (moving) {
-                // Dragging: hold the button down for the whole gesture.
-                acquire_click_modifiers(state);
-                register_code(get_mouse_button(i));
-                state->converted_to_mouse = true;
-            } else {
-                // Scrolling: the key is qualifying the scroll, not clicking
-                // through it -- this is what keeps Cmd+scroll as zoom. It
-                // also stops the release from firing a stray click, which
-                // is the same defect as a modifier-less phantom press.
-                mods_acquire(get_modifier(i));
-                state->used_as_modifier = true;
-            }
-        }
+    if (!resolved) {
+        bool moving   = pointer_track(POINTER_RIGHT, &report, mb_key_undecided());
+        bool scrolled = (report.h != 0 || report.v != 0);
+
+        resolve_pending_from_pointer(moving, scrolled);
     }
 
+    // Shaping comes AFTER the decision above, which is made in raw sensor
+    // counts: a curve must never move a drag threshold.
+    report = pointer_accel_apply(report);
+
     return pointing_device_task_user(report);
 }
@@ -19,6 +19,8 @@
 
 #include "action.h"
 
+#include "townk_pointing.h"
+
 #define MOUSE_DPI_200 0
 #define MOUSE_DPI_400 1
 #define MOUSE_DPI_800 2
@@ -111,4 +113,45 @@ bool process_special_mouse_keys(uint16_t keycode, keyrecord_t *record);
  */
 void confirm_pending_modifiers(uint16_t keycode);
 
+/** @brief Whether a keycode is one of the MB_KEYS dual-role keys */
+bool is_mb_key(uint16_t keycode);
+
+/**
+ * @brief The runtime-tunable knobs of the MB_* motion classifier
+ *
+ * Each starts at its build-time MB_MOVE_* default; see townk_mouse.c for
+ * what they mean.
+ */
+typedef enum {
+    MB_MOTION_THRESHOLD,    ///< MB_MOVE_THRESHOLD, in counts
+    MB_MOTION_RESET_MS,     ///< MB_MOVE_RESET_MS
+    MB_MOTION_WINDOW_MS,    ///< MB_MOVE_WINDOW_MS
+    MB_MOTION_MIN_VELOCITY, ///< MB_MOVE_MIN_VELOCITY, in counts/s
+    MB_MOTION_COHERENCE,    ///< MB_MOVE_COHERENCE, in 1/256ths (at most 256)
+    MB_MOTION_PARAM_COUNT,
+} mb_motion_param_t;
+
+/**
+ * @brief Change one classifier knob for one ball, effective immediately
+ *
+ * The ball's motion window starts over, since what it holds was judged
+ * under the old setting. Not persisted: a power cycle restores the defaults.
+ * Setting the pointer ball's threshold turns its online calibration off
+ * until then, so the value set is the value used.
+ *
+ * @return false if the device, knob or value is out of range
+ */
+bool mb_motion_set(pointer_device_t device, mb_motion_param_t param, uint16_t value);
+
+/** @brief One classifier knob's current value for one ball (0 if invalid) */
+uint16_t mb_motion_get(pointer_device_t device, mb_motion_param_t param);
+
+/**
+ * @brief Put every classifier knob back to its build-time default
+ *
+ * Also forgets the drag-threshold calibration gathered since power-up (what
+ * was saved to EEPROM stays) and turns calibration back on.
+ */
+void mb_motion_reset_config(void);
+
 #endif // QMK_USERSPACE_TOWNK_MOUSE_H
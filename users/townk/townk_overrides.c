@@ -27,8 +27,9 @@
  * - Shift + `)` produces `%`
  * - Shift + `!` produces `^`
  *
- * These overrides are active on all layers and suppress the shift modifier
- * when triggered, so the replacement key is sent without shift.
+ * These overrides are active on every layer but the game layers, and suppress
+ * the shift modifier when triggered, so the replacement key is sent without
+ * shift.
  *
  * @author Thiago Alves
  * @date 2024
@@ -57,15 +58,26 @@
  */
 const uint8_t custom_ko_options = vial_ko_option_activation_trigger_down | vial_ko_enabled;
 
+/**
+ * @brief Layers all key overrides apply on: every layer but _GAM1 and _GAM2
+ *
+ * A game key must reach the host as it is, so the overrides leave the game
+ * layers out through their own layer masks. The global key override switch
+ * would do the same, but QMK keeps it in EEPROM: flipping it on every trip
+ * into a game would wear the flash, and a power loss mid-game would leave
+ * the overrides off.
+ */
+const uint16_t custom_ko_layers = (uint16_t)~((1u << _GAM1) | (1u << _GAM2));
+
 /**
  * @brief Key override: Shift + Left Parenthesis → At Sign
  *
- * Transforms `Shift + (` into `@` on all layers.
+ * Transforms `Shift + (` into `@` on every layer but the game layers.
  *
  * **Configuration:**
  * - Trigger: Left parenthesis key with Shift modifier
  * - Replacement: At sign (`@`)
- * - Layers: All layers (`~0` = all bits set)
+ * - Layers: All but the game layers (`custom_ko_layers`)
  * - Suppressed mods: Shift (prevents `Shift + @`)
  * - Result: Pressing `Shift + (` produces `@` without shift
  */
@@ -73,7 +85,7 @@ const vial_key_override_entry_t lparen_key_override = {
     .trigger_mods=MOD_MASK_SHIFT,
     .trigger=KC_LPRN,
     .replacement=KC_AT,
-    .layers=~0,
+    .layers=custom_ko_layers,
     .suppressed_mods=MOD_MASK_SHIFT,
     .negative_mod_mask=0,
     .options=custom_ko_options
@@ -82,12 +94,12 @@ const vial_key_override_entry_t lparen_key_override = {
 /**
  * @brief Key override: Shift + Right Parenthesis → Percent Sign
  *
- * Transforms `Shift + )` into `%` on all layers.
+ * Transforms `Shift + )` into `%` on every layer but the game layers.
  *
  * **Configuration:**
  * - Trigger: Right parenthesis key with Shift modifier
  * - Replacement: Percent sign (`%`)
- * - Layers: All layers (`~0` = all bits set)
+ * - Layers: All but the game layers (`custom_ko_layers`)
  * - Suppressed mods: Shift (prevents `Shift + %`)
  * - Result: Pressing `Shift + )` produces `%` without shift
  */
@@ -95,7 +107,7 @@ const vial_key_override_entry_t rparen_key_override = {
     .trigger_mods=MOD_MASK_SHIFT,
     .trigger=KC_RPRN,
     .replacement=KC_PERC,
-    .layers=~0,
+    .layers=custom_ko_layers,
     .suppressed_mods=MOD_MASK_SHIFT,
     .negative_mod_mask=0,
     .options=custom_ko_options
@@ -104,12 +116,12 @@ const vial_key_override_entry_t rparen_key_override = {
 /**
  * @brief Key override: Shift + Exclamation Mark → Caret/Circumflex
  *
- * Transforms `Shift + !` into `^` on all layers.
+ * Transforms `Shift + !` into `^` on every layer but the game layers.
  *
  * **Configuration:**
  * - Trigger: Exclamation mark key with Shift modifier
  * - Replacement: Caret/circumflex (`^`)
- * - Layers: All layers (`~0` = all bits set)
+ * - Layers: All but the game layers (`custom_ko_layers`)
  * - Suppressed mods: Shift (prevents `Shift + ^`)
  * - Result: Pressing `Shift + !` produces `^` without shift
  */
@@ -117,7 +129,7 @@ const vial_key_override_entry_t exclam_key_override = {
     .trigger_mods=MOD_MASK_SHIFT,
     .trigger=KC_EXLM,
     .replacement=KC_CIRC,
-    .layers=~0,
+    .layers=custom_ko_layers,
     .suppressed_mods=MOD_MASK_SHIFT,
     .negative_mod_mask=0,
     .options=custom_ko_options
@@ -0,0 +1,299 @@
+/* Copyright (C) 2025 Thiago Alves (https://github.com/townk)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file townk_pointing.c
+ * @brief Report-shaping stages for the trackball output -- see
+ *        townk_pointing.h
+ *
+ * **Pointer acceleration.** Switching DPI with SV_RDPU/SV_RDPD trades
+ * precision for reach one keypress at a time. An acceleration curve gives
+ * both at a single DPI: slow, deliberate motion is scaled DOWN for precision,
+ * fast motion is scaled UP so a long move does not need a second swipe.
+ *
+ * The curve is a gain table per DPI index (the row follows
+ * global_saved_values.right_dpi_index, so the DPI keys still work and each
+ * setting keeps a curve tuned for it), indexed by how far the ball travelled
+ * in one report. Gains are fixed point, POINTER_ACCEL_ONE being 1.0x; there is
+ * no floating point anywhere, and the per-report cost is one table read and
+ * two multiplies.
+ *
+ * Scaling a small integer down loses the fraction, and at a gain of 0.5 a
+ * stream of one-count reports would otherwise round to nothing at all. The
+ * fraction is carried per axis into the next report instead, so slow motion
+ * is slowed, never swallowed. It is dropped when the axis reverses, so a
+ * leftover half-count can never nudge the pointer the wrong way.
+ *
+ * **High-resolution scroll.** The scroll ball's travel is turned into wheel
+ * motion here too, rather than into whole ticks of a fixed divisor -- for
+ * the x/y that reaches the user hook. On the Svalboard it does not: the
+ * keyboard-level code converts the scroll ball to h/v first, so the stage
+ * passes that wheel motion through untouched, and the keymap leaves high
+ * resolution off until the stage owns the ball's raw travel. With
+ * POINTING_DEVICE_HIRES_SCROLL_ENABLE, QMK advertises a HID resolution
+ * multiplier and the host reads every wheel unit as 1/multiplier of a notch,
+ * so a slow roll scrolls a line's fraction at a time instead of sitting still
+ * and then jumping. The conversion is exact integer arithmetic: counts times
+ * units-per-tick, divided by counts-per-tick, with the remainder carried per
+ * axis just like the acceleration fraction above.
+ *
+ * Sending every fraction as it appears would flood the host with one-unit
+ * reports. The stage holds wheel units back until they add up to
+ * POINTER_SCROLL_MIN_UNITS or the oldest has waited POINTER_SCROLL_COALESCE_MS,
+ * so each report says something and nothing is ever dropped -- only late.
+ *
+ * @author Thiago Alves
+ */
+
+#include "townk_pointing.h"
+#include "townk_mouse.h"
+#include "timer.h"
+
+#ifdef SVALBOARD
+#    include "keymap_support.h" // global_saved_values
+#endif
+
+/** Gain table columns; a report's speed picks one. */
+#define POINTER_ACCEL_BUCKETS 16
+
+/** Rows: one per MOUSE_DPI_* index. */
+#define POINTER_ACCEL_DPI_COUNT (MOUSE_DPI_2400 + 1)
+
+/** Speed (|x|+|y| counts per report) is divided by 2^this to pick a column,
+ * so the default table spans 0-31 counts and saturates beyond. */
+#ifndef POINTER_ACCEL_SPEED_SHIFT
+#    define POINTER_ACCEL_SPEED_SHIFT 1
+#endif
+
+/* The curves, replaceable at build time by defining POINTER_ACCEL_CURVES in
+ * config.h with the same shape: POINTER_ACCEL_DPI_COUNT rows of
+ * POINTER_ACCEL_BUCKETS gains, in 1/256ths. A row of all 256 is no
+ * acceleration at all. Gains must stay below 32768 so a full-scale report
+ * cannot overflow the 32-bit product.
+ *
+ * The defaults decelerate slow motion harder the higher the DPI (high DPI is
+ * where a one-pixel adjustment is hardest to hit) and all reach roughly 2.5x
+ * at the top, so a long move at any setting is a single flick. */
+#ifndef POINTER_ACCEL_CURVES
+#    define POINTER_ACCEL_CURVES                                                                      \
+        {                                                                                             \
+            /* MOUSE_DPI_200  */ {256, 256, 256, 272, 288, 320, 352, 384, 416, 448, 480, 512, 512, 512, 512, 512}, \
+            /* MOUSE_DPI_400  */ {224, 240, 256, 272, 296, 328, 360, 400, 440, 480, 512, 544, 576, 608, 640, 640}, \
+            /* MOUSE_DPI_800  */ {160, 192, 224, 256, 288, 320, 360, 400, 448, 496, 544, 592, 640, 672, 704, 704}, \
+            /* MOUSE_DPI_1200 */ {128, 160, 192, 224, 256, 296, 336, 384, 432, 480, 528, 576, 624, 672, 704, 736}, \
+            /* MOUSE_DPI_1600 */ {112, 136, 160, 192, 224, 256, 296, 336, 384, 432, 480, 528, 576, 624, 656, 688}, \
+            /* MOUSE_DPI_2400 */ {96, 112, 136, 160, 192, 224, 256, 288, 328, 368, 408, 448, 496, 544, 592, 640},  \
+        }
+#endif
+
+static const uint16_t pointer_accel_curves[POINTER_ACCEL_DPI_COUNT][POINTER_ACCEL_BUCKETS] = POINTER_ACCEL_CURVES;
+
+/** The fraction of a count each axis still owes the host, in 1/256ths. */
+static int32_t pointer_accel_remainder[2] = {0};
+
+uint16_t pointer_accel_gain(uint8_t dpi_index, uint32_t speed) {
+    if (dpi_index >= POINTER_ACCEL_DPI_COUNT) {
+        dpi_index = POINTER_ACCEL_DPI_COUNT - 1;
+    }
+
+    uint32_t bucket = speed >> POINTER_ACCEL_SPEED_SHIFT;
+    if (bucket >= POINTER_ACCEL_BUCKETS) {
+        bucket = POINTER_ACCEL_BUCKETS - 1;
+    }
+
+    return pointer_accel_curves[dpi_index][bucket];
+}
+
+/**
+ * @brief Scale one axis, carrying what did not fit into the next report
+ * @private
+ */
+static mouse_xy_report_t pointer_accel_axis(int32_t *remainder, mouse_xy_report_t counts, uint16_t gain) {
+    if (counts == 0) {
+        return 0; // an axis at rest keeps its fraction for when it moves on
+    }
+
+    // A fraction owed in the other direction is stale: drop it rather than
+    // let it pull against a reversal.
+    if ((counts > 0) != (*remainder > 0)) {
+        *remainder = 0;
+    }
+
+    // C division truncates toward zero, so the remainder keeps the sign of
+    // the motion and both directions round the same way.
+    int32_t scaled = (int32_t)counts * gain + *remainder;
+    int32_t out    = scaled / POINTER_ACCEL_ONE;
+    *remainder     = scaled - out * POINTER_ACCEL_ONE;
+
+    if (out > XY_REPORT_MAX) return XY_REPORT_MAX;
+    if (out < XY_REPORT_MIN) return XY_REPORT_MIN;
+    return (mouse_xy_report_t)out;
+}
+
+report_mouse_t pointer_accel_apply(report_mouse_t report) {
+#ifdef POINTER_ACCEL_DISABLE
+    return report;
+#else
+    if (report.x == 0 && report.y == 0) {
+        return report;
+    }
+
+    uint32_t speed = (uint32_t)(report.x < 0 ? -report.x : report.x) + (uint32_t)(report.y < 0 ? -report.y : report.y);
+    uint16_t gain  = pointer_accel_gain(global_saved_values.right_dpi_index, speed);
+
+    report.x = pointer_accel_axis(&pointer_accel_remainder[0], report.x, gain);
+    report.y = pointer_accel_axis(&pointer_accel_remainder[1], report.y, gain);
+
+    return report;
+#endif // POINTER_ACCEL_DISABLE
+}
+
+/* Wheel units per notch: what the host divides a wheel value by. QMK's own
+ * POINTING_DEVICE_HIRES_SCROLL_MULTIPLIER (default 120, the Windows
+ * convention) when high-resolution scroll is on, otherwise plain ticks. */
+#ifdef POINTING_DEVICE_HIRES_SCROLL_ENABLE
+#    ifndef POINTING_DEVICE_HIRES_SCROLL_MULTIPLIER
+#        define POINTING_DEVICE_HIRES_SCROLL_MULTIPLIER 120
+#    endif
+#    define POINTER_SCROLL_UNITS_PER_TICK POINTING_DEVICE_HIRES_SCROLL_MULTIPLIER
+#else
+#    define POINTER_SCROLL_UNITS_PER_TICK 1
+#endif
+
+/* Ball travel, in sensor counts, that scrolls one full notch. */
+#ifndef POINTER_SCROLL_COUNTS_PER_TICK
+#    define POINTER_SCROLL_COUNTS_PER_TICK 16
+#endif
+
+/* Wheel units worth a report of their own (|h|+|v|); smaller amounts wait
+ * for company. An eighth of a notch when high resolution is on. */
+#ifndef POINTER_SCROLL_MIN_UNITS
+#    if POINTER_SCROLL_UNITS_PER_TICK >= 8
+#        define POINTER_SCROLL_MIN_UNITS (POINTER_SCROLL_UNITS_PER_TICK / 8)
+#    else
+#        define POINTER_SCROLL_MIN_UNITS 1
+#    endif
+#endif
+
+/* How long a held-back amount may wait before it goes out anyway. */
+#ifndef POINTER_SCROLL_COALESCE_MS
+#    define POINTER_SCROLL_COALESCE_MS 16
+#endif
+
+/* The report's h/v range; QMK's pointing_device.h provides these. The
+ * fallback follows WHEEL_EXTENDED_REPORT, which high resolution turns on. */
+#ifndef HV_REPORT_MAX
+#    ifdef POINTING_DEVICE_HIRES_SCROLL_ENABLE
+#        define HV_REPORT_MAX INT16_MAX
+#        define HV_REPORT_MIN INT16_MIN
+#    else
+#        define HV_REPORT_MAX INT8_MAX
+#        define HV_REPORT_MIN INT8_MIN
+#    endif
+#endif
+
+/** A scroll ball's state; [0] is the horizontal axis, [1] the vertical. */
+typedef struct {
+    int32_t  remainder[2]; ///< Counts x units not yet worth a whole unit
+    int32_t  pending[2];   ///< Whole units held back, not yet reported
+    uint32_t pending_since;
+    bool     has_pending;
+} pointer_scroll_t;
+
+static pointer_scroll_t pointer_scroll[POINTER_DEVICE_COUNT] = {0};
+
+/**
+ * @brief Convert one axis's counts into wheel units, held as pending
+ * @private
+ */
+static void pointer_scroll_axis(pointer_scroll_t *scroll, uint8_t axis, int32_t counts) {
+    if (counts == 0) {
+        return;
+    }
+
+    int32_t *remainder = &scroll->remainder[axis];
+    if ((counts > 0) != (*remainder > 0)) {
+        *remainder = 0; // the same reversal rule as the acceleration fraction
+    }
+
+    int32_t scaled = counts * POINTER_SCROLL_UNITS_PER_TICK + *remainder;
+    int32_t units  = scaled / POINTER_SCROLL_COUNTS_PER_TICK;
+    *remainder     = scaled - units * POINTER_SCROLL_COUNTS_PER_TICK;
+
+    if (units != 0) {
+        scroll->pending[axis] += units;
+        if (!scroll->has_pending) {
+            scroll->has_pending   = true;
+            scroll->pending_since = timer_read32();
+        }
+    }
+}
+
+/**
+ * @brief Move as much of an axis's pending units as fits into a wheel value
+ * @private
+ */
+static mouse_hv_report_t pointer_scroll_emit(int32_t *pending, mouse_hv_report_t already) {
+    int32_t out = *pending + already;
+    if (out > HV_REPORT_MAX) out = HV_REPORT_MAX;
+    if (out < HV_REPORT_MIN) out = HV_REPORT_MIN;
+    *pending -= out - already; // whatever did not fit waits for the next report
+    return (mouse_hv_report_t)out;
+}
+
+report_mouse_t pointer_scroll_apply(pointer_device_t device, report_mouse_t report) {
+    pointer_scroll_t *scroll = &pointer_scroll[device];
+
+    // Ball right scrolls right; ball up (negative y) scrolls up (positive v).
+    pointer_scroll_axis(scroll, 0, report.x);
+    pointer_scroll_axis(scroll, 1, -(int32_t)report.y);
+    report.x = 0;
+    report.y = 0;
+
+    if (!scroll->has_pending) {
+        return report;
+    }
+
+    int32_t h = scroll->pending[0];
+    int32_t v = scroll->pending[1];
+    if (h == 0 && v == 0) {
+        scroll->has_pending = false; // a reversal cancelled it out
+        return report;
+    }
+
+    uint32_t magnitude = (uint32_t)(h < 0 ? -h : h) + (uint32_t)(v < 0 ? -v : v);
+    if (magnitude < POINTER_SCROLL_MIN_UNITS && timer_elapsed32(scroll->pending_since) < POINTER_SCROLL_COALESCE_MS) {
+        return report;
+    }
+
+    report.h = pointer_scroll_emit(&scroll->pending[0], report.h);
+    report.v = pointer_scroll_emit(&scroll->pending[1], report.v);
+
+    scroll->has_pending = (scroll->pending[0] != 0 || scroll->pending[1] != 0);
+    if (scroll->has_pending) {
+        scroll->pending_since = timer_read32();
+    }
+
+    return report;
+}
+
+void pointer_shaping_reset(void) {
+    pointer_accel_remainder[0] = 0;
+    pointer_accel_remainder[1] = 0;
+    for (uint8_t i = 0; i < POINTER_DEVICE_COUNT; i++) {
+        pointer_scroll[i] = (pointer_scroll_t){0};
+    }
+}
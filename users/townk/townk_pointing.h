@@ -0,0 +1,110 @@
+/* Copyright (C) 2025 Thiago Alves (https://github.com/townk)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file townk_pointing.h
+ * @brief Report-shaping stages applied to the trackball output
+ *
+ * pointing_device_task_kb() in townk_mouse.c owns the pointing hook; it
+ * decides what the MB_* keys mean from the RAW sensor counts first, and only
+ * then runs the report through the stages here, which change what the host
+ * receives. Keeping them apart means a curve can never move a drag threshold.
+ *
+ * @author Thiago Alves
+ */
+
+#ifndef QMK_USERSPACE_TOWNK_POINTING_H
+#define QMK_USERSPACE_TOWNK_POINTING_H
+
+#include <stdint.h>
+
+#include "pointing_device.h"
+
+/**
+ * @brief The physical pointing devices on a dual-ball board
+ *
+ * Indexes every piece of per-ball state in this userspace.
+ */
+typedef enum {
+    POINTER_LEFT,
+    POINTER_RIGHT,
+    POINTER_DEVICE_COUNT,
+} pointer_device_t;
+
+/* The report's x/y range. QMK's pointing_device.h provides these; the
+ * fallback matches this board's MOUSE_EXTENDED_REPORT. */
+#ifndef XY_REPORT_MAX
+#    define XY_REPORT_MAX INT16_MAX
+#endif
+#ifndef XY_REPORT_MIN
+#    define XY_REPORT_MIN INT16_MIN
+#endif
+
+/** Fixed-point 1.0 for the gain tables: gains are in 1/256ths. */
+#define POINTER_ACCEL_SHIFT 8
+#define POINTER_ACCEL_ONE (1 << POINTER_ACCEL_SHIFT)
+
+/**
+ * @brief Apply the pointer acceleration curve to a report's x/y
+ *
+ * Looks the report's speed (|x|+|y|, in sensor counts) up in the gain table
+ * for the pointer ball's current DPI index, scales each axis by it, and
+ * carries the fraction of a count that did not fit into this report over to
+ * the next one, so slow motion is slowed down without being lost. Integer
+ * only, O(1) per report.
+ *
+ * @param report The report as the sensor produced it
+ * @return The report with x/y scaled; h/v and buttons untouched
+ */
+report_mouse_t pointer_accel_apply(report_mouse_t report);
+
+/**
+ * @brief The gain the curve applies at a given DPI index and speed
+ *
+ * For tests and tuning; production code should not need to ask.
+ *
+ * @param dpi_index A MOUSE_DPI_* value
+ * @param speed |x|+|y| of one report, in sensor counts
+ * @return Gain in POINTER_ACCEL_ONE units (POINTER_ACCEL_ONE is 1.0x)
+ */
+uint16_t pointer_accel_gain(uint8_t dpi_index, uint32_t speed);
+
+/**
+ * @brief Turn a scroll ball's travel into wheel motion
+ *
+ * Converts the report's x/y into wheel units -- high-resolution units when
+ * POINTING_DEVICE_HIRES_SCROLL_ENABLE is on, whole ticks otherwise -- keeping
+ * the fraction of a unit that did not fit for the next report, and holds the
+ * result back until it amounts to POINTER_SCROLL_MIN_UNITS or has waited
+ * POINTER_SCROLL_COALESCE_MS, so a run of small contributions goes out as one
+ * report. Must be called on every pointing task, moving or not: an idle call
+ * is what flushes a held-back remainder on time.
+ *
+ * @param device Which ball the report came from; each has its own state
+ * @param report That ball's report, before merging
+ * @return The report with x/y consumed and h/v carrying the wheel motion
+ *         (added to any wheel motion it already had)
+ */
+report_mouse_t pointer_scroll_apply(pointer_device_t device, report_mouse_t report);
+
+/**
+ * @brief Forget every carried remainder and held-back scroll
+ *
+ * For tests; harmless at any time, costing at most a fraction of a count.
+ */
+void pointer_shaping_reset(void);
+
+#endif // QMK_USERSPACE_TOWNK_POINTING_H
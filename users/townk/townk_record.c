@@ -0,0 +1,77 @@
+/* Copyright (C) 2025 Thiago Alves (https://github.com/townk)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * @file townk_record.c
+ * @brief The userspace's key event pipeline -- see townk_record.h
+ *
+ * @author Thiago Alves
+ */
+
+#include "townk_record.h"
+
+#include "keycodes.h"
+#include "repeat_key.h"
+#include "townk_latency.h"
+#include "townk_layers.h"
+#include "townk_mouse.h"
+#include "townk_smtd.h"
+#include "townk_socd.h"
+
+#include "sm_td.h"
+
+extern void mouse_mode(bool on);
+
+bool process_record_townk(uint16_t keycode, keyrecord_t *record) {
+    /* sm_td runs here, manually, instead of as a community module — the module
+     * hook offers no way to shield Repeat Key from it. Since 0.5.6 sm_td
+     * consumes every record and re-resolves it by matrix POSITION; Repeat
+     * Key's replays carry the last keycode but QK_REP's own position, so
+     * sm_td turned every replay back into QK_REP, which Repeat Key's
+     * recursion guard then swallowed — repeat produced nothing at all.
+     * get_repeat_key_count() is nonzero exactly while a replayed record is
+     * in flight; letting those records pass sm_td untouched makes them
+     * register natively, as they did before 0.5.6.
+     *
+     * Order matters: sm_td must run before the handlers below so that real
+     * presses are consumed here (as the module used to) and the ESC hook and
+     * mouse-keys engine keep seeing only sm_td's emulated replays.
+     *
+     * Latency, the typing streak and the use of an SM_TD hold are stamped
+     * before all of it: this is the only time the record carries the matrix
+     * time, and sm_td's delay is part of what is measured.
+     *
+     * Game mode comes first of all: on _GAM1/_GAM2 a key is its keycode, and
+     * nothing here may delay it or change it. Only the SOCD pairs are looked
+     * at, so that opposite directions are never held together. */
+    if (game_mode_fast_path(record)) {
+        return process_socd(keycode, record);
+    }
+    latency_mark(keycode, record);
+    smtd_streak_record(record);
+    smtd_timing_record(record);
+    if (get_repeat_key_count() == 0 && !process_smtd(keycode, record)) {
+        return false;
+    }
+    if (keycode == KC_ESC) {
+        mouse_mode(false);
+    }
+    if (!process_special_mouse_keys(keycode, record)) {
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,49 @@
+/* Copyright (C) 2025 Thiago Alves (https://github.com/townk)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * @file townk_record.h
+ * @brief The userspace's key event pipeline, in the order it must run
+ *
+ * process_record_user() is one call to process_record_townk(). The order of
+ * the stages is what matters -- game mode, then the latency and streak
+ * stamps, then sm_td, then Escape and the MB_* keys -- and keeping it here,
+ * out of the keymap, is what lets the host fuzz target and benchmark run the
+ * same sequence the board does.
+ *
+ * @author Thiago Alves
+ */
+
+#ifndef QMK_USERSPACE_TOWNK_RECORD_H
+#define QMK_USERSPACE_TOWNK_RECORD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "action.h"
+
+/**
+ * @brief Run one key event through every userspace stage
+ *
+ * @param keycode The keycode that was pressed or released
+ * @param record The key event
+ * @return process_record_user()'s answer: true to let QMK process the key,
+ *         false if a stage handled it
+ */
+bool process_record_townk(uint16_t keycode, keyrecord_t *record);
+
+#endif // QMK_USERSPACE_TOWNK_RECORD_H
@@ -0,0 +1,56 @@
+/* Copyright (C) 2025 Thiago Alves (https://github.com/townk)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file townk_sm_td.c
+ * @brief sm_td, built with its keycode lookup resolved through the keycode cache
+ *
+ * smtd_current_keycode() asks keymap_key_to_keycode() for the key on
+ * get_highest_layer(layer_state) alone, so a _______ there gives it
+ * KC_TRANSPARENT. sm_td is compiled here, rather than listed in SRC on its
+ * own, so that call can be sent to keycache_layer_keycode(), which answers
+ * for that layer with the transparency-resolved keycode (townk_keycache.h).
+ *
+ * The same goes for process_record(), which sm_td feeds its replayed
+ * records through: each call is bracketed by smtd_replay_begin()/smtd_replay_end()
+ * (townk_smtd.h), so process_record_user() can tell a replay from the
+ * original matrix record. Nothing else in sm_td changes, and sm_td.c itself
+ * is not touched.
+ *
+ * QMK's headers are included first, so the declaration of
+ * keymap_key_to_keycode() and process_record() is already seen when the
+ * macros come in, and only the calls in sm_td.c are renamed.
+ *
+ * @author Thiago Alves
+ */
+
+#include QMK_KEYBOARD_H
+#include "keymap_common.h"
+
+#include "townk_keycache.h"
+#include "townk_smtd.h"
+
+/** process_record(), for a record sm_td replays. */
+static void townk_sm_td_process_record(keyrecord_t *record) {
+    smtd_replay_begin();
+    process_record(record);
+    smtd_replay_end();
+}
+
+#define keymap_key_to_keycode(layer, key) keycache_layer_keycode((layer), (key))
+#define process_record(record) townk_sm_td_process_record(record)
+
+#include "sm_td.c"
@@ -21,9 +21,16 @@
 
 #include "keycodes.h"
 #include "modifiers.h"
+#include "progmem.h"
+#include "timer.h"
+#include "townk_latency.h"
 #include "townk_layers.h"
+#include "townk_eeconfig.h"
 #include "townk_keycodes.h"
+#include "townk_mods.h"
 #include "townk_mouse.h"
+#include "townk_smtd.h"
+#include "townk_trace.h"
 
 #include "sm_td.h"
 
@@ -88,93 +95,6 @@ extern void mouse_mode(bool on);
     BREAK_CAPS_WORD(tap_key);           \
     mouse_mode(false)
 
-/* SM_TD 0.6.2 deleted LAYER_PUSH/LAYER_RESTORE in favour of plain
- * layer_on()/layer_off() (its SMTD_LT now adds and removes the hold layer
- * additively). CUSTOM_LT relies on the old move-and-restore semantics --
- * layer_move() REPLACES the layer state and the refcount restores whatever
- * was highest at push time -- and switching it to the additive model would
- * change how nested layer-tap holds resolve. Vendored here verbatim from
- * the last SM_TD version that shipped them (v0.6.1), so the upgrade does
- * not change behaviour. 13 is safe as the not-set sentinel: layers 9-13
- * are unused in this keymap (see townk_layers.h). */
-#define RETURN_LAYER_NOT_SET 13
-
-static uint8_t smtd_return_layer     = RETURN_LAYER_NOT_SET;
-static uint8_t smtd_return_layer_cnt = 0;
-
-#define LAYER_PUSH(layer)                                   \
-    smtd_return_layer_cnt++;                                \
-    if (smtd_return_layer == RETURN_LAYER_NOT_SET) {        \
-        smtd_return_layer = get_highest_layer(layer_state); \
-    }                                                       \
-    layer_move(layer)
-
-#define LAYER_RESTORE()                               \
-    if (smtd_return_layer_cnt > 0) {                  \
-        smtd_return_layer_cnt--;                      \
-        if (smtd_return_layer_cnt == 0) {             \
-            layer_move(smtd_return_layer);            \
-            smtd_return_layer = RETURN_LAYER_NOT_SET; \
-        }                                             \
-    }
-
-/**
- * @brief Creates a custom Layer-Tap behavior using the SM_TD dance system.
- *
- * This macro defines a tap-dance behavior where:
- * - Tap: Sends the tap_key using CUSTOM_TAP
- * - Hold: Activates the specified layer and registers the tap_key as held
- * - Release: Restores the previous layer and untaps the key
- * - Double tap and hold: Registers the tap_key as being held down
- *
- * The layer activation is limited to 1 occurrence per hold, and mouse mode
- * is disabled when the layer is activated.
- *
- * @param macro_key The custom keycode that triggers this dance behavior.
- * @param tap_key The keycode to send on tap or register on hold.
- * @param layer The layer to activate when the key is held.
- *
- * @note This creates a complete SMTD_DANCE with proper press/release handling.
- */
-#define CUSTOM_LT(macro_key, tap_key, layer)                 \
-    SMTD_DANCE(macro_key,                                    \
-               NOTHING,                                      \
-               CUSTOM_TAP(tap_key),                          \
-               SMTD_LIMIT(1,                                 \
-                          mouse_mode(false);                 \
-                          LAYER_PUSH(layer),                 \
-                          SMTD_REGISTER_16(false, tap_key)), \
-               SMTD_LIMIT(1,                                 \
-                          LAYER_RESTORE(),                   \
-                          CUSTOM_UNTAP(tap_key));            \
-    )
-
-/**
- * @brief Creates a smart shift behavior with Caps Word integration.
- *
- * This macro defines a tap-dance behavior for an intelligent shift key:
- * - Double tap OR tap while shift is already held: Activates Caps Word mode
- * - Single tap: Sets one-shot shift modifier (next key only)
- * - Hold: Registers as a standard left shift modifier
- * - Release: Unregisters the shift modifier
- *
- * This provides a more ergonomic typing experience by reducing the need to
- * hold shift for capitalization.
- *
- * @param macro_key The custom keycode that triggers this dance behavior.
- *
- * @note Requires NO_ACTION_ONESHOT to NOT be defined for full functionality.
- */
-#define SMART_SHIFT(macro_key)                          \
-    SMTD_DANCE(macro_key,                               \
-               NOTHING,                                 \
-               (tap_count > 0 || mods & MOD_MASK_SHIFT) \
-                   ? caps_word_on()                     \
-                   : set_oneshot_mods(MOD_LSFT),        \
-               register_mods(MOD_BIT(KC_LSFT)),         \
-               unregister_mods(MOD_BIT(KC_LSFT))        \
-    )
-
 /**
  * @brief Conditionally executes different actions based on shift modifier
  *        state.
@@ -205,14 +125,15 @@ static uint8_t smtd_return_layer_cnt = 0;
  *       shift bits that were held; 0 when the shift was purely one-shot
  *       (register_mods(0) is a no-op, so restoring is unconditional).
  */
-#define SHIFT_ACTION(normal_action, shift_action)       \
-    if (mods & MOD_MASK_SHIFT) {                        \
-        shift_mod = get_mods() & MOD_MASK_SHIFT;        \
-        unregister_mods(MOD_MASK_SHIFT);                \
-        clear_oneshot_mods();                           \
-        normal_action;                                  \
-    } else {                                            \
-        shift_action;                                   \
+#define SHIFT_ACTION(normal_action, shift_action)         \
+    if (mods & MOD_MASK_SHIFT) {                          \
+        shift_mod         = get_mods() & MOD_MASK_SHIFT;  \
+        shift_mod_claimed = smtd_claimed_mods(shift_mod); \
+        unregister_mods(MOD_MASK_SHIFT);                  \
+        clear_oneshot_mods();                             \
+        normal_action;                                    \
+    } else {                                              \
+        shift_action;                                     \
     }
 
 /**
@@ -267,7 +188,11 @@ static uint8_t smtd_return_layer_cnt = 0;
  *
  * This macro releases the key that was registered by SHIFT_REGISTER:
  * - If delkey_registered is true: Unregisters normal_key, re-registers shift
- *   modifier, and clears the delkey_registered flag
+ *   modifier, and clears the delkey_registered flag. A Shift held through a
+ *   townk_mods.c claim (an MB_* key, Smart Shift) comes back only if it is
+ *   still claimed: released during the hold, its owner gave the claim up
+ *   while the bit was already off, and restoring it would leave a Shift no
+ *   key release ever clears.
  * - If delkey_registered is false: Unregisters shift_key
  *
  * This ensures proper cleanup and modifier state restoration when releasing
@@ -279,136 +204,634 @@ static uint8_t smtd_return_layer_cnt = 0;
  * @note Must be paired with SHIFT_REGISTER. Requires static bool
  *       delkey_registered and static uint8_t shift_mod variables in scope.
  */
-#define SHIFT_UNREGISTER(normal_key, shift_key)       \
-    if (delkey_registered) {                          \
-        delkey_registered = false;                    \
-        SMTD_UNREGISTER_16(false, normal_key);        \
-        register_mods(shift_mod);                     \
-    } else {                                          \
-        SMTD_UNREGISTER_16(false, shift_key);         \
+#define SHIFT_UNREGISTER(normal_key, shift_key)                                                 \
+    if (delkey_registered) {                                                                    \
+        delkey_registered = false;                                                              \
+        SMTD_UNREGISTER_16(false, normal_key);                                                  \
+        register_mods((shift_mod & ~shift_mod_claimed) | smtd_claimed_mods(shift_mod_claimed)); \
+    } else {                                                                                    \
+        SMTD_UNREGISTER_16(false, shift_key);                                                   \
     }
 
+
+/** @brief The behaviours a SM_TD key in smtd_keys[] can have */
+typedef enum {
+    SMTD_KIND_NONE = 0,           ///< Not an SM_TD key: left to other handlers
+    SMTD_KIND_LAYER_TAP,          ///< Key on tap, layer (moved to) on hold
+    SMTD_KIND_SHIFTED_LAYER_TAP,  ///< As above, shift-inverted, layer added on hold
+    SMTD_KIND_SMART_SHIFT,        ///< One-shot Shift, Shift, or Caps Word
+} smtd_kind_t;
+
+/** @brief One SM_TD key: what it sends, and what it switches to */
+typedef struct {
+    uint16_t key;       ///< Sent on tap, or held on tap-then-hold
+    uint16_t shift_key; ///< Sent instead, Shift lifted, while Shift is held
+    uint8_t  layer;     ///< Layer the hold switches to
+    uint8_t  kind;      ///< smtd_kind_t
+} smtd_key_t;
+
 /**
- * @note Uses layer_on()/layer_off() rather than SM_TD's LAYER_PUSH/
- *       LAYER_RESTORE, and deliberately does NOT call mouse_mode(false) when
- *       the layer goes up. Both of those removed the auto-mouse layer:
- *       mouse_mode(false) turns it off directly, and LAYER_PUSH is
- *       layer_move(), which REPLACES the layer state instead of adding to it.
- *       Either one alone meant that while this key was held there were no MB_*
- *       keys on any active layer -- so the key could not contribute Option to a
- *       click, because no click was reachable to contribute to. Adding the
- *       layer keeps the mouse layer underneath, where MB_* stays clickable.
- *       Tapping for Backspace still exits mouse mode, which is where "I am
- *       typing now" is actually evidenced.
- *
- * @brief Creates a shift-aware Layer-Tap behavior with inverted shift logic.
- *
- * This macro combines layer-tap functionality with shift-inverted key behavior:
- * - Single tap with shift held: Sends normal_key (without shift), then
- *   re-applies shift
- * - Single tap without shift: Sends shifted_key
- * - Hold: Activates the specified layer and registers the appropriate key
- *   based on shift state
- * - Release: Restores the previous layer and unregisters the held key
- *
- * This is particularly useful for keys like Backspace/Delete where you want:
- * - Normal press: Delete
- * - Shift + press: Backspace
- * - Hold: Activate navigation layer
- *
- * The layer activation is limited to 1 occurrence per hold, and mouse mode
- * is disabled during layer activation and tap actions.
- *
- * @param macro_key The custom keycode that triggers this dance behavior.
- * @param normal_key The keycode to use when shift is held (sent/registered
- *        without shift).
- * @param shifted_key The keycode to use when shift is not held.
- * @param layer The layer to activate when the key is held.
+ * @brief Every SM_TD key, indexed by its offset from RANGE_START
  *
- * @note Requires static bool delkey_registered and static uint8_t shift_mod
- *       variables in scope. Creates a complete SMTD_DANCE with proper state
- *       management.
+ * Adding a layer-tap is one line here plus its keycode in townk_keycodes.h;
+ * the handlers below are shared, so it costs six bytes of flash and nothing
+ * at run time.
+ *
+ * **CKC_BSPC** is shift-inverted: Backspace on tap, Delete on Shift+tap (the
+ * Shift is lifted for it and put back afterwards), _NAV on hold.
+ * **CKC_SMSFT** is Smart Shift: one-shot Shift on tap, Caps Word on a double
+ * tap or a tap while Shift is held, plain Shift on hold.
  */
-#define SHIFTED_LT(macro_key, normal_key, shifted_key, layer)        \
-    SMTD_DANCE(macro_key,                                            \
-               NOTHING,                                              \
-               SHIFT_TAP(normal_key, shifted_key);                   \
-               mouse_mode(false),                                    \
-               SMTD_LIMIT(1,                                         \
-                          layer_on(layer),                           \
-                          SHIFT_REGISTER(normal_key, shifted_key)),  \
-               SMTD_LIMIT(1,                                         \
-                          layer_off(layer),                          \
-                          SHIFT_UNREGISTER(normal_key, shifted_key); \
-                          mouse_mode(false)))
+static const smtd_key_t PROGMEM smtd_keys[] = {
+    [CKC_BSPC - RANGE_START]  = {KC_BSPC, KC_DEL, _NAV, SMTD_KIND_SHIFTED_LAYER_TAP},
+    [CKC_SPC - RANGE_START]   = {KC_SPC, KC_NO, _NUM, SMTD_KIND_LAYER_TAP},
+    [CKC_TAB - RANGE_START]   = {KC_TAB, KC_NO, _SYM, SMTD_KIND_LAYER_TAP},
+    [CKC_BKTAB - RANGE_START] = {MKC_BKTAB, KC_NO, _FUN, SMTD_KIND_LAYER_TAP},
+    [CKC_SMSFT - RANGE_START] = {KC_NO, KC_NO, 0, SMTD_KIND_SMART_SHIFT},
+};
+
+#define SMTD_KEY_COUNT (sizeof(smtd_keys) / sizeof(smtd_keys[0]))
+
+/* ------------------------------------------------------------------------ *
+ * Layer stack
+ *
+ * A layer-tap hold MOVES to its layer -- it replaces the layer state, as the
+ * LAYER_PUSH/LAYER_RESTORE SM_TD 0.6.1 shipped did -- and its release puts
+ * back what was there before. Each hold pushes one entry: which layer bits it
+ * changed and what they were. A release restores exactly those bits, leaving
+ * alone any layer that came or went in the meantime (the auto-mouse layer,
+ * say), in one layer_state_set(), and only if that changes anything.
+ *
+ * Holds may be released in any order. Releasing one that is not on top
+ * changes nothing yet: the hold above it still owns the state, so it takes
+ * over the entry's bits and what they were, and restores both on its own
+ * release. Every smtd_keys[] entry holds at most once at a time, so
+ * SMTD_KEY_COUNT entries never overflow.
+ *
+ * A shifted layer-tap adds its layer instead, with layer_on(), beside the
+ * stack. A hold pushed over it saves that layer as part of what it replaced,
+ * so turning it off must also clear it from every saved state, or the
+ * release of that hold would bring it back with nothing holding it.
+ * ------------------------------------------------------------------------ */
+
+/** One hold's change to the layer state. */
+typedef struct {
+    layer_state_t changed; ///< The bits the hold flipped
+    layer_state_t before;  ///< Their values before it
+    uint8_t       owner;   ///< The smtd_keys[] index holding
+} smtd_layer_entry_t;
+
+/** @private */
+static smtd_layer_entry_t smtd_layer_stack[SMTD_KEY_COUNT];
+/** @private */
+static uint8_t smtd_layer_depth = 0;
 
 /**
- * @brief SM_TD library callback for handling custom tap-dance behaviors.
+ * @brief Hand the layer state to QMK, if it is news
+ * @private
+ */
+static void smtd_layer_apply(layer_state_t state) {
+    if (state != layer_state) {
+        layer_state_set(state);
+    }
+}
+
+/**
+ * @brief Remove the entry at @p at, restoring its bits if it was on top
+ * @private
+ */
+static void smtd_layer_remove(uint8_t at) {
+    smtd_layer_entry_t entry = smtd_layer_stack[at];
+
+    if (at + 1 == smtd_layer_depth) {
+        smtd_layer_depth--;
+        smtd_layer_apply((layer_state & ~entry.changed) | (entry.before & entry.changed));
+        return;
+    }
+
+    // The hold above inherits this one's bits, so its release undoes both.
+    smtd_layer_entry_t *above = &smtd_layer_stack[at + 1];
+    above->before  = (above->before & ~entry.changed) | (entry.before & entry.changed);
+    above->changed |= entry.changed;
+    for (uint8_t i = at; i + 1 < smtd_layer_depth; i++) {
+        smtd_layer_stack[i] = smtd_layer_stack[i + 1];
+    }
+    smtd_layer_depth--;
+}
+
+/**
+ * @brief Move to @p layer for as long as smtd_keys[@p owner] is held
+ * @private
+ */
+static void smtd_layer_push(uint8_t owner, uint8_t layer) {
+    // A second hold without a release in between replaces the first.
+    for (uint8_t i = 0; i < smtd_layer_depth; i++) {
+        if (smtd_layer_stack[i].owner == owner) {
+            smtd_layer_remove(i);
+            break;
+        }
+    }
+
+    layer_state_t target                = (layer_state_t)1 << layer;
+    smtd_layer_stack[smtd_layer_depth++] = (smtd_layer_entry_t){
+        .changed = layer_state ^ target,
+        .before  = layer_state,
+        .owner   = owner,
+    };
+    smtd_layer_apply(target);
+}
+
+/**
+ * @brief Undo smtd_keys[@p owner]'s hold; nothing if it holds no layer
+ * @private
+ */
+static void smtd_layer_pop(uint8_t owner) {
+    for (uint8_t i = smtd_layer_depth; i-- > 0;) {
+        if (smtd_layer_stack[i].owner == owner) {
+            smtd_layer_remove(i);
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Turn @p layer off, and out of every state a release will restore
+ * @private
+ */
+static void smtd_layer_off(uint8_t layer) {
+    layer_state_t bit = (layer_state_t)1 << layer;
+    for (uint8_t i = 0; i < smtd_layer_depth; i++) {
+        smtd_layer_stack[i].before &= ~bit;
+    }
+    layer_off(layer);
+}
+
+/**
+ * Shift-inverted key state, shared by every SMTD_KIND_SHIFTED_LAYER_TAP key.
+ * - `delkey_registered`: whether a hold registered the shift_key, so the
+ *   release unregisters that one and restores Shift.
+ * - `shift_mod`: the Shift bits that were really held when Shift was lifted,
+ *   to be re-registered afterwards.
+ * - `shift_mod_claimed`: which of those were held through a townk_mods.c
+ *   claim rather than registered directly.
+ */
+static bool    delkey_registered = false;
+static uint8_t shift_mod         = 0;
+static uint8_t shift_mod_claimed = 0;
+
+/**
+ * @brief The bits of @p mask someone holds a townk_mods.c claim on
+ * @private
+ */
+static uint8_t smtd_claimed_mods(uint8_t mask) {
+    return mask & mods_owned();
+}
+
+/**
+ * @brief A plain layer-tap: key on tap, layer on hold
  *
- * This function is the main entry point for the SM_TD (State Machine Tap
- * Dance) library. It gets called whenever a custom keycode defined in this
- * implementation is pressed, held, or released. The function dispatches to the
- * appropriate macro handler based on the keycode.
+ * - Tap: Sends the key, breaking Caps Word unless it is a word character, and
+ *   leaves mouse mode
+ * - Hold: Leaves mouse mode and moves to the layer (smtd_layer_push())
+ * - Release: Restores the layers the hold replaced
+ * - Tap then hold: Holds the key down instead
  *
- * The function maintains state across invocations using static variables to
- * support shift-inverted key behaviors and proper modifier state tracking.
+ * @private
+ */
+static void smtd_layer_tap(uint8_t index, const smtd_key_t *key, smtd_action action, uint8_t tap_count) {
+    switch (action) {
+        case SMTD_ACTION_TAP:
+            CUSTOM_TAP(key->key);
+            break;
+        case SMTD_ACTION_HOLD:
+            SMTD_LIMIT(1,
+                       mouse_mode(false);
+                       smtd_layer_push(index, key->layer),
+                       SMTD_REGISTER_16(false, key->key));
+            break;
+        case SMTD_ACTION_RELEASE:
+            SMTD_LIMIT(1,
+                       smtd_layer_pop(index),
+                       CUSTOM_UNTAP(key->key));
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief A shift-inverted layer-tap: key on tap, shift_key on Shift+tap
+ *
+ * - Tap with Shift held: Sends shift_key without Shift, then re-applies Shift
+ * - Tap without Shift: Sends key
+ * - Hold: Adds the layer
+ * - Release: Removes the layer
+ * - Tap then hold: Holds whichever key the Shift state picks, instead
+ *
+ * Mouse mode is left on a tap and on a release, not when the layer goes up.
+ *
+ * @note Adds its layer with layer_on() rather than pushing it on the layer
+ *       stack, and deliberately does NOT call mouse_mode(false) when the
+ *       layer goes up. Both of those removed the auto-mouse layer: mouse_mode(false) turns
+ *       it off directly, and smtd_layer_push() moves to its layer, which
+ *       REPLACES the layer state instead of adding to it. Either one alone
+ *       meant that while this key was held there were no MB_* keys on any
+ *       active layer -- so the key could not contribute Option to a click,
+ *       because no click was reachable to contribute to. Adding the layer
+ *       keeps the mouse layer underneath, where MB_* stays clickable. Tapping
+ *       for Backspace still exits mouse mode, which is where "I am typing
+ *       now" is actually evidenced.
+ *
+ * @private
+ */
+static void smtd_shifted_layer_tap(const smtd_key_t *key, smtd_action action, uint8_t tap_count, uint8_t mods) {
+    switch (action) {
+        case SMTD_ACTION_TAP:
+            SHIFT_TAP(key->shift_key, key->key);
+            mouse_mode(false);
+            break;
+        case SMTD_ACTION_HOLD:
+            SMTD_LIMIT(1,
+                       layer_on(key->layer),
+                       SHIFT_REGISTER(key->shift_key, key->key));
+            break;
+        case SMTD_ACTION_RELEASE:
+            SMTD_LIMIT(1,
+                       smtd_layer_off(key->layer),
+                       SHIFT_UNREGISTER(key->shift_key, key->key);
+                       mouse_mode(false));
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Smart Shift, with Caps Word integration
  *
- * ### Implemented Keycodes:
+ * - Double tap OR tap while shift is already held: Activates Caps Word mode
+ * - Single tap: Sets one-shot shift modifier (next key only)
+ * - Hold: Claims left Shift through townk_mods.c, so another Shift holder
+ *   (MB_SFT, a home-row mod) releasing first does not drop it
+ * - Release: Releases that claim
  *
- * **CKC_TAB** - Layer-tap with Tab key:
- * - Tap: Sends Tab key
- * - Hold: Activates Symbol layer (_SYM)
+ * @note Requires NO_ACTION_ONESHOT to NOT be defined for full functionality.
  *
- * **CKC_BKTAB** - Layer-tap with Shift+Tab:
- * - Tap: Sends Shift+Tab (back tab)
- * - Hold: Activates Function layer (_FUN)
+ * @private
+ */
+static void smtd_smart_shift(smtd_action action, uint8_t tap_count, uint8_t mods) {
+    switch (action) {
+        case SMTD_ACTION_TAP:
+            if (tap_count > 0 || mods & MOD_MASK_SHIFT) {
+                caps_word_on();
+            } else {
+                set_oneshot_mods(MOD_LSFT);
+            }
+            break;
+        case SMTD_ACTION_HOLD:
+            mods_acquire(MOD_BIT(KC_LSFT));
+            break;
+        case SMTD_ACTION_RELEASE:
+            mods_release(MOD_BIT(KC_LSFT));
+            break;
+        default:
+            break;
+    }
+}
+
+#ifndef SMTD_ADAPTIVE_DISABLE
+/* ------------------------------------------------------------------------ *
+ * Adaptive tap term
+ *
+ * How long a key must be held before it counts as a hold is a per-key
+ * property: Space is held for the numbers layer often and tapped at leisure,
+ * Backspace is tapped in quick bursts. So each key in smtd_keys[] keeps a
+ * running mean and mean absolute deviation of how long its taps and its holds
+ * last (fixed point, exponentially weighted), and get_smtd_timeout() answers
+ * its SMTD_TIMEOUT_TAP with the shortest term that still clears nearly all
+ * of its taps. SMTD_ADAPTIVE_DISABLE turns it off, leaving every key on
+ * SMTD_GLOBAL_TAP_TERM.
+ *
+ * A hold is timed to the first other press while it is down, the moment it
+ * was put to use, not to its release: a hold is only a hold once the term
+ * has passed, so its release could never say the term is too long. A hold
+ * nothing was pressed under says nothing and is not sampled.
+ *
+ * The sequence and release terms stay global. Neither delays a key: sm_td
+ * sends a tap on its release and a hold at the tap term, and those two only
+ * decide what a re-press or a roll means. Shortening them buys no latency,
+ * and their samples -- the gap before a re-press, the overlap of a roll --
+ * come out the same whichever way the user meant them, so there is nothing
+ * to tell a misfire by.
+ * ------------------------------------------------------------------------ */
+
+/** Bounds on a learned tap term, in ms. */
+#ifndef SMTD_ADAPTIVE_MIN_TERM
+#    define SMTD_ADAPTIVE_MIN_TERM 120
+#endif
+#ifndef SMTD_ADAPTIVE_MAX_TERM
+#    define SMTD_ADAPTIVE_MAX_TERM 300
+#endif
+
+/** Taps a key must have seen before its term is learned rather than global. */
+#ifndef SMTD_ADAPTIVE_MIN_SAMPLES
+#    define SMTD_ADAPTIVE_MIN_SAMPLES 16
+#endif
+
+/** How many deviations above the mean tap the term sits. */
+#ifndef SMTD_ADAPTIVE_TAP_MARGIN
+#    define SMTD_ADAPTIVE_TAP_MARGIN 3
+#endif
+
+/** How many deviations below the mean hold a hold still counts as typical. */
+#ifndef SMTD_ADAPTIVE_HOLD_MARGIN
+#    define SMTD_ADAPTIVE_HOLD_MARGIN 2
+#endif
+
+/** A learned term is saved again once it has moved this many ms. */
+#ifndef SMTD_ADAPTIVE_SAVE_STEP
+#    define SMTD_ADAPTIVE_SAVE_STEP 8
+#endif
+
+/** Fixed point of the statistics: ms << SMTD_TIMING_SHIFT. */
+#define SMTD_TIMING_SHIFT 4
+/** Each sample moves the statistics 1/2^SMTD_TIMING_RATE of the way. */
+#define SMTD_TIMING_RATE 3
+/** Longer samples are taken as this, so a key held for a minute is just "long". */
+#define SMTD_TIMING_SAMPLE_MAX 1000
+
+_Static_assert(SMTD_KEY_COUNT <= TOWNK_EECONFIG_SMTD_KEYS, "smtd_keys[] outgrew the saved timing");
+_Static_assert(SMTD_TIMING_SAMPLE_MAX << SMTD_TIMING_SHIFT <= UINT16_MAX, "timing statistics overflow");
+
+/** One key's learning state. */
+typedef struct {
+    townk_smtd_timing_t stats;      ///< What is learned, and saved
+    uint32_t            pressed_at; ///< timer_read32() at the touch
+    uint32_t            used_at;    ///< timer_read32() at the first other press while down
+    uint16_t            saved_term; ///< The term when stats were last saved
+    uint8_t             taps;       ///< Taps seen, up to SMTD_ADAPTIVE_MIN_SAMPLES
+    bool                down;       ///< Touched and not yet tapped or released
+    bool                used;       ///< Another key was pressed while down
+    bool                held;       ///< The press became a hold
+} smtd_timing_state_t;
+
+/** @private */
+static smtd_timing_state_t smtd_timing[SMTD_KEY_COUNT] = {0};
+/** @private */
+static bool smtd_timing_loaded = false;
+
+/**
+ * @brief Seed every key from what townk_eeconfig.c saved, once
  *
- * **CKC_SPC** - Layer-tap with Space key:
- * - Tap: Sends Space
- * - Hold: Activates Number layer (_NUM)
+ * Lazily, on the first SM_TD event: townk_eeconfig_init() runs in
+ * keyboard_post_init_user(), long before any key can be pressed.
+ * @private
+ */
+static void smtd_timing_load(void) {
+    if (smtd_timing_loaded) {
+        return;
+    }
+    smtd_timing_loaded = true;
+
+    for (uint8_t i = 0; i < SMTD_KEY_COUNT; i++) {
+        if (townk_eeconfig_smtd_timing(i, &smtd_timing[i].stats)) {
+            smtd_timing[i].taps = SMTD_ADAPTIVE_MIN_SAMPLES;
+        }
+    }
+}
+
+/**
+ * @brief Fold one sample into a running mean and mean absolute deviation
+ * @private
+ */
+static void smtd_timing_sample(uint16_t *mean, uint16_t *dev, uint32_t elapsed) {
+    if (elapsed > SMTD_TIMING_SAMPLE_MAX) {
+        elapsed = SMTD_TIMING_SAMPLE_MAX;
+    }
+    int32_t x = (int32_t)elapsed << SMTD_TIMING_SHIFT;
+
+    if (*mean == 0) {
+        // The first sample: a quarter of itself is a cautious first guess at
+        // the spread, and decays as real samples come in.
+        *mean = x > 0 ? x : 1;
+        *dev  = x / 4;
+        return;
+    }
+
+    int32_t error = x - *mean;
+    *mean += error / (1 << SMTD_TIMING_RATE);
+    *dev += ((error < 0 ? -error : error) - *dev) / (1 << SMTD_TIMING_RATE);
+}
+
+/**
+ * @brief The tap term a key's statistics call for, in ms
  *
- * **CKC_BSPC** - Shift-aware Layer-tap with Delete/Backspace:
- * - Tap (no shift): Sends Delete
- * - Tap (with shift): Sends Backspace
- * - Hold: Activates Navigation layer (_NAV)
- * - This uses inverted shift logic for ergonomic Delete/Backspace access
+ * Just above nearly every tap: the mean plus SMTD_ADAPTIVE_TAP_MARGIN
+ * deviations. If that reaches into the key's typical holds, split the
+ * difference rather than misread either.
+ * @return 0 while the key has too few taps to say
+ * @private
+ */
+static uint16_t smtd_timing_term(const smtd_timing_state_t *state) {
+    if (state->taps < SMTD_ADAPTIVE_MIN_SAMPLES) {
+        return 0;
+    }
+
+    const townk_smtd_timing_t *s = &state->stats;
+
+    int32_t term = s->tap_mean + SMTD_ADAPTIVE_TAP_MARGIN * s->tap_dev;
+    if (s->hold_mean != 0) {
+        int32_t hold = s->hold_mean - SMTD_ADAPTIVE_HOLD_MARGIN * s->hold_dev;
+        if (hold < term) {
+            term = (term + hold) / 2;
+        }
+    }
+    term >>= SMTD_TIMING_SHIFT;
+
+    if (term < SMTD_ADAPTIVE_MIN_TERM) return SMTD_ADAPTIVE_MIN_TERM;
+    if (term > SMTD_ADAPTIVE_MAX_TERM) return SMTD_ADAPTIVE_MAX_TERM;
+    return term;
+}
+
+/**
+ * @brief Learn from one SM_TD action on the key at @p index in smtd_keys[]
  *
- * **CKC_SMART_SFT** - Smart Shift key:
- * - Single tap: One-shot shift (next key only)
- * - Double tap OR tap while shift held: Activates Caps Word
- * - Hold: Standard shift modifier
+ * The touch starts the clock; a tap is a tap sample; a hold is a hold sample,
+ * up to its first use (see smtd_timing_record()), when it is released. The statistics are handed to townk_eeconfig.c only
+ * when the term they produce has moved by SMTD_ADAPTIVE_SAVE_STEP, so normal
+ * typing does not keep the EEPROM dirty.
+ * @private
+ */
+static void smtd_timing_observe(uint16_t index, smtd_action action) {
+    smtd_timing_state_t *state = &smtd_timing[index];
+    uint32_t             now   = timer_read32();
+
+    smtd_timing_load();
+
+    switch (action) {
+        case SMTD_ACTION_TOUCH:
+            state->pressed_at = now;
+            state->down       = true;
+            state->used       = false;
+            state->held       = false;
+            return;
+        case SMTD_ACTION_TAP:
+            state->down = false;
+            smtd_timing_sample(&state->stats.tap_mean, &state->stats.tap_dev, now - state->pressed_at);
+            if (state->taps < SMTD_ADAPTIVE_MIN_SAMPLES) {
+                state->taps++;
+            }
+            break;
+        case SMTD_ACTION_HOLD:
+            state->held = true;
+            return;
+        case SMTD_ACTION_RELEASE:
+            state->down = false;
+            if (!state->held || !state->used) {
+                state->held = false;
+                return;
+            }
+            state->held = false;
+            smtd_timing_sample(&state->stats.hold_mean, &state->stats.hold_dev, state->used_at - state->pressed_at);
+            break;
+    }
+
+    uint16_t term = smtd_timing_term(state);
+    if (term != 0 && (term >= state->saved_term + SMTD_ADAPTIVE_SAVE_STEP || term + SMTD_ADAPTIVE_SAVE_STEP <= state->saved_term)) {
+        townk_eeconfig_set_smtd_timing(index, &state->stats);
+        state->saved_term = term;
+    }
+}
+
+void smtd_timing_record(const keyrecord_t *record) {
+    if (!record->event.pressed || smtd_replaying()) {
+        return;
+    }
+
+    uint32_t now = timer_read32();
+    for (uint8_t i = 0; i < SMTD_KEY_COUNT; i++) {
+        smtd_timing_state_t *state = &smtd_timing[i];
+        if (state->down && !state->used) {
+            state->used    = true;
+            state->used_at = now;
+        }
+    }
+}
+#endif // SMTD_ADAPTIVE_DISABLE
+
+/* How many of sm_td's replays are in progress: a replay can set off
+ * another, as when a resolved layer-tap releases the keys it held back. */
+static uint8_t smtd_replay_depth = 0;
+
+bool smtd_replaying(void) {
+    return smtd_replay_depth != 0;
+}
+
+void smtd_replay_begin(void) {
+    smtd_replay_depth++;
+}
+
+void smtd_replay_end(void) {
+    if (smtd_replay_depth != 0) {
+        smtd_replay_depth--;
+    }
+}
+
+#ifndef SMTD_STREAK_DISABLE
+/* ------------------------------------------------------------------------ *
+ * Typing streak
+ *
+ * In the middle of fast prose a layer-tap is a tap: nobody reaches for the
+ * numbers layer 100 ms after the last letter. Yet SM_TD holds the space back
+ * until the tap is certain. So process_record_user() feeds every press to
+ * smtd_streak_record(), and a layer-tap pressed while presses keep coming
+ * less than SMTD_STREAK_INTERVAL_MS apart -- its own press included -- is sent
+ * as a tap on the spot, skipping hold resolution. A pause of
+ * SMTD_STREAK_IDLE_MS ends the streak; a hold is still a hold after any pause
+ * longer than the interval. SMTD_STREAK_DISABLE turns it off.
+ * ------------------------------------------------------------------------ */
+
+/** Presses closer than this, in ms, carry a streak on. */
+#ifndef SMTD_STREAK_INTERVAL_MS
+#    define SMTD_STREAK_INTERVAL_MS 150
+#endif
+
+/** A gap this long, in ms, ends the streak. */
+#ifndef SMTD_STREAK_IDLE_MS
+#    define SMTD_STREAK_IDLE_MS 300
+#endif
+
+/** Quick presses in a row, the layer-tap's own included, before it is fast. */
+#ifndef SMTD_STREAK_MIN_KEYS
+#    define SMTD_STREAK_MIN_KEYS 3
+#endif
+
+_Static_assert(SMTD_STREAK_INTERVAL_MS <= SMTD_STREAK_IDLE_MS, "a streak must survive its own interval");
+_Static_assert(SMTD_KEY_COUNT <= 8, "smtd_streak.fast_keys is a byte");
+
+/** @private */
+static struct {
+    smtd_streak_stats_t stats;
+    uint16_t            last_press; ///< Matrix time of the last press
+    uint8_t             length;     ///< Quick presses in a row
+    bool                active;     ///< The last press was mid-streak
+    uint8_t             fast_keys;  ///< smtd_keys[] entries tapped on touch, by index
+} smtd_streak = {0};
+
+void smtd_streak_record(const keyrecord_t *record) {
+    if (!record->event.pressed || smtd_replaying()) {
+        return;
+    }
+
+    uint16_t gap = record->event.time - smtd_streak.last_press;
+    if (gap >= SMTD_STREAK_IDLE_MS) {
+        smtd_streak.length = 0;
+    } else if (gap < SMTD_STREAK_INTERVAL_MS && smtd_streak.length < UINT8_MAX) {
+        smtd_streak.length++;
+    }
+
+    // length counts gaps, so SMTD_STREAK_MIN_KEYS presses make MIN_KEYS - 1.
+    smtd_streak.active     = gap < SMTD_STREAK_INTERVAL_MS && smtd_streak.length + 1 >= SMTD_STREAK_MIN_KEYS;
+    smtd_streak.last_press = record->event.time;
+}
+
+smtd_streak_stats_t smtd_streak_stats(void) {
+    return smtd_streak.stats;
+}
+
+void smtd_streak_reset_stats(void) {
+    smtd_streak.stats = (smtd_streak_stats_t){0};
+}
+#endif // SMTD_STREAK_DISABLE
+
+/**
+ * @brief SM_TD library callback for handling custom tap-dance behaviors.
+ *
+ * This function is the main entry point for the SM_TD (State Machine Tap
+ * Dance) library. It gets called whenever a custom keycode defined in this
+ * implementation is pressed, held, or released. It looks the keycode up in
+ * smtd_keys[] -- one bounds check and one indexed read, however many keys the
+ * table has -- and hands the entry to the shared handler for its kind.
  *
- * @param keycode The 16-bit custom keycode that triggered this action. This
- *        should be one of the custom keycodes defined in the keymap that use
- *        the macros defined in this file.
+ * @param keycode The 16-bit custom keycode that triggered this action.
  *
  * @param action The SM_TD action type indicating what event occurred (press,
- *        release, tap, hold, etc.). This is used internally by the SMTD_DANCE
- *        macros to determine which behavior to execute.
+ *        release, tap, hold, etc.).
  *
  * @param tap_count The number of times the key has been tapped in quick
- *        succession. Used by behaviors like SMART_SHIFT to differentiate
+ *        succession. Used by behaviors like Smart Shift to differentiate
  *        between single tap and double tap actions.
  *
- * @return smtd_resolution Returns SMTD_RESOLUTION_UNHANDLED to indicate that
- *         if the keycode wasn't handled by any of the defined macros, it
- *         should be processed by other handlers or treated as a standard
- *         keycode. The individual macro expansions may return different
- *         resolution values internally.
- *
- * @note **Static Variables:**
- *       - `delkey_registered`: Tracks whether the "normal" key was registered
- *         during a shift-inverted hold. Used by SHIFT_REGISTER /
- *         SHIFT_UNREGISTER to ensure proper key release and modifier
- *         restoration.
- *       - `shift_mod`: Stores which shift modifier (left or right) was active
- *         when a shift-inverted key was pressed. Used to restore the correct
- *         shift state after the key is released.
+ * @return smtd_resolution SMTD_RESOLUTION_UNCERTAIN on a touch and
+ *         SMTD_RESOLUTION_DETERMINED otherwise for the keys in smtd_keys[],
+ *         as SM_TD's SMTD_DANCE() would -- except that a layer-tap touched
+ *         mid-streak is tapped and DETERMINED at once; SMTD_RESOLUTION_UNHANDLED
+ *         for any other keycode, so it is processed as a standard keycode.
  *
  * @note **Modifier Detection:**
  *       If NO_ACTION_ONESHOT is not defined, the function detects both regular
  *       and one-shot modifiers. Otherwise, only regular modifiers are
- *       detected. This affects the behavior of SMART_SHIFT and shift-inverted
+ *       detected. This affects the behavior of Smart Shift and shift-inverted
  *       keys.
  *
  * @note **Mouse Mode Integration:**
@@ -421,12 +844,11 @@ static uint8_t smtd_return_layer_cnt = 0;
  *          expects this function to exist and will call it for all registered
  *          custom keycodes.
  *
- * @see CUSTOM_LT(), SHIFTED_LT(), SMART_SHIFT() for the macro implementations
+ * @see smtd_keys[] for the keys and what each one does
  * @see sm_td.h for the SM_TD library interface and types
  */
 smtd_resolution on_smtd_action(uint16_t keycode, smtd_action action, uint8_t tap_count) {
-    static bool    delkey_registered = false;
-    static uint8_t shift_mod         = 0;
+    TOWNK_TRACE(TOWNK_TRACE_SMTD_ACTION, action | (tap_count << 4), keycode);
 
     // An SM_TD key being touched is a key press like any other, and must
     // commit a held MB_* key to its modifier role. process_record_user() --
@@ -435,6 +857,57 @@ smtd_resolution on_smtd_action(uint16_t keycode, smtd_action action, uint8_t tap
     // a phantom mouse click. See confirm_pending_modifiers() in townk_mouse.h.
     if (action == SMTD_ACTION_TOUCH) {
         confirm_pending_modifiers(keycode);
+    } else if (action == SMTD_ACTION_TAP) {
+        latency_observe(LATENCY_SMTD_TAP, keycode);
+    } else if (action == SMTD_ACTION_HOLD) {
+        latency_observe(LATENCY_SMTD_HOLD, keycode);
+    }
+
+    // Unsigned, so a keycode below RANGE_START wraps past the end too.
+    uint16_t index = keycode - RANGE_START;
+    if (index >= SMTD_KEY_COUNT) {
+        return SMTD_RESOLUTION_UNHANDLED;
+    }
+
+    smtd_key_t key;
+    memcpy_P(&key, &smtd_keys[index], sizeof(key));
+    if (key.kind == SMTD_KIND_NONE) {
+        return SMTD_RESOLUTION_UNHANDLED;
+    }
+
+    bool fast = false;
+#ifndef SMTD_STREAK_DISABLE
+    const uint8_t bit = 1 << index;
+    if (action == SMTD_ACTION_TOUCH) {
+        smtd_streak.fast_keys &= ~bit;
+        fast = smtd_streak.active && key.kind != SMTD_KIND_SMART_SHIFT;
+        if (fast) {
+            smtd_streak.fast_keys |= bit;
+            smtd_streak.stats.fast++;
+            latency_observe(LATENCY_SMTD_TAP, keycode);
+        }
+    } else if (smtd_streak.fast_keys & bit) {
+        // Answered at the touch; whatever SM_TD still reports of the press
+        // has nothing left to do.
+        if (action == SMTD_ACTION_RELEASE) {
+            smtd_streak.fast_keys &= ~bit;
+        }
+        return SMTD_RESOLUTION_DETERMINED;
+    } else if ((action == SMTD_ACTION_TAP || action == SMTD_ACTION_HOLD) && key.kind != SMTD_KIND_SMART_SHIFT) {
+        smtd_streak.stats.slow++;
+    }
+#endif // SMTD_STREAK_DISABLE
+
+#ifndef SMTD_ADAPTIVE_DISABLE
+    // A fast tap says nothing about how long this key's taps last.
+    if (!fast) {
+        smtd_timing_observe(index, action);
+    }
+#endif
+    if (fast) {
+        action = SMTD_ACTION_TAP;
+    } else if (action == SMTD_ACTION_TOUCH) {
+        return SMTD_RESOLUTION_UNCERTAIN;
     }
 
 #ifndef NO_ACTION_ONESHOT
@@ -443,13 +916,43 @@ smtd_resolution on_smtd_action(uint16_t keycode, smtd_action action, uint8_t tap
     const uint8_t mods = get_mods();
 #endif // NO_ACTION_ONESHOT
 
-    switch (keycode) {
-        CUSTOM_LT(CKC_TAB, KC_TAB, _SYM);
-        CUSTOM_LT(CKC_BKTAB, MKC_BKTAB, _FUN);
-        CUSTOM_LT(CKC_SPC, KC_SPC, _NUM);
-        SHIFTED_LT(CKC_BSPC, KC_DEL, KC_BSPC, _NAV);
-        SMART_SHIFT(CKC_SMSFT);
+    switch (key.kind) {
+        case SMTD_KIND_LAYER_TAP:
+            smtd_layer_tap(index, &key, action, tap_count);
+            break;
+        case SMTD_KIND_SHIFTED_LAYER_TAP:
+            smtd_shifted_layer_tap(&key, action, tap_count, mods);
+            break;
+        case SMTD_KIND_SMART_SHIFT:
+            smtd_smart_shift(action, tap_count, mods);
+            break;
+        default:
+            break;
+    }
+
+    return SMTD_RESOLUTION_DETERMINED;
+}
+
+/**
+ * @brief SM_TD callback for per-key timeouts
+ *
+ * Answers SMTD_TIMEOUT_TAP for the keys in smtd_keys[] with the term each
+ * has learned from its own taps and holds (see smtd_timing_term()), once it
+ * has seen enough of them; everything else, the sequence and release terms
+ * included, gets SM_TD's global default.
+ */
+uint32_t get_smtd_timeout(uint16_t keycode, smtd_timeout timeout) {
+#ifndef SMTD_ADAPTIVE_DISABLE
+    uint16_t index = keycode - RANGE_START;
+    if (timeout == SMTD_TIMEOUT_TAP && index < SMTD_KEY_COUNT) {
+        smtd_timing_load();
+
+        uint16_t term = smtd_timing_term(&smtd_timing[index]);
+        if (term != 0) {
+            return term;
+        }
     }
+#endif // SMTD_ADAPTIVE_DISABLE
 
-    return SMTD_RESOLUTION_UNHANDLED;
+    return get_smtd_timeout_default(timeout);
 }
@@ -0,0 +1,98 @@
+/* Copyright (C) 2025 Thiago Alves (https://github.com/townk)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * @file townk_smtd.h
+ * @brief What townk_smtd.c offers beyond the SM_TD callbacks
+ *
+ * Everything else in townk_smtd.c is reached through SM_TD itself
+ * (on_smtd_action(), get_smtd_timeout()); this is for the hooks SM_TD has no
+ * callback for.
+ *
+ * @author Thiago Alves
+ */
+
+#ifndef QMK_USERSPACE_TOWNK_SMTD_H
+#define QMK_USERSPACE_TOWNK_SMTD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "action.h"
+
+/**
+ * @brief Whether the record being processed is one sm_td is replaying
+ *
+ * sm_td consumes every matrix record and, once it knows what the key was,
+ * feeds it through QMK again: process_record_user() sees each key twice,
+ * the second time with the time of the replay. Anything that counts or
+ * times presses must skip the replays. townk_sm_td.c brackets them with
+ * smtd_replay_begin() and smtd_replay_end().
+ */
+bool smtd_replaying(void);
+
+/** @brief Mark the start of a replayed record; calls nest */
+void smtd_replay_begin(void);
+
+/** @brief Mark the end of a replayed record */
+void smtd_replay_end(void);
+
+#ifndef SMTD_ADAPTIVE_DISABLE
+/**
+ * @brief Feed the adaptive tap term a matrix event
+ *
+ * Call in process_record_user() before process_smtd(), for every key: a
+ * press while an SM_TD key is down is when that key's hold was put to use,
+ * which is what its hold statistics sample. Ignores releases and sm_td's
+ * replays (smtd_replaying()).
+ */
+void smtd_timing_record(const keyrecord_t *record);
+#else
+#    define smtd_timing_record(record) ((void)0)
+#endif // SMTD_ADAPTIVE_DISABLE
+
+#ifndef SMTD_STREAK_DISABLE
+
+/**
+ * @brief How often a layer-tap skipped hold resolution, and how often not
+ */
+typedef struct {
+    uint32_t fast; ///< Presses sent as an immediate tap, mid-streak
+    uint32_t slow; ///< Presses SM_TD resolved the usual way
+} smtd_streak_stats_t;
+
+/**
+ * @brief Feed the typing-streak detector a matrix event
+ *
+ * Call in process_record_user() before process_smtd(), for every key: the
+ * streak is the rhythm of all presses, and only the original record carries
+ * the matrix time. Ignores releases and sm_td's replays (smtd_replaying()),
+ * so each press is counted once.
+ */
+void smtd_streak_record(const keyrecord_t *record);
+
+/** @brief The fast-path counters since the last reset */
+smtd_streak_stats_t smtd_streak_stats(void);
+
+/** @brief Zero the fast-path counters */
+void smtd_streak_reset_stats(void);
+
+#else
+#    define smtd_streak_record(record) ((void)0)
+#endif // SMTD_STREAK_DISABLE
+
+#endif // QMK_USERSPACE_TOWNK_SMTD_H
@@ -0,0 +1,122 @@
+/* Copyright (C) 2025 Thiago Alves (https://github.com/townk)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file townk_socd.c
+ * @brief Opposite-direction key resolution for the game layers -- see townk_socd.h
+ *
+ * @author Thiago Alves
+ */
+
+#include "townk_socd.h"
+
+#ifndef SOCD_DISABLE
+
+#    include "action.h"
+#    include "keycodes.h"
+
+/* The pairs resolved on the game layers, with their policies. Define
+ * SOCD_PAIRS in config.h with the same shape to replace them (adding
+ * {{KC_Q, KC_E}, SOCD_NEUTRAL} for leaning, say). A key listed in more than
+ * one pair only answers to the first. */
+#    ifndef SOCD_PAIRS
+#        define SOCD_PAIRS                            \
+            {                                         \
+                {{KC_A, KC_D}, SOCD_LAST_WINS},       \
+                {{KC_W, KC_S}, SOCD_LAST_WINS},       \
+            }
+#    endif
+
+static const socd_pair_t socd_pairs[] = SOCD_PAIRS;
+
+#    define SOCD_PAIR_COUNT (sizeof(socd_pairs) / sizeof(socd_pairs[0]))
+_Static_assert(SOCD_PAIR_COUNT <= UINT8_MAX, "SOCD_PAIRS holds at most 255 pairs");
+
+/**
+ * @brief One axis, as three small sets
+ *
+ * Bit i of each set is the pair's keys[i]. Whatever the history of presses,
+ * this is all a policy needs to pick the winner.
+ */
+typedef struct {
+    uint8_t held; ///< Keys physically down
+    uint8_t last; ///< The key pressed most recently, as a bit
+    uint8_t sent; ///< The key registered with the host, as a bit, or 0
+} socd_axis_t;
+
+static socd_axis_t socd_axes[SOCD_PAIR_COUNT];
+
+#    define SOCD_BOTH 0x3
+
+/** The key (as a bit, or 0 for none) that @p axis should have registered. */
+static uint8_t socd_winner(socd_policy_t policy, const socd_axis_t *axis) {
+    if (axis->held != SOCD_BOTH) {
+        return axis->held;
+    }
+    switch (policy) {
+        case SOCD_LAST_WINS:
+            return axis->last;
+        case SOCD_FIRST_WINS:
+            return SOCD_BOTH & ~axis->last;
+        default:
+            return 0;
+    }
+}
+
+bool process_socd(uint16_t keycode, const keyrecord_t *record) {
+    for (uint8_t i = 0; i < SOCD_PAIR_COUNT; i++) {
+        const socd_pair_t *pair = &socd_pairs[i];
+        uint8_t            bit;
+        if (keycode == pair->keys[0]) {
+            bit = 0x1;
+        } else if (keycode == pair->keys[1]) {
+            bit = 0x2;
+        } else {
+            continue;
+        }
+
+        socd_axis_t *axis = &socd_axes[i];
+        if (record->event.pressed) {
+            axis->held |= bit;
+            axis->last = bit;
+        } else {
+            axis->held &= ~bit;
+        }
+
+        uint8_t winner = socd_winner(pair->policy, axis);
+        if (winner != axis->sent) {
+            /* Up before down: even for the length of one report, the host
+             * must not see both directions of the axis held. */
+            if (axis->sent != 0) {
+                unregister_code16(pair->keys[axis->sent >> 1]);
+            }
+            if (winner != 0) {
+                register_code16(pair->keys[winner >> 1]);
+            }
+            axis->sent = winner;
+        }
+        return false;
+    }
+    return true;
+}
+
+void socd_reset(void) {
+    for (uint8_t i = 0; i < SOCD_PAIR_COUNT; i++) {
+        socd_axes[i] = (socd_axis_t){0};
+    }
+}
+
+#endif // SOCD_DISABLE
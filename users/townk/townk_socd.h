@@ -0,0 +1,82 @@
+/* Copyright (C) 2025 Thiago Alves (https://github.com/townk)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file townk_socd.h
+ * @brief Opposite-direction key resolution (SOCD) for the game layers
+ *
+ * Holding A and D together asks a game to move left and right at once, and
+ * what it does with that differs from game to game. While the game layers are
+ * up, each configured pair of opposite keys is resolved here so that the host
+ * never sees both halves of an axis held: only the winner of the pair is
+ * registered, and the switch from one half to the other happens in the same
+ * event as the press or release that caused it -- the old key goes up, then
+ * the new one goes down. Keys outside the pairs are not touched.
+ *
+ * Which key wins while both are held is chosen per pair (socd_policy_t).
+ * Define SOCD_PAIRS in config.h to replace the default WASD pairs, or
+ * SOCD_DISABLE to send every game key unchanged.
+ *
+ * @author Thiago Alves
+ */
+
+#ifndef QMK_USERSPACE_TOWNK_SOCD_H
+#define QMK_USERSPACE_TOWNK_SOCD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "action.h"
+
+/** @brief What a pair sends while both of its keys are held */
+typedef enum {
+    SOCD_LAST_WINS,  ///< The key pressed last; releasing it brings the other back
+    SOCD_NEUTRAL,    ///< Neither key
+    SOCD_FIRST_WINS, ///< The key pressed first; the other waits for its release
+} socd_policy_t;
+
+/** @brief Two opposite keys and how to resolve them */
+typedef struct {
+    uint16_t      keys[2]; ///< The two halves of the axis
+    socd_policy_t policy;  ///< Which one wins while both are held
+} socd_pair_t;
+
+#ifndef SOCD_DISABLE
+
+/**
+ * @brief Resolve a game key against its opposite
+ *
+ * Call for the events game_mode_fast_path() takes, and return its result
+ * from process_record_user(). A key in a pair is registered and unregistered
+ * here, as its pair's policy says; a key in no pair is left to QMK.
+ *
+ * @param keycode The key's keycode
+ * @param record The key event
+ * @return false if the key belongs to a pair and was handled here
+ */
+bool process_socd(uint16_t keycode, const keyrecord_t *record);
+
+/** @brief Forget every held key, without sending anything */
+void socd_reset(void);
+
+#else
+
+#    define process_socd(keycode, record) true
+#    define socd_reset()
+
+#endif // SOCD_DISABLE
+
+#endif // QMK_USERSPACE_TOWNK_SOCD_H
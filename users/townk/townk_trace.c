@@ -0,0 +1,51 @@
+/* Copyright (C) 2025 Thiago Alves (https://github.com/townk)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file townk_trace.c
+ * @brief Flight recorder storage -- see townk_trace.h
+ *
+ * @author Thiago Alves
+ */
+
+#include "townk_trace.h"
+
+#ifdef TOWNK_TRACE_ENABLE
+
+_Static_assert((TOWNK_TRACE_SIZE & (TOWNK_TRACE_SIZE - 1)) == 0, "TOWNK_TRACE_SIZE must be a power of two");
+_Static_assert(TOWNK_TRACE_SIZE <= 32768, "TOWNK_TRACE_SIZE must fit the 16-bit sequence numbers twice over");
+
+townk_trace_entry_t townk_trace_ring[TOWNK_TRACE_SIZE];
+uint16_t            townk_trace_head = 0;
+
+bool townk_trace_read(uint16_t seq, townk_trace_entry_t *out) {
+    uint16_t age = townk_trace_head - seq; // 1 is the newest record
+    if (age == 0 || age > TOWNK_TRACE_SIZE) {
+        return false;
+    }
+
+    *out = townk_trace_ring[seq & (TOWNK_TRACE_SIZE - 1)];
+    return true;
+}
+
+void townk_trace_clear(void) {
+    for (uint16_t i = 0; i < TOWNK_TRACE_SIZE; i++) {
+        townk_trace_ring[i] = (townk_trace_entry_t){0};
+    }
+    townk_trace_head = 0;
+}
+
+#endif // TOWNK_TRACE_ENABLE
@@ -0,0 +1,117 @@
+/* Copyright (C) 2025 Thiago Alves (https://github.com/townk)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file townk_trace.h
+ * @brief Flight recorder: a RAM ring of the userspace's input decisions
+ *
+ * "I got a middle click out of nowhere" is unreproducible by nature. With
+ * TOWNK_TRACE_ENABLE defined, every decision that could explain one -- what
+ * role an MB_* key took and why, every modifier claim and release, every SM_TD
+ * action and every layer change -- is appended to a fixed ring of
+ * TOWNK_TRACE_SIZE eight-byte records, and the last few seconds before a
+ * report can be read back over raw HID (townk_hid.c) and decoded with
+ * `python3 tools/townk_hid.py trace`.
+ *
+ * Recording is an inline timer read and three stores, no branches. Without
+ * TOWNK_TRACE_ENABLE, TOWNK_TRACE() expands to nothing and the ring does not
+ * exist.
+ *
+ * @author Thiago Alves
+ */
+
+#ifndef QMK_USERSPACE_TOWNK_TRACE_H
+#define QMK_USERSPACE_TOWNK_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief What a record is about, and how to read its a/b fields
+ *
+ * Append only: tools/townk_hid.py decodes by number.
+ */
+typedef enum {
+    TOWNK_TRACE_NONE = 0,
+    TOWNK_TRACE_MB_PRESS,     ///< a = MB_KEYS index, b = role at press (townk_trace_role_t)
+    TOWNK_TRACE_MB_RESOLVE,   ///< a = role it resolved to, b = mask of MB_KEYS resolved
+    TOWNK_TRACE_MB_RELEASE,   ///< a = MB_KEYS index, b = role it released as
+    TOWNK_TRACE_MODS_ACQUIRE, ///< a = modifiers claimed, b = get_mods() after
+    TOWNK_TRACE_MODS_RELEASE, ///< a = modifiers released, b = get_mods() after
+    TOWNK_TRACE_SMTD_ACTION,  ///< a = action | tap_count << 4, b = keycode
+    TOWNK_TRACE_LAYER,        ///< a = highest layer, b = layer_state (low 16 bits)
+} townk_trace_type_t;
+
+/** The roles an MB_* key can be recorded taking. */
+typedef enum {
+    TOWNK_TRACE_ROLE_UNDECIDED = 0, ///< Pressed with nothing decided yet
+    TOWNK_TRACE_ROLE_CLICK,         ///< Released untouched: a click
+    TOWNK_TRACE_ROLE_MODIFIER,      ///< Earned its modifier (key, scroll, or mid-gesture)
+    TOWNK_TRACE_ROLE_DRAG,          ///< Pointer motion made it a held button
+    TOWNK_TRACE_ROLE_BUTTON,        ///< External modifiers made it a button at press
+} townk_trace_role_t;
+
+/** One record. townk_hid.c sends it as eight big-endian bytes. */
+typedef struct {
+    uint32_t time; ///< timer_read32() when recorded
+    uint8_t  type; ///< townk_trace_type_t
+    uint8_t  a;
+    uint16_t b;
+} townk_trace_entry_t;
+
+#ifdef TOWNK_TRACE_ENABLE
+
+#    include "timer.h"
+
+/** Records kept; a power of two no larger than 65536/2. */
+#    ifndef TOWNK_TRACE_SIZE
+#        define TOWNK_TRACE_SIZE 256
+#    endif
+
+extern townk_trace_entry_t townk_trace_ring[TOWNK_TRACE_SIZE];
+
+/** Records ever written, mod 2^16; the next one goes to this index. */
+extern uint16_t townk_trace_head;
+
+/** @brief Append one record, overwriting the oldest. */
+static inline void townk_trace_record(townk_trace_type_t type, uint8_t a, uint16_t b) {
+    townk_trace_entry_t *entry = &townk_trace_ring[townk_trace_head++ & (TOWNK_TRACE_SIZE - 1)];
+
+    entry->time = timer_read32();
+    entry->type = type;
+    entry->a    = a;
+    entry->b    = b;
+}
+
+/**
+ * @brief Copy out the record with sequence number @p seq, if still held
+ *
+ * Sequence numbers count every record ever written, mod 2^16; the ring holds
+ * the last TOWNK_TRACE_SIZE of them.
+ *
+ * @return false if that record has been overwritten or not written yet
+ */
+bool townk_trace_read(uint16_t seq, townk_trace_entry_t *out);
+
+/** @brief Forget every record. */
+void townk_trace_clear(void);
+
+#    define TOWNK_TRACE(type, a, b) townk_trace_record((type), (uint8_t)(a), (uint16_t)(b))
+#else
+#    define TOWNK_TRACE(type, a, b) ((void)0)
+#endif // TOWNK_TRACE_ENABLE
+
+#endif // QMK_USERSPACE_TOWNK_TRACE_H